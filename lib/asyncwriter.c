@@ -0,0 +1,543 @@
+// Buffered output to a number of files, where the actual writes are done by a separate writer thread. The thread that writes data only copies it into the
+// current chunk of the stream, and full chunks are handed over to the writer thread, which writes each one with a single fwrite and then returns it for reuse.
+// Only one thread at a time may call AsyncWriter_write
+//
+// All streams share one pool of chunks with a global memory limit. A stream starts with a chunk of min_chunk_size bytes, and each time its chunk fills up
+// the next one is twice as large, up to max_chunk_size, so streams that get little output never use more than a small chunk. When a new chunk would exceed
+// the memory limit, unused chunks of other sizes are freed and then smaller chunks are tried, and only if not even a chunk of min_chunk_size fits does
+// AsyncWriter_write wait for the writer thread to finish a chunk. If there is nothing to wait for, the limit is exceeded by one small chunk instead, which
+// can only happen if the limit is less than min_chunk_size times the number of streams
+//
+// The writer thread also keeps the number of bytes and a CRC-32 of everything written to each stream, which can be read after AsyncWriter_finish
+
+#define ASYNCWRITER_MAX_SIZE_CLASSES 24
+
+// Writes a full chunk of a stream that doesn't go directly to a file of its own. Called in the writer thread, and should return FALSE on a write error
+typedef int (*AsyncWriter_ChunkWriter) (void *context, s32 tag, const u8 *data, s32 size);
+
+typedef struct AsyncWriter_Chunk
+{
+	struct AsyncWriter_Chunk *next;
+	s32 stream_ix;
+	s32 size_class;
+	s32 used;
+	u8 data [];
+} AsyncWriter_Chunk;
+
+typedef struct
+{
+	FILE *file;
+	AsyncWriter_ChunkWriter chunk_writer;
+	void *context;
+	s32 tag;
+	int low_latency;
+	
+	AsyncWriter_Chunk *chunk;
+	s32 size_class;
+	
+	// Only updated by the writer thread
+	u64 byte_cnt;
+	u32 checksum;
+} AsyncWriter_Stream;
+
+typedef struct
+{
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t job_queued;
+	pthread_cond_t chunk_freed;
+	
+	s32 min_chunk_size;
+	s32 size_class_cnt;
+	s64 memory_limit;
+	s64 allocated_size;
+	
+	// Unused chunks, one list per size class. The chunks of size class n have room for (min_chunk_size << n) bytes
+	AsyncWriter_Chunk *free_chunk [ASYNCWRITER_MAX_SIZE_CLASSES];
+	
+	// Full chunks waiting to be written, oldest first, and the number of these plus the one being written
+	AsyncWriter_Chunk *first_job;
+	AsyncWriter_Chunk *last_job;
+	s32 unfinished_job_cnt;
+	
+	s32 max_stream_cnt;
+	s32 stream_cnt;
+	s32 low_latency_stream_cnt;
+	AsyncWriter_Stream *stream;
+	
+	int shutdown;
+	int finished;
+	int write_error;
+} AsyncWriter;
+
+// The CRC-32 of zip and gzip, with the reflected polynomial 0xedb88320
+static u32 AsyncWriter_crc_table [256];
+
+
+// Internal functions
+
+static __force_inline s32 AsyncWriter_int_chunk_capacity (const AsyncWriter *aw, s32 size_class)
+{
+	return aw->min_chunk_size << size_class;
+}
+
+static __force_inline s64 AsyncWriter_int_chunk_alloc_size (const AsyncWriter *aw, s32 size_class)
+{
+	return sizeof (AsyncWriter_Chunk) + AsyncWriter_int_chunk_capacity (aw, size_class);
+}
+
+// Takes the partially filled chunk of a low latency stream, if there is one. Must be called with the mutex held
+static __not_inline AsyncWriter_Chunk *AsyncWriter_int_take_low_latency_chunk (AsyncWriter *aw)
+{
+	if (aw->low_latency_stream_cnt == 0)
+		return NULL;
+	
+	s32 stream_ix;
+	for (stream_ix = 0; stream_ix < aw->stream_cnt; stream_ix++)
+	{
+		AsyncWriter_Stream *s = &aw->stream [stream_ix];
+		if (s->low_latency && s->chunk && s->chunk->used > 0)
+		{
+			AsyncWriter_Chunk *chunk = s->chunk;
+			s->chunk = NULL;
+			
+			chunk->stream_ix = stream_ix;
+			aw->unfinished_job_cnt++;
+			return chunk;
+		}
+	}
+	
+	return NULL;
+}
+
+static __not_inline void AsyncWriter_int_init_crc_table (void)
+{
+	u32 byte;
+	for (byte = 0; byte < 256; byte++)
+	{
+		u32 crc = byte;
+		s32 bit_ix;
+		for (bit_ix = 0; bit_ix < 8; bit_ix++)
+			crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320u : 0);
+		
+		AsyncWriter_crc_table [byte] = crc;
+	}
+}
+
+static __not_inline u32 AsyncWriter_int_update_crc (u32 crc, const u8 *data, s32 size)
+{
+	crc = ~crc;
+	
+	s32 byte_ix;
+	for (byte_ix = 0; byte_ix < size; byte_ix++)
+		crc = AsyncWriter_crc_table [(crc ^ data [byte_ix]) & 0xff] ^ (crc >> 8);
+	
+	return ~crc;
+}
+
+static __not_inline void *AsyncWriter_int_run (void *arg)
+{
+	AsyncWriter *aw = (AsyncWriter *) arg;
+	
+	pthread_mutex_lock (&aw->mutex);
+	while (TRUE)
+	{
+		AsyncWriter_Chunk *chunk;
+		while (TRUE)
+		{
+			chunk = aw->first_job;
+			if (chunk)
+			{
+				aw->first_job = chunk->next;
+				if (!aw->first_job)
+					aw->last_job = NULL;
+			}
+			else
+				chunk = AsyncWriter_int_take_low_latency_chunk (aw);
+			
+			if (chunk || aw->shutdown)
+				break;
+			
+			pthread_cond_wait (&aw->job_queued, &aw->mutex);
+		}
+		
+		if (!chunk)
+			break;
+		
+		pthread_mutex_unlock (&aw->mutex);
+		
+		AsyncWriter_Stream *s = &aw->stream [chunk->stream_ix];
+		s->byte_cnt += chunk->used;
+		s->checksum = AsyncWriter_int_update_crc (s->checksum, chunk->data, chunk->used);
+		
+		int success;
+		if (s->file)
+			success = (fwrite (chunk->data, 1, chunk->used, s->file) == (size_t) chunk->used && (!s->low_latency || fflush (s->file) == 0));
+		else
+			success = s->chunk_writer (s->context, s->tag, chunk->data, chunk->used);
+		
+		pthread_mutex_lock (&aw->mutex);
+		if (!success)
+			aw->write_error = TRUE;
+		
+		chunk->next = aw->free_chunk [chunk->size_class];
+		aw->free_chunk [chunk->size_class] = chunk;
+		aw->unfinished_job_cnt--;
+		pthread_cond_signal (&aw->chunk_freed);
+	}
+	
+	pthread_mutex_unlock (&aw->mutex);
+	return NULL;
+}
+
+// Frees unused chunks until there is room to allocate a chunk of size_class. Must be called with the mutex held
+static __not_inline int AsyncWriter_int_make_room (AsyncWriter *aw, s32 size_class)
+{
+	s64 needed_size = AsyncWriter_int_chunk_alloc_size (aw, size_class);
+	
+	s32 free_size_class;
+	for (free_size_class = 0; free_size_class < aw->size_class_cnt; free_size_class++)
+		while (aw->allocated_size + needed_size > aw->memory_limit && aw->free_chunk [free_size_class])
+		{
+			AsyncWriter_Chunk *chunk = aw->free_chunk [free_size_class];
+			aw->free_chunk [free_size_class] = chunk->next;
+			aw->allocated_size -= AsyncWriter_int_chunk_alloc_size (aw, free_size_class);
+			free (chunk);
+		}
+	
+	return (aw->allocated_size + needed_size <= aw->memory_limit);
+}
+
+static __not_inline AsyncWriter_Chunk *AsyncWriter_int_alloc_chunk (AsyncWriter *aw, s32 size_class)
+{
+	AsyncWriter_Chunk *chunk = malloc (AsyncWriter_int_chunk_alloc_size (aw, size_class));
+	if (!chunk)
+	{
+		fprintf (stderr, "Out of memory allocating output buffer\n");
+		exit (EXIT_FAILURE);
+	}
+	
+	chunk->size_class = size_class;
+	aw->allocated_size += AsyncWriter_int_chunk_alloc_size (aw, size_class);
+	return chunk;
+}
+
+// Gets a chunk of at most wanted_size_class, preferring a smaller chunk to waiting for the writer thread. Must be called with the mutex held
+static __not_inline AsyncWriter_Chunk *AsyncWriter_int_get_chunk (AsyncWriter *aw, s32 wanted_size_class)
+{
+	AsyncWriter_Chunk *chunk = NULL;
+	
+	while (!chunk)
+	{
+		s32 size_class;
+		for (size_class = wanted_size_class; size_class >= 0 && !chunk; size_class--)
+		{
+			if (aw->free_chunk [size_class])
+			{
+				chunk = aw->free_chunk [size_class];
+				aw->free_chunk [size_class] = chunk->next;
+			}
+			else if (AsyncWriter_int_make_room (aw, size_class))
+				chunk = AsyncWriter_int_alloc_chunk (aw, size_class);
+		}
+		
+		if (!chunk)
+		{
+			if (aw->unfinished_job_cnt > 0)
+				pthread_cond_wait (&aw->chunk_freed, &aw->mutex);
+			else
+				chunk = AsyncWriter_int_alloc_chunk (aw, 0);
+		}
+	}
+	
+	chunk->next = NULL;
+	chunk->used = 0;
+	return chunk;
+}
+
+// Must be called with the mutex held
+static __not_inline void AsyncWriter_int_queue_chunk_locked (AsyncWriter *aw, s32 stream_ix)
+{
+	AsyncWriter_Stream *s = &aw->stream [stream_ix];
+	AsyncWriter_Chunk *chunk = s->chunk;
+	if (!chunk)
+		return;
+	
+	if (chunk->used > 0)
+	{
+		chunk->stream_ix = stream_ix;
+		if (aw->last_job)
+			aw->last_job->next = chunk;
+		else
+			aw->first_job = chunk;
+		
+		aw->last_job = chunk;
+		aw->unfinished_job_cnt++;
+		pthread_cond_signal (&aw->job_queued);
+	}
+	else
+	{
+		chunk->next = aw->free_chunk [chunk->size_class];
+		aw->free_chunk [chunk->size_class] = chunk;
+	}
+	
+	s->chunk = NULL;
+}
+
+static __not_inline void AsyncWriter_int_queue_chunk (AsyncWriter *aw, s32 stream_ix)
+{
+	pthread_mutex_lock (&aw->mutex);
+	AsyncWriter_int_queue_chunk_locked (aw, stream_ix);
+	pthread_mutex_unlock (&aw->mutex);
+}
+
+// Low latency streams are filled with the mutex held, so that the writer thread can take a partially filled chunk whenever it is idle
+static __not_inline void AsyncWriter_int_write_low_latency (AsyncWriter *aw, s32 stream_ix, const u8 *src, s32 size)
+{
+	AsyncWriter_Stream *s = &aw->stream [stream_ix];
+	pthread_mutex_lock (&aw->mutex);
+	
+	while (size > 0)
+	{
+		if (!s->chunk)
+			s->chunk = AsyncWriter_int_get_chunk (aw, s->size_class);
+		
+		s32 capacity = AsyncWriter_int_chunk_capacity (aw, s->chunk->size_class);
+		s32 copy_size = (size < capacity - s->chunk->used ? size : capacity - s->chunk->used);
+		memcpy (s->chunk->data + s->chunk->used, src, copy_size);
+		s->chunk->used += copy_size;
+		src += copy_size;
+		size -= copy_size;
+		
+		if (s->chunk->used == capacity)
+		{
+			if (s->chunk->size_class + 1 < aw->size_class_cnt)
+				s->size_class = s->chunk->size_class + 1;
+			
+			AsyncWriter_int_queue_chunk_locked (aw, stream_ix);
+		}
+	}
+	
+	pthread_cond_signal (&aw->job_queued);
+	pthread_mutex_unlock (&aw->mutex);
+}
+
+static __not_inline void AsyncWriter_int_free (AsyncWriter *aw)
+{
+	s32 size_class;
+	for (size_class = 0; size_class < ASYNCWRITER_MAX_SIZE_CLASSES; size_class++)
+		while (aw->free_chunk [size_class])
+		{
+			AsyncWriter_Chunk *chunk = aw->free_chunk [size_class];
+			aw->free_chunk [size_class] = chunk->next;
+			free (chunk);
+		}
+	
+	free (aw->stream);
+	aw->stream = NULL;
+	aw->allocated_size = 0;
+}
+
+static __not_inline s32 AsyncWriter_int_add_stream (AsyncWriter *aw, FILE *file, AsyncWriter_ChunkWriter chunk_writer, void *context, s32 tag, int low_latency)
+{
+	pthread_mutex_lock (&aw->mutex);
+	
+	s32 stream_ix = -1;
+	if (aw->stream_cnt < aw->max_stream_cnt)
+	{
+		stream_ix = aw->stream_cnt;
+		aw->stream [stream_ix].file = file;
+		aw->stream [stream_ix].chunk_writer = chunk_writer;
+		aw->stream [stream_ix].context = context;
+		aw->stream [stream_ix].tag = tag;
+		aw->stream [stream_ix].low_latency = low_latency;
+		if (low_latency)
+			aw->low_latency_stream_cnt++;
+		aw->stream [stream_ix].chunk = NULL;
+		aw->stream [stream_ix].size_class = 0;
+		aw->stream [stream_ix].byte_cnt = 0;
+		aw->stream [stream_ix].checksum = 0;
+		aw->stream_cnt++;
+	}
+	
+	pthread_mutex_unlock (&aw->mutex);
+	return stream_ix;
+}
+
+
+// External functions
+
+// max_chunk_size must be min_chunk_size times a power of two. memory_limit applies to all chunks together, both those being filled and those waiting to be
+// written
+static __not_inline int AsyncWriter_create (AsyncWriter *aw, s32 max_stream_cnt, s32 min_chunk_size, s32 max_chunk_size, s64 memory_limit)
+{
+	if (!aw || max_stream_cnt <= 0 || min_chunk_size <= 0 || max_chunk_size < min_chunk_size || memory_limit <= 0)
+		return ffsc (__func__);
+	
+	memset (aw, 0, sizeof (AsyncWriter));
+	aw->min_chunk_size = min_chunk_size;
+	aw->memory_limit = memory_limit;
+	aw->max_stream_cnt = max_stream_cnt;
+	
+	aw->size_class_cnt = 1;
+	while (AsyncWriter_int_chunk_capacity (aw, aw->size_class_cnt - 1) < max_chunk_size)
+	{
+		if (aw->size_class_cnt == ASYNCWRITER_MAX_SIZE_CLASSES)
+			return ffsc (__func__);
+		
+		aw->size_class_cnt++;
+	}
+	
+	if (AsyncWriter_int_chunk_capacity (aw, aw->size_class_cnt - 1) != max_chunk_size)
+		return ffsc (__func__);
+	
+	aw->stream = malloc (max_stream_cnt * sizeof (AsyncWriter_Stream));
+	if (!aw->stream)
+		return FALSE;
+	
+	AsyncWriter_int_init_crc_table ();
+	
+	pthread_mutex_init (&aw->mutex, NULL);
+	pthread_cond_init (&aw->job_queued, NULL);
+	pthread_cond_init (&aw->chunk_freed, NULL);
+	
+	if (pthread_create (&aw->thread, NULL, AsyncWriter_int_run, aw) != 0)
+	{
+		AsyncWriter_int_free (aw);
+		return FALSE;
+	}
+	
+	return TRUE;
+}
+
+// The writer takes over the file, which is closed by AsyncWriter_close. Returns the index of the new stream, or -1 if there is no room for more streams
+static __not_inline s32 AsyncWriter_add_stream (AsyncWriter *aw, FILE *file)
+{
+	if (!aw || !file)
+	{
+		ffsc (__func__);
+		return -1;
+	}
+	
+	return AsyncWriter_int_add_stream (aw, file, NULL, NULL, 0, FALSE);
+}
+
+// Like AsyncWriter_add_stream, but for output that is read as it is written, like a pipe. Instead of waiting for a full chunk, the writer thread takes the data
+// as soon as it is idle, and the file is flushed after each write. While the reader is slow the writer thread is blocked, so the data is collected in larger
+// chunks, and once the memory limit is reached AsyncWriter_write blocks as well
+static __not_inline s32 AsyncWriter_add_low_latency_stream (AsyncWriter *aw, FILE *file)
+{
+	if (!aw || !file)
+	{
+		ffsc (__func__);
+		return -1;
+	}
+	
+	return AsyncWriter_int_add_stream (aw, file, NULL, NULL, 0, TRUE);
+}
+
+// Adds a stream where each full chunk is passed to chunk_writer together with context and tag, for example to let several streams share one file
+static __not_inline s32 AsyncWriter_add_custom_stream (AsyncWriter *aw, AsyncWriter_ChunkWriter chunk_writer, void *context, s32 tag)
+{
+	if (!aw || !chunk_writer)
+	{
+		ffsc (__func__);
+		return -1;
+	}
+	
+	return AsyncWriter_int_add_stream (aw, NULL, chunk_writer, context, tag, FALSE);
+}
+
+static __not_inline void AsyncWriter_write (AsyncWriter *aw, s32 stream_ix, const void *data, s32 size)
+{
+	if (!aw || stream_ix < 0 || stream_ix >= aw->stream_cnt || (!data && size > 0))
+		return (void) ffsc (__func__);
+	
+	AsyncWriter_Stream *s = &aw->stream [stream_ix];
+	const u8 *src = (const u8 *) data;
+	
+	if (s->low_latency)
+	{
+		AsyncWriter_int_write_low_latency (aw, stream_ix, src, size);
+		return;
+	}
+	
+	while (size > 0)
+	{
+		if (!s->chunk)
+		{
+			pthread_mutex_lock (&aw->mutex);
+			s->chunk = AsyncWriter_int_get_chunk (aw, s->size_class);
+			pthread_mutex_unlock (&aw->mutex);
+		}
+		
+		s32 capacity = AsyncWriter_int_chunk_capacity (aw, s->chunk->size_class);
+		s32 copy_size = (size < capacity - s->chunk->used ? size : capacity - s->chunk->used);
+		memcpy (s->chunk->data + s->chunk->used, src, copy_size);
+		s->chunk->used += copy_size;
+		src += copy_size;
+		size -= copy_size;
+		
+		// The stream filled a chunk, so it gets a larger one next time
+		if (s->chunk->used == capacity)
+		{
+			if (s->chunk->size_class + 1 < aw->size_class_cnt)
+				s->size_class = s->chunk->size_class + 1;
+			
+			AsyncWriter_int_queue_chunk (aw, stream_ix);
+		}
+	}
+}
+
+// Writes all remaining data and stops the writer thread, after which nothing more can be written. Returns FALSE if any write failed
+static __not_inline int AsyncWriter_finish (AsyncWriter *aw)
+{
+	if (!aw || !aw->stream)
+		return ffsc (__func__);
+	
+	if (!aw->finished)
+	{
+		s32 stream_ix;
+		for (stream_ix = 0; stream_ix < aw->stream_cnt; stream_ix++)
+			AsyncWriter_int_queue_chunk (aw, stream_ix);
+		
+		pthread_mutex_lock (&aw->mutex);
+		aw->shutdown = TRUE;
+		pthread_cond_signal (&aw->job_queued);
+		pthread_mutex_unlock (&aw->mutex);
+		
+		pthread_join (aw->thread, NULL);
+		aw->finished = TRUE;
+	}
+	
+	return !aw->write_error;
+}
+
+// Gets the number of bytes and the CRC-32 of all data written to a stream. Must be called after AsyncWriter_finish
+static __not_inline int AsyncWriter_get_checksum (const AsyncWriter *aw, s32 stream_ix, u64 *byte_cnt, u32 *checksum)
+{
+	if (!aw || !aw->finished || stream_ix < 0 || stream_ix >= aw->stream_cnt || !byte_cnt || !checksum)
+		return ffsc (__func__);
+	
+	*byte_cnt = aw->stream [stream_ix].byte_cnt;
+	*checksum = aw->stream [stream_ix].checksum;
+	return TRUE;
+}
+
+// Writes all remaining data if AsyncWriter_finish was not called, closes all files of streams added with AsyncWriter_add_stream and frees all memory. Returns
+// FALSE if any write failed
+static __not_inline int AsyncWriter_close (AsyncWriter *aw)
+{
+	if (!aw || !aw->stream)
+		return ffsc (__func__);
+	
+	int success = AsyncWriter_finish (aw);
+	
+	s32 stream_ix;
+	for (stream_ix = 0; stream_ix < aw->stream_cnt; stream_ix++)
+		if (aw->stream [stream_ix].file && fclose (aw->stream [stream_ix].file) != 0)
+			success = FALSE;
+	
+	AsyncWriter_int_free (aw);
+	return success;
+}
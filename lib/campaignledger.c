@@ -0,0 +1,535 @@
+// A campaign ledger keeps track of which work units of a long campaign of subset searches are done, running or failed, so that any number of processes on
+// one machine, or on several machines sharing the ledger directory on a file system that supports record locks, can each claim the next unit that needs to be searched, and a campaign survives reboots
+// without searching a unit twice or losing one. The ledger is a directory with these files:
+//
+//   campaign     the bit counts and the range of units, written once by CampaignLedger_create:
+//                  StillCount campaign <format version>
+//                  on_cells <min on-cells> <max on-cells>
+//                  units <first unit> <last unit>
+//                  end
+//   lock         an empty file, where byte 0 is locked while the ledger is read or changed, and byte 1 + n is locked by the process that runs unit n
+//   unit_<n>     the state of unit n (four digits), which is missing for a unit that was never claimed:
+//                  StillCount unit <format version>
+//                  state <running|done|failed>
+//                  attempts <number of times the unit was claimed>
+//                  started <seconds since 1970 when it was last claimed>
+//                  updated <seconds since 1970 when it was last changed>
+//                  host <host name> <process id>
+//                  end
+//
+// A unit file is never changed in place, but written to a temporary file that is synced to disk and then renamed over the old one, so it is always either
+// the old or the new state. A unit that says it is running, but whose byte in the lock file is not locked, belonged to a process that died or a machine
+// that was rebooted, and is claimed again like a unit that was never claimed. The locks are fcntl record locks, which are released by the system when the
+// process ends. They are per process, so a process must only have one unit claimed at a time
+//
+// Needs fcntl.h, sys/stat.h and unistd.h, or io.h, direct.h, process.h and sys/locking.h on Windows
+
+#define CAMPAIGNLEDGER_FORMAT_VERSION 1
+#define CAMPAIGNLEDGER_MAX_UNIT 9999
+#define CAMPAIGNLEDGER_MAX_PATH_SIZE 1024
+#define CAMPAIGNLEDGER_MAX_HOST_SIZE 64
+#define CAMPAIGNLEDGER_MAX_LINE_SIZE 256
+
+// A failed unit is claimed again until it has failed this many times, after which it needs a look by hand
+#define CAMPAIGNLEDGER_MAX_ATTEMPTS 3
+
+#define CAMPAIGNLEDGER_UNIT_NOT_STARTED 0
+#define CAMPAIGNLEDGER_UNIT_RUNNING 1
+#define CAMPAIGNLEDGER_UNIT_INTERRUPTED 2
+#define CAMPAIGNLEDGER_UNIT_DONE 3
+#define CAMPAIGNLEDGER_UNIT_FAILED 4
+#define CAMPAIGNLEDGER_UNIT_INVALID 5
+#define CAMPAIGNLEDGER_UNIT_STATE_CNT 6
+
+typedef struct
+{
+	s32 state;
+	s32 attempt_cnt;
+	s64 started;
+	s64 updated;
+	char host [CAMPAIGNLEDGER_MAX_HOST_SIZE];
+	s64 pid;
+} CampaignLedger_Unit;
+
+typedef struct
+{
+	char dir [CAMPAIGNLEDGER_MAX_PATH_SIZE];
+	s32 min_on_cnt;
+	s32 max_on_cnt;
+	s32 first_unit;
+	s32 last_unit;
+	
+	int lock_fd;
+	
+	// The unit this process has claimed, with its state as written to the ledger, or -1
+	s32 claimed_unit;
+	CampaignLedger_Unit claimed;
+} CampaignLedger;
+
+static const char *CampaignLedger_state_name [CAMPAIGNLEDGER_UNIT_STATE_CNT] = {"not started", "running", "interrupted", "done", "failed", "invalid"};
+
+
+// Internal functions
+
+static __not_inline int CampaignLedger_int_make_path (const char *dir, const char *name, char *path)
+{
+	if (strlen (dir) + strlen (name) + 2 > CAMPAIGNLEDGER_MAX_PATH_SIZE)
+		return FALSE;
+	
+	sprintf (path, "%s/%s", dir, name);
+	return TRUE;
+}
+
+static __not_inline void CampaignLedger_int_make_unit_name (s32 unit, const char *suffix, char *name)
+{
+	sprintf (name, "unit_%04d%s", unit, suffix);
+}
+
+// Locks one byte of the lock file, waiting for another process to release it if wait is set. Returns FALSE if the byte is locked by another process and
+// wait is not set, or on an error
+static __not_inline int CampaignLedger_int_lock (int fd, s32 byte_ix, int wait)
+{
+#ifdef _WIN32
+	// _LK_LOCK only tries for about ten seconds before it gives up
+	while (TRUE)
+	{
+		if (_lseek (fd, byte_ix, SEEK_SET) < 0)
+			return FALSE;
+		if (_locking (fd, (wait ? _LK_LOCK : _LK_NBLCK), 1) == 0)
+			return TRUE;
+		if (!wait || errno != EDEADLOCK)
+			return FALSE;
+	}
+#else
+	struct flock fl;
+	memset (&fl, 0, sizeof (fl));
+	fl.l_type = F_WRLCK;
+	fl.l_whence = SEEK_SET;
+	fl.l_start = byte_ix;
+	fl.l_len = 1;
+	
+	while (fcntl (fd, (wait ? F_SETLKW : F_SETLK), &fl) != 0)
+		if (errno != EINTR)
+			return FALSE;
+	
+	return TRUE;
+#endif
+}
+
+static __not_inline void CampaignLedger_int_unlock (int fd, s32 byte_ix)
+{
+#ifdef _WIN32
+	if (_lseek (fd, byte_ix, SEEK_SET) >= 0)
+		_locking (fd, _LK_UNLCK, 1);
+#else
+	struct flock fl;
+	memset (&fl, 0, sizeof (fl));
+	fl.l_type = F_UNLCK;
+	fl.l_whence = SEEK_SET;
+	fl.l_start = byte_ix;
+	fl.l_len = 1;
+	
+	fcntl (fd, F_SETLK, &fl);
+#endif
+}
+
+// Tells if another process has locked a byte of the lock file, without locking it
+static __not_inline int CampaignLedger_int_is_locked (int fd, s32 byte_ix)
+{
+#ifdef _WIN32
+	if (!CampaignLedger_int_lock (fd, byte_ix, FALSE))
+		return TRUE;
+	
+	CampaignLedger_int_unlock (fd, byte_ix);
+	return FALSE;
+#else
+	struct flock fl;
+	memset (&fl, 0, sizeof (fl));
+	fl.l_type = F_WRLCK;
+	fl.l_whence = SEEK_SET;
+	fl.l_start = byte_ix;
+	fl.l_len = 1;
+	
+	if (fcntl (fd, F_GETLK, &fl) != 0)
+		return FALSE;
+	
+	return (fl.l_type != F_UNLCK);
+#endif
+}
+
+static __not_inline int CampaignLedger_int_open_lock_file (const char *dir)
+{
+	char path [CAMPAIGNLEDGER_MAX_PATH_SIZE];
+	if (!CampaignLedger_int_make_path (dir, "lock", path))
+		return -1;
+	
+	return open (path, O_RDWR | O_CREAT, 0666);
+}
+
+static __not_inline void CampaignLedger_int_get_host (char *host, s64 *pid)
+{
+#ifdef _WIN32
+	const char *name = getenv ("COMPUTERNAME");
+	*pid = _getpid ();
+#else
+	char name_buf [CAMPAIGNLEDGER_MAX_HOST_SIZE];
+	if (gethostname (name_buf, CAMPAIGNLEDGER_MAX_HOST_SIZE) != 0)
+		name_buf [0] = '\0';
+	
+	name_buf [CAMPAIGNLEDGER_MAX_HOST_SIZE - 1] = '\0';
+	const char *name = name_buf;
+	*pid = getpid ();
+#endif
+	
+	// The host name is one word on its line of the unit file
+	s32 char_ix = 0;
+	if (name)
+		for (; name [char_ix] != '\0' && char_ix < CAMPAIGNLEDGER_MAX_HOST_SIZE - 1; char_ix++)
+			host [char_ix] = ((name [char_ix] > ' ' && name [char_ix] <= '~') ? name [char_ix] : '_');
+	
+	if (char_ix == 0)
+		host [char_ix++] = '-';
+	
+	host [char_ix] = '\0';
+}
+
+// Makes sure that the files created, renamed or removed in a directory are on disk. Does nothing on Windows, where this is not needed
+static __not_inline int CampaignLedger_int_sync_dir (const char *dir)
+{
+#ifdef _WIN32
+	return TRUE;
+#else
+	int fd = open (dir, O_RDONLY);
+	if (fd < 0)
+		return FALSE;
+	
+	int success = (fsync (fd) == 0);
+	if (close (fd) != 0)
+		success = FALSE;
+	
+	return success;
+#endif
+}
+
+// Writes everything in the stream to disk and closes it. Returns FALSE on a write error
+static __not_inline int CampaignLedger_int_sync_and_close (FILE *f)
+{
+	int success = (fflush (f) == 0 && ferror (f) == 0);
+	
+#ifdef _WIN32
+	if (success && _commit (_fileno (f)) != 0)
+		success = FALSE;
+#else
+	if (success && fsync (fileno (f)) != 0)
+		success = FALSE;
+#endif
+	
+	if (fclose (f) != 0)
+		success = FALSE;
+	
+	return success;
+}
+
+// Writes a file of the ledger through a temporary file, so that it is replaced in one step, and makes sure the new file is on disk before returning
+static __not_inline int CampaignLedger_int_replace_file (const char *dir, const char *name, const char *text)
+{
+	char path [CAMPAIGNLEDGER_MAX_PATH_SIZE];
+	char temp_path [CAMPAIGNLEDGER_MAX_PATH_SIZE];
+	char temp_name [64];
+	
+	sprintf (temp_name, "%s.tmp", name);
+	if (!CampaignLedger_int_make_path (dir, name, path) || !CampaignLedger_int_make_path (dir, temp_name, temp_path))
+		return FALSE;
+	
+	FILE *f = fopen (temp_path, "w");
+	if (!f)
+		return FALSE;
+	
+	fputs (text, f);
+	if (!CampaignLedger_int_sync_and_close (f))
+	{
+		remove (temp_path);
+		return FALSE;
+	}
+	
+#ifdef _WIN32
+	// rename doesn't replace an existing file on Windows. The unit files are only changed while the ledger is locked, so the missing file is never seen
+	remove (path);
+#endif
+	
+	if (rename (temp_path, path) != 0)
+		return FALSE;
+	
+	return CampaignLedger_int_sync_dir (dir);
+}
+
+static __not_inline int CampaignLedger_int_write_unit (const CampaignLedger *cl, s32 unit, const CampaignLedger_Unit *u)
+{
+	static const char *state_keyword [CAMPAIGNLEDGER_UNIT_STATE_CNT] = {"", "running", "", "done", "failed", ""};
+	
+	char text [6 * CAMPAIGNLEDGER_MAX_LINE_SIZE];
+	sprintf (text, "StillCount unit %d\nstate %s\nattempts %d\nstarted %" PRIi64 "\nupdated %" PRIi64 "\nhost %s %" PRIi64 "\nend\n", CAMPAIGNLEDGER_FORMAT_VERSION,
+			state_keyword [u->state], u->attempt_cnt, u->started, u->updated, u->host, u->pid);
+	
+	char name [64];
+	CampaignLedger_int_make_unit_name (unit, "", name);
+	return CampaignLedger_int_replace_file (cl->dir, name, text);
+}
+
+// Reads the state in the unit file, without looking at the lock. A missing file is a unit that was never claimed, and a file that can't be read is invalid
+static __not_inline void CampaignLedger_int_read_unit (const CampaignLedger *cl, s32 unit, CampaignLedger_Unit *u)
+{
+	memset (u, 0, sizeof (CampaignLedger_Unit));
+	u->state = CAMPAIGNLEDGER_UNIT_NOT_STARTED;
+	strcpy (u->host, "-");
+	
+	char name [64];
+	char path [CAMPAIGNLEDGER_MAX_PATH_SIZE];
+	CampaignLedger_int_make_unit_name (unit, "", name);
+	if (!CampaignLedger_int_make_path (cl->dir, name, path))
+		return;
+	
+	FILE *f = fopen (path, "r");
+	if (!f)
+		return;
+	
+	u->state = CAMPAIGNLEDGER_UNIT_INVALID;
+	
+	char line [CAMPAIGNLEDGER_MAX_LINE_SIZE];
+	char word [CAMPAIGNLEDGER_MAX_LINE_SIZE];
+	int version = 0;
+	s32 state = CAMPAIGNLEDGER_UNIT_INVALID;
+	int seen_end = FALSE;
+	
+	while (!seen_end && fgets (line, CAMPAIGNLEDGER_MAX_LINE_SIZE, f))
+	{
+		if (sscanf (line, "StillCount unit %d", &version) == 1)
+			continue;
+		else if (sscanf (line, "state %s", word) == 1)
+		{
+			if (strcmp (word, "running") == 0)
+				state = CAMPAIGNLEDGER_UNIT_RUNNING;
+			else if (strcmp (word, "done") == 0)
+				state = CAMPAIGNLEDGER_UNIT_DONE;
+			else if (strcmp (word, "failed") == 0)
+				state = CAMPAIGNLEDGER_UNIT_FAILED;
+		}
+		else if (sscanf (line, "attempts %d", &u->attempt_cnt) == 1 || sscanf (line, "started %" SCNi64, &u->started) == 1 ||
+				sscanf (line, "updated %" SCNi64, &u->updated) == 1 || sscanf (line, "host %63s %" SCNi64, u->host, &u->pid) == 2)
+			continue;
+		else if (strcmp (line, "end\n") == 0)
+			seen_end = TRUE;
+		else
+			break;
+	}
+	
+	fclose (f);
+	
+	if (seen_end && version == CAMPAIGNLEDGER_FORMAT_VERSION)
+		u->state = state;
+}
+
+
+// External functions
+
+// Makes sure that the files created, renamed or removed in a directory are on disk
+static __not_inline int CampaignLedger_sync_dir (const char *dir)
+{
+	if (!dir)
+		return ffsc (__func__);
+	
+	return CampaignLedger_int_sync_dir (dir);
+}
+
+// Makes sure that an output file that was already written and closed is on disk
+static __not_inline int CampaignLedger_sync_file (const char *filename)
+{
+	if (!filename)
+		return ffsc (__func__);
+	
+	FILE *f = fopen (filename, "rb");
+	if (!f)
+		return FALSE;
+	
+	return CampaignLedger_int_sync_and_close (f);
+}
+
+// Creates the ledger directory if it doesn't exist and starts a campaign in it, which must not already have one. Returns FALSE on an error
+static __not_inline int CampaignLedger_create (const char *dir, s32 min_on_cnt, s32 max_on_cnt, s32 first_unit, s32 last_unit)
+{
+	if (!dir || min_on_cnt < 0 || min_on_cnt > max_on_cnt || first_unit < 0 || first_unit > last_unit || last_unit > CAMPAIGNLEDGER_MAX_UNIT)
+		return ffsc (__func__);
+	
+	char path [CAMPAIGNLEDGER_MAX_PATH_SIZE];
+	if (!CampaignLedger_int_make_path (dir, "campaign", path))
+		return FALSE;
+		
+#ifdef _WIN32
+	_mkdir (dir);
+#else
+	mkdir (dir, 0777);
+#endif
+	
+	FILE *f = fopen (path, "r");
+	if (f)
+	{
+		fclose (f);
+		return FALSE;
+	}
+	
+	int fd = CampaignLedger_int_open_lock_file (dir);
+	if (fd < 0)
+		return FALSE;
+	
+	close (fd);
+	
+	char text [4 * CAMPAIGNLEDGER_MAX_LINE_SIZE];
+	sprintf (text, "StillCount campaign %d\non_cells %d %d\nunits %d %d\nend\n", CAMPAIGNLEDGER_FORMAT_VERSION, min_on_cnt, max_on_cnt, first_unit, last_unit);
+	return CampaignLedger_int_replace_file (dir, "campaign", text);
+}
+
+// Returns FALSE if dir has no campaign that can be read, or if the lock file can't be opened
+static __not_inline int CampaignLedger_open (CampaignLedger *cl, const char *dir)
+{
+	if (!cl || !dir)
+		return ffsc (__func__);
+	
+	memset (cl, 0, sizeof (CampaignLedger));
+	cl->lock_fd = -1;
+	cl->claimed_unit = -1;
+	
+	char path [CAMPAIGNLEDGER_MAX_PATH_SIZE];
+	if (!CampaignLedger_int_make_path (dir, "campaign", path))
+		return FALSE;
+	
+	strcpy (cl->dir, dir);
+	
+	FILE *f = fopen (path, "r");
+	if (!f)
+		return FALSE;
+	
+	char line [CAMPAIGNLEDGER_MAX_LINE_SIZE];
+	int version = 0;
+	s32 value_cnt = 0;
+	int seen_end = FALSE;
+	
+	while (!seen_end && fgets (line, CAMPAIGNLEDGER_MAX_LINE_SIZE, f))
+	{
+		if (sscanf (line, "StillCount campaign %d", &version) == 1)
+			continue;
+		else if (sscanf (line, "on_cells %d %d", &cl->min_on_cnt, &cl->max_on_cnt) == 2 || sscanf (line, "units %d %d", &cl->first_unit, &cl->last_unit) == 2)
+			value_cnt++;
+		else if (strcmp (line, "end\n") == 0)
+			seen_end = TRUE;
+		else
+			break;
+	}
+	
+	fclose (f);
+	
+	if (!seen_end || version != CAMPAIGNLEDGER_FORMAT_VERSION || value_cnt != 2 || cl->min_on_cnt < 0 || cl->min_on_cnt > cl->max_on_cnt ||
+			cl->first_unit < 0 || cl->first_unit > cl->last_unit || cl->last_unit > CAMPAIGNLEDGER_MAX_UNIT)
+		return FALSE;
+	
+	cl->lock_fd = CampaignLedger_int_open_lock_file (dir);
+	return (cl->lock_fd >= 0);
+}
+
+// A unit that is still claimed is left as running, and is claimed again by the next process once this one has ended
+static __not_inline void CampaignLedger_close (CampaignLedger *cl)
+{
+	if (!cl)
+		return (void) ffsc (__func__);
+	
+	if (cl->lock_fd >= 0)
+		close (cl->lock_fd);
+	
+	cl->lock_fd = -1;
+	cl->claimed_unit = -1;
+}
+
+// Gets the state of a unit, where a running unit without a process is returned as interrupted. The state may change as soon as this returns
+static __not_inline int CampaignLedger_get_unit (CampaignLedger *cl, s32 unit, CampaignLedger_Unit *u)
+{
+	if (!cl || cl->lock_fd < 0 || unit < cl->first_unit || unit > cl->last_unit || !u)
+		return ffsc (__func__);
+	
+	CampaignLedger_int_read_unit (cl, unit, u);
+	if (u->state == CAMPAIGNLEDGER_UNIT_RUNNING && unit != cl->claimed_unit && !CampaignLedger_int_is_locked (cl->lock_fd, 1 + unit))
+		u->state = CAMPAIGNLEDGER_UNIT_INTERRUPTED;
+	
+	return TRUE;
+}
+
+// Claims the lowest unit that is not done, not running in another process, and hasn't failed CAMPAIGNLEDGER_MAX_ATTEMPTS times, and marks it as running.
+// *unit is set to -1 if there is no such unit. Returns FALSE on an error, which leaves no unit claimed
+static __not_inline int CampaignLedger_claim (CampaignLedger *cl, s32 *unit)
+{
+	if (unit)
+		*unit = -1;
+	
+	if (!cl || cl->lock_fd < 0 || cl->claimed_unit >= 0 || !unit)
+		return ffsc (__func__);
+	
+	if (!CampaignLedger_int_lock (cl->lock_fd, 0, TRUE))
+		return FALSE;
+	
+	int success = TRUE;
+	s32 unit_ix;
+	for (unit_ix = cl->first_unit; unit_ix <= cl->last_unit; unit_ix++)
+	{
+		CampaignLedger_Unit u;
+		CampaignLedger_int_read_unit (cl, unit_ix, &u);
+		
+		if (u.state == CAMPAIGNLEDGER_UNIT_DONE || (u.state == CAMPAIGNLEDGER_UNIT_FAILED && u.attempt_cnt >= CAMPAIGNLEDGER_MAX_ATTEMPTS))
+			continue;
+		
+		// Fails for a unit that another process is running
+		if (!CampaignLedger_int_lock (cl->lock_fd, 1 + unit_ix, FALSE))
+			continue;
+		
+		u.state = CAMPAIGNLEDGER_UNIT_RUNNING;
+		u.attempt_cnt++;
+		u.started = (s64) time (NULL);
+		u.updated = u.started;
+		CampaignLedger_int_get_host (u.host, &u.pid);
+		
+		success = CampaignLedger_int_write_unit (cl, unit_ix, &u);
+		if (!success)
+		{
+			CampaignLedger_int_unlock (cl->lock_fd, 1 + unit_ix);
+			break;
+		}
+		
+		cl->claimed_unit = unit_ix;
+		cl->claimed = u;
+		*unit = unit_ix;
+		break;
+	}
+	
+	CampaignLedger_int_unlock (cl->lock_fd, 0);
+	return success;
+}
+
+// Marks the claimed unit as done or failed. Everything the unit wrote must already be on disk when it is marked as done. Returns FALSE on an error, in
+// which case the unit is claimed again by another process once this one has ended
+static __not_inline int CampaignLedger_finish (CampaignLedger *cl, int is_done)
+{
+	if (!cl || cl->lock_fd < 0 || cl->claimed_unit < 0)
+		return ffsc (__func__);
+	
+	if (!CampaignLedger_int_lock (cl->lock_fd, 0, TRUE))
+		return FALSE;
+	
+	CampaignLedger_Unit *u = &cl->claimed;
+	u->state = (is_done ? CAMPAIGNLEDGER_UNIT_DONE : CAMPAIGNLEDGER_UNIT_FAILED);
+	u->updated = (s64) time (NULL);
+	
+	int success = CampaignLedger_int_write_unit (cl, cl->claimed_unit, u);
+	
+	CampaignLedger_int_unlock (cl->lock_fd, 1 + cl->claimed_unit);
+	CampaignLedger_int_unlock (cl->lock_fd, 0);
+	cl->claimed_unit = -1;
+	
+	return success;
+}
@@ -175,6 +175,344 @@ static __not_inline void GoLGrid_print_life_history_full (FILE *stream, const Re
 	fprintf (stream, "!\n");
 }
 
+static __force_inline s32 GoLGrid_int_put_life_history_symbol (char *buf, char symbol, s32 count, s32 max_line_length, s32 *line_length)
+{
+	s32 size = 0;
+	if (count > 1)
+	{
+		char digits [10];
+		s32 digit_cnt = 0;
+		while (count > 0)
+		{
+			digits [digit_cnt++] = '0' + (count % 10);
+			count /= 10;
+		}
+		
+		while (digit_cnt > 0)
+			buf [size++] = digits [--digit_cnt];
+	}
+	
+	buf [size++] = symbol;
+	(*line_length) += size;
+	
+	if (*line_length > max_line_length)
+	{
+		buf [size++] = '\n';
+		(*line_length) = 0;
+	}
+	
+	return size;
+}
+
+// Produces exactly the same text as GoLGrid_print_life_history_full with only on_gg, but works on whole row words of a 64 bit wide grid and writes to buf instead
+// of a stream. Each run is found by counting the leading zeros or ones of the rest of the row word. print_rect must be inside the grid. Returns the size of the
+// text, which is not null terminated, or 0 if it doesn't fit in buf_size bytes
+static __not_inline s32 GoLGrid_print_life_history_to_buffer_64_wide (const GoLGrid *gg, const Rect *print_rect, int include_header, s32 max_line_length, char *buf, s32 buf_size)
+{
+	if (!gg || !gg->grid || gg->grid_rect.width != 64 || !print_rect || print_rect->width < 0 || print_rect->height < 0 || print_rect->left_x < gg->grid_rect.left_x ||
+			print_rect->left_x + print_rect->width > gg->grid_rect.left_x + 64 || print_rect->top_y < gg->grid_rect.top_y ||
+			print_rect->top_y + print_rect->height > gg->grid_rect.top_y + gg->grid_rect.height || !buf)
+		return ffsc (__func__);
+	
+	// Every symbol written takes at most 10 digits, the symbol itself and a newline
+	const s32 max_symbol_size = 12;
+	s32 size = 0;
+	
+	if (include_header)
+	{
+		char header [64];
+		s32 header_size = sprintf (header, "x = %d, y = %d, rule = LifeHistory\n", print_rect->width, print_rect->height);
+		if (header_size >= buf_size)
+			return 0;
+		
+		memcpy (buf, header, header_size);
+		size = header_size;
+	}
+	
+	s32 line_length = 0;
+	s32 unwritten_newline_count = 0;
+	
+	s32 left_x = print_rect->left_x - gg->grid_rect.left_x;
+	u64 row_mask = (print_rect->width == 64 ? u64_MAX : ~(u64_MAX >> print_rect->width));
+	
+	s32 row_ix;
+	for (row_ix = print_rect->top_y - gg->grid_rect.top_y; row_ix < print_rect->top_y - gg->grid_rect.top_y + print_rect->height; row_ix++)
+	{
+		u64 word = (gg->grid [row_ix] << left_x) & row_mask;
+		
+		if (word != 0 && unwritten_newline_count > 0)
+		{
+			if (size + max_symbol_size > buf_size)
+				return 0;
+			
+			size += GoLGrid_int_put_life_history_symbol (buf + size, '$', unwritten_newline_count, max_line_length, &line_length);
+			unwritten_newline_count = 0;
+		}
+		
+		while (word != 0)
+		{
+			if (size + (2 * max_symbol_size) > buf_size)
+				return 0;
+			
+			s32 off_cnt = 63 - most_significant_bit_u64 (word);
+			if (off_cnt > 0)
+			{
+				size += GoLGrid_int_put_life_history_symbol (buf + size, '.', off_cnt, max_line_length, &line_length);
+				word <<= off_cnt;
+			}
+			
+			u64 inverted_word = ~word;
+			s32 on_cnt = (inverted_word == 0 ? 64 : 63 - most_significant_bit_u64 (inverted_word));
+			size += GoLGrid_int_put_life_history_symbol (buf + size, 'A', on_cnt, max_line_length, &line_length);
+			word = (on_cnt == 64 ? 0 : word << on_cnt);
+		}
+		
+		unwritten_newline_count++;
+	}
+	
+	if (size + 2 > buf_size)
+		return 0;
+	
+	buf [size++] = '!';
+	buf [size++] = '\n';
+	
+	return size;
+}
+
+// Writes the extended Wechsler code of a pattern whose rows are aligned so that the leftmost column is the most significant bit, reading row_cnt rows with a
+// step of row_step. Each strip of five rows is scanned one column at a time, but columns without on-cells are skipped by counting leading zeros of the OR of the
+// strip. buf must have room for 4 * 64 bytes for each strip
+static __not_inline s32 GoLGrid_int_make_wechsler_code (const u64 *row, s32 row_step, s32 row_cnt, char *buf)
+{
+	static const char *symbol = "0123456789abcdefghijklmnopqrstuvwxyz";
+	s32 size = 0;
+	
+	s32 strip_y;
+	for (strip_y = 0; strip_y < row_cnt; strip_y += 5)
+	{
+		if (strip_y > 0)
+			buf [size++] = 'z';
+		
+		u64 strip_row [5];
+		u64 or_of_strip = 0;
+		
+		s32 row_ix;
+		for (row_ix = 0; row_ix < 5; row_ix++)
+		{
+			strip_row [row_ix] = (strip_y + row_ix < row_cnt ? row [(strip_y + row_ix) * row_step] : 0);
+			or_of_strip |= strip_row [row_ix];
+		}
+		
+		s32 next_x = 0;
+		while (or_of_strip != 0)
+		{
+			s32 bit_ix = most_significant_bit_u64 (or_of_strip);
+			s32 zero_cnt = (63 - bit_ix) - next_x;
+			
+			while (zero_cnt > 39)
+			{
+				buf [size++] = 'y';
+				buf [size++] = 'z';
+				zero_cnt -= 39;
+			}
+			
+			if (zero_cnt == 1)
+				buf [size++] = '0';
+			else if (zero_cnt == 2)
+				buf [size++] = 'w';
+			else if (zero_cnt == 3)
+				buf [size++] = 'x';
+			else if (zero_cnt >= 4)
+			{
+				buf [size++] = 'y';
+				buf [size++] = symbol [zero_cnt - 4];
+			}
+			
+			u32 column = 0;
+			for (row_ix = 0; row_ix < 5; row_ix++)
+				column |= ((strip_row [row_ix] >> bit_ix) & 1) << row_ix;
+			
+			buf [size++] = symbol [column];
+			or_of_strip &= ~(((u64) 1) << bit_ix);
+			next_x = 64 - bit_ix;
+		}
+	}
+	
+	return size;
+}
+
+// Keeps the code in candidate if it is shorter than the one in best, or as long and lower in ASCII order
+static __force_inline void GoLGrid_int_keep_best_wechsler_code (char *best, s32 *best_size, const char *candidate, s32 candidate_size)
+{
+	if (*best_size < 0 || candidate_size < *best_size || (candidate_size == *best_size && memcmp (candidate, best, candidate_size) < 0))
+	{
+		memcpy (best, candidate, candidate_size);
+		*best_size = candidate_size;
+	}
+}
+
+// Writes the apgcode of a still life in a 64 bit wide grid, which is "xs" followed by the population, an underscore and the extended Wechsler code of the
+// orientation that gives the shortest code, with ties broken by the code that is lowest in ASCII order, exactly like apgsearch. A newline is added. The
+// population rectangle must be up to date and at most 64 rows high. Returns the size of the text, which is not null terminated, or 0 if it doesn't fit in
+// buf_size bytes
+static __not_inline s32 GoLGrid_print_still_life_apgcode_to_buffer_64_wide (const GoLGrid *gg, char *buf, s32 buf_size)
+{
+	if (!gg || !gg->grid || gg->grid_rect.width != 64 || gg->pop_y_off - gg->pop_y_on > 64 || !buf)
+		return ffsc (__func__);
+	
+	u64 org [64];
+	u64 org_flipped [64];
+	u64 trans [64];
+	u64 trans_flipped [64];
+	char best [13 * 4 * 64];
+	char candidate [13 * 4 * 64];
+	s32 best_size = -1;
+	
+	s32 width = gg->pop_x_off - gg->pop_x_on;
+	s32 height = gg->pop_y_off - gg->pop_y_on;
+	if (width <= 0)
+	{
+		if (buf_size < 6)
+			return 0;
+		
+		memcpy (buf, "xs0_0\n", 6);
+		return 6;
+	}
+	
+	s32 population = 0;
+	s32 row_ix;
+	for (row_ix = 0; row_ix < height; row_ix++)
+	{
+		org [row_ix] = gg->grid [gg->pop_y_on + row_ix] << gg->pop_x_on;
+		org_flipped [row_ix] = bit_reverse_u64 (org [row_ix]) << (64 - width);
+		population += bit_count_u64 (org [row_ix]);
+	}
+	
+	GoLGrid_int_keep_best_wechsler_code (best, &best_size, candidate, GoLGrid_int_make_wechsler_code (org, 1, height, candidate));
+	GoLGrid_int_keep_best_wechsler_code (best, &best_size, candidate, GoLGrid_int_make_wechsler_code (org + (height - 1), -1, height, candidate));
+	GoLGrid_int_keep_best_wechsler_code (best, &best_size, candidate, GoLGrid_int_make_wechsler_code (org_flipped, 1, height, candidate));
+	GoLGrid_int_keep_best_wechsler_code (best, &best_size, candidate, GoLGrid_int_make_wechsler_code (org_flipped + (height - 1), -1, height, candidate));
+	
+	// The transposed pattern is made 16 by 16 cells at a time, so both org and trans are padded to whole blocks
+	s32 side = (width > height ? width : height);
+	s32 block_cnt = (side + 15) >> 4;
+	for (row_ix = 0; row_ix < (block_cnt << 4); row_ix++)
+	{
+		if (row_ix >= height)
+			org [row_ix] = 0;
+		trans [row_ix] = 0;
+	}
+	
+	s32 y_block_ix;
+	s32 x_block_ix;
+	for (y_block_ix = 0; y_block_ix < block_cnt; y_block_ix++)
+		for (x_block_ix = 0; x_block_ix < block_cnt; x_block_ix++)
+		{
+			u64 word_0;
+			u64 word_1;
+			u64 word_2;
+			u64 word_3;
+			
+			GoLGrid_int_fetch_16_by_16_block (org + (y_block_ix << 4), x_block_ix, &word_0, &word_1, &word_2, &word_3);
+			GoLGrid_int_flip_diagonally_16_by_16_block (&word_0, &word_1, &word_2, &word_3);
+			GoLGrid_int_write_16_by_16_block (word_0, word_1, word_2, word_3, trans + (x_block_ix << 4), y_block_ix);
+		}
+	
+	for (row_ix = 0; row_ix < width; row_ix++)
+		trans_flipped [row_ix] = bit_reverse_u64 (trans [row_ix]) << (64 - height);
+	
+	GoLGrid_int_keep_best_wechsler_code (best, &best_size, candidate, GoLGrid_int_make_wechsler_code (trans, 1, width, candidate));
+	GoLGrid_int_keep_best_wechsler_code (best, &best_size, candidate, GoLGrid_int_make_wechsler_code (trans + (width - 1), -1, width, candidate));
+	GoLGrid_int_keep_best_wechsler_code (best, &best_size, candidate, GoLGrid_int_make_wechsler_code (trans_flipped, 1, width, candidate));
+	GoLGrid_int_keep_best_wechsler_code (best, &best_size, candidate, GoLGrid_int_make_wechsler_code (trans_flipped + (width - 1), -1, width, candidate));
+	
+	char prefix [16];
+	s32 prefix_size = sprintf (prefix, "xs%d_", population);
+	if (prefix_size + best_size + 1 > buf_size)
+		return 0;
+	
+	memcpy (buf, prefix, prefix_size);
+	memcpy (buf + prefix_size, best, best_size);
+	buf [prefix_size + best_size] = '\n';
+	
+	return prefix_size + best_size + 1;
+}
+
+// Parses an apgcode as written by GoLGrid_print_still_life_apgcode_to_buffer_64_wide, with the top-left corner of the extended Wechsler code at (left_x, top_y).
+// The code ends at the first character that can't be part of it. The population after "xs" is not checked against the cells. Returns FALSE if the code is
+// invalid or doesn't fit in the grid
+static __not_inline int GoLGrid_parse_still_life_apgcode (const char *code, s32 left_x, s32 top_y, GoLGrid *gg)
+{
+	if (!code || !gg || !gg->grid)
+		return ffsc (__func__);
+	
+	GoLGrid_clear_noinline (gg);
+	
+	if (code [0] != 'x' || code [1] != 's' || code [2] < '0' || code [2] > '9')
+		return FALSE;
+	
+	const char *c = code + 2;
+	while (*c >= '0' && *c <= '9')
+		c++;
+	
+	if (*c++ != '_')
+		return FALSE;
+	
+	s32 x = left_x;
+	s32 strip_y = top_y;
+	int not_clipped = TRUE;
+	
+	while (TRUE)
+	{
+		char symbol = *c++;
+		s32 column;
+		
+		if (symbol >= '0' && symbol <= '9')
+			column = symbol - '0';
+		else if (symbol >= 'a' && symbol <= 'v')
+			column = 10 + (symbol - 'a');
+		else if (symbol == 'w')
+		{
+			x += 2;
+			continue;
+		}
+		else if (symbol == 'x')
+		{
+			x += 3;
+			continue;
+		}
+		else if (symbol == 'y')
+		{
+			symbol = *c++;
+			if (symbol >= '0' && symbol <= '9')
+				x += 4 + (symbol - '0');
+			else if (symbol >= 'a' && symbol <= 'z')
+				x += 4 + 10 + (symbol - 'a');
+			else
+				return FALSE;
+			
+			continue;
+		}
+		else if (symbol == 'z')
+		{
+			x = left_x;
+			strip_y += 5;
+			continue;
+		}
+		else
+			break;
+		
+		s32 row_ix;
+		for (row_ix = 0; row_ix < 5; row_ix++)
+			if (column & (1 << row_ix))
+				not_clipped &= GoLGrid_set_cell_on (gg, x, strip_y + row_ix);
+		
+		x++;
+	}
+	
+	return not_clipped;
+}
+
 static __not_inline void GoLGrid_print_life_history (const GoLGrid *on_gg)
 {
 	GoLGrid_print_life_history_full (stdout, NULL, on_gg, NULL, NULL, NULL, TRUE, 68);
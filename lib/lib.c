@@ -469,3 +469,35 @@ static __not_inline int str_to_u64 (const char *s, u64 *num)
 	*num = n;
 	return TRUE;
 }
+
+// The wall clock time in seconds, for timing work that runs in several threads or waits for the disk, where clock () would measure CPU time instead
+static __not_inline double get_wall_time (void)
+{
+#ifdef _WIN32
+	// On Windows clock () already measures wall clock time
+	return (double) clock () / CLOCKS_PER_SEC;
+#else
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + (ts.tv_nsec / 1e9);
+#endif
+}
+
+// fseek and ftell with 64-bit offsets, as long is only 32 bits on Windows, where files over 2 GB would otherwise be read in the wrong place
+static __not_inline int fseek_s64 (FILE *f, s64 offset, int origin)
+{
+#ifdef _WIN32
+	return _fseeki64 (f, offset, origin);
+#else
+	return fseeko (f, (off_t) offset, origin);
+#endif
+}
+
+static __not_inline s64 ftell_s64 (FILE *f)
+{
+#ifdef _WIN32
+	return _ftelli64 (f);
+#else
+	return (s64) ftello (f);
+#endif
+}
@@ -0,0 +1,310 @@
+// A manifest is a small text file that a search writes next to its output files, with everything needed to check and add up the results of the subsets of a
+// search without reading the database files or the output of the search. Each line is a keyword followed by its values, and a manifest that doesn't end
+// with the "end" line was not completely written:
+//
+//   StillCount manifest <format version>
+//   on_cells <min on-cells> <max on-cells>
+//   subset <subset> <number of subsets>       -1 0 for the whole search space
+//   tags <first tag> <end tag>                the range of tags searched, where an end of -1 is the end of the search space
+//   options <options>                         the command line options that change the output files, like "-b -d", or "-" if none
+//   op_cnt <search operations>
+//   rejected <not stable> <not canonical> <not connected>
+//   count <on-cells> <strict still lifes> <pseudo still lifes>
+//   parts <on-cells> <parts> <pseudo still lifes>
+//   output <bytes> <CRC-32> <name>
+//   end
+//
+// There is a "count" line for every bit count from min to max on-cells, and a "parts" line for each number of parts above two that some pseudo still life of
+// that bit count needs. Each "output" line is a file, or the records of one bit count and kind in a single file written with -s, given as
+// <file>:<category>. The CRC-32 is the usual one of zip and gzip, of all bytes written to the file or category, in eight hex digits
+
+#define RUNMANIFEST_FORMAT_VERSION 1
+#define RUNMANIFEST_MAX_ON_CNT 255
+#define RUNMANIFEST_MAX_PART_CNT 63
+#define RUNMANIFEST_MAX_OPTIONS_SIZE 64
+#define RUNMANIFEST_MAX_NAME_SIZE 256
+#define RUNMANIFEST_MAX_LINE_SIZE 512
+
+typedef struct
+{
+	char name [RUNMANIFEST_MAX_NAME_SIZE];
+	u64 size;
+	u32 checksum;
+} RunManifest_Output;
+
+typedef struct
+{
+	s32 min_on_cnt;
+	s32 max_on_cnt;
+	s32 subset;
+	s32 subset_cnt;
+	s32 first_tag;
+	s32 end_tag;
+	char options [RUNMANIFEST_MAX_OPTIONS_SIZE];
+	
+	s64 op_cnt;
+	s64 not_stable_cnt;
+	s64 not_canonical_cnt;
+	s64 not_connected_cnt;
+	
+	s64 strict_cnt [RUNMANIFEST_MAX_ON_CNT + 1];
+	s64 pseudo_cnt [RUNMANIFEST_MAX_ON_CNT + 1];
+	s64 pseudo_part_cnt [RUNMANIFEST_MAX_ON_CNT + 1] [RUNMANIFEST_MAX_PART_CNT + 1];
+	
+	s32 output_cnt;
+	s32 max_output_cnt;
+	RunManifest_Output *output;
+} RunManifest;
+
+
+// Internal functions
+
+// Returns the first character after the keyword and the following space if line starts with it, otherwise NULL
+static __not_inline const char *RunManifest_int_after_keyword (const char *line, const char *keyword)
+{
+	size_t size = strlen (keyword);
+	if (strncmp (line, keyword, size) != 0 || line [size] != ' ')
+		return NULL;
+	
+	return line + size + 1;
+}
+
+// Parses exactly value_cnt whitespace separated signed numbers and nothing more
+static __not_inline int RunManifest_int_parse_values (const char *str, s64 *value, s32 value_cnt)
+{
+	s32 value_ix;
+	for (value_ix = 0; value_ix < value_cnt; value_ix++)
+	{
+		char *end;
+		value [value_ix] = strtoll (str, &end, 10);
+		if (end == str)
+			return FALSE;
+		
+		str = end;
+	}
+	
+	while (*str == ' ')
+		str++;
+	
+	return (*str == '\0');
+}
+
+
+// External functions
+
+static __not_inline void RunManifest_init (RunManifest *rm)
+{
+	if (!rm)
+		return (void) ffsc (__func__);
+	
+	memset (rm, 0, sizeof (RunManifest));
+	rm->subset = -1;
+	rm->end_tag = -1;
+	strcpy (rm->options, "-");
+}
+
+static __not_inline void RunManifest_free (RunManifest *rm)
+{
+	if (!rm)
+		return (void) ffsc (__func__);
+	
+	free (rm->output);
+	RunManifest_init (rm);
+}
+
+// The checksum is a CRC-32 of all bytes of the output. Returns FALSE if out of memory
+static __not_inline int RunManifest_add_output (RunManifest *rm, const char *name, u64 size, u32 checksum)
+{
+	if (!rm || !name || strlen (name) >= RUNMANIFEST_MAX_NAME_SIZE || strchr (name, '\n'))
+		return ffsc (__func__);
+	
+	if (rm->output_cnt == rm->max_output_cnt)
+	{
+		s32 new_max_output_cnt = (rm->max_output_cnt > 0 ? 2 * rm->max_output_cnt : 64);
+		RunManifest_Output *new_output = realloc (rm->output, new_max_output_cnt * sizeof (RunManifest_Output));
+		if (!new_output)
+			return FALSE;
+		
+		rm->output = new_output;
+		rm->max_output_cnt = new_max_output_cnt;
+	}
+	
+	RunManifest_Output *out = &rm->output [rm->output_cnt++];
+	strcpy (out->name, name);
+	out->size = size;
+	out->checksum = checksum;
+	return TRUE;
+}
+
+// Returns FALSE on a write error
+static __not_inline int RunManifest_write (const RunManifest *rm, FILE *stream)
+{
+	if (!rm || !stream || rm->min_on_cnt < 0 || rm->max_on_cnt > RUNMANIFEST_MAX_ON_CNT || rm->min_on_cnt > rm->max_on_cnt)
+		return ffsc (__func__);
+	
+	fprintf (stream, "StillCount manifest %d\n", RUNMANIFEST_FORMAT_VERSION);
+	fprintf (stream, "on_cells %d %d\n", rm->min_on_cnt, rm->max_on_cnt);
+	fprintf (stream, "subset %d %d\n", rm->subset, rm->subset_cnt);
+	fprintf (stream, "tags %d %d\n", rm->first_tag, rm->end_tag);
+	fprintf (stream, "options %s\n", rm->options);
+	fprintf (stream, "op_cnt %" PRIi64 "\n", rm->op_cnt);
+	fprintf (stream, "rejected %" PRIi64 " %" PRIi64 " %" PRIi64 "\n", rm->not_stable_cnt, rm->not_canonical_cnt, rm->not_connected_cnt);
+	
+	s32 on_cnt;
+	for (on_cnt = rm->min_on_cnt; on_cnt <= rm->max_on_cnt; on_cnt++)
+	{
+		fprintf (stream, "count %d %" PRIi64 " %" PRIi64 "\n", on_cnt, rm->strict_cnt [on_cnt], rm->pseudo_cnt [on_cnt]);
+		
+		s32 part_cnt;
+		for (part_cnt = 3; part_cnt <= RUNMANIFEST_MAX_PART_CNT; part_cnt++)
+			if (rm->pseudo_part_cnt [on_cnt] [part_cnt] > 0)
+				fprintf (stream, "parts %d %d %" PRIi64 "\n", on_cnt, part_cnt, rm->pseudo_part_cnt [on_cnt] [part_cnt]);
+	}
+	
+	s32 output_ix;
+	for (output_ix = 0; output_ix < rm->output_cnt; output_ix++)
+		fprintf (stream, "output %" PRIu64 " %08x %s\n", rm->output [output_ix].size, (unsigned) rm->output [output_ix].checksum, rm->output [output_ix].name);
+	
+	fprintf (stream, "end\n");
+	return (ferror (stream) == 0);
+}
+
+// rm must be initialized, and is freed and initialized again before reading. Returns FALSE if the stream is not a complete manifest of a version we can read,
+// with *error_line set to the number of the line that is wrong, or 0 if the manifest ends too early
+static __not_inline int RunManifest_read (RunManifest *rm, FILE *stream, s32 *error_line)
+{
+	if (error_line)
+		*error_line = 0;
+	
+	if (!rm || !stream || !error_line)
+		return ffsc (__func__);
+	
+	RunManifest_free (rm);
+	
+	char line [RUNMANIFEST_MAX_LINE_SIZE];
+	s32 line_number = 0;
+	s32 seen_count_cnt = 0;
+	
+	while (fgets (line, RUNMANIFEST_MAX_LINE_SIZE, stream))
+	{
+		line_number++;
+		*error_line = line_number;
+		
+		size_t size = strlen (line);
+		if (size == 0 || line [size - 1] != '\n')
+			return FALSE;
+		
+		line [--size] = '\0';
+		if (size > 0 && line [size - 1] == '\r')
+			line [--size] = '\0';
+		
+		s64 value [3];
+		const char *arg;
+		
+		if (line_number == 1)
+		{
+			if ((arg = RunManifest_int_after_keyword (line, "StillCount manifest")) == NULL || !RunManifest_int_parse_values (arg, value, 1) ||
+					value [0] != RUNMANIFEST_FORMAT_VERSION)
+				return FALSE;
+		}
+		else if (line_number == 2)
+		{
+			if ((arg = RunManifest_int_after_keyword (line, "on_cells")) == NULL || !RunManifest_int_parse_values (arg, value, 2) || value [0] < 0 ||
+					value [1] > RUNMANIFEST_MAX_ON_CNT || value [0] > value [1])
+				return FALSE;
+			
+			rm->min_on_cnt = (s32) value [0];
+			rm->max_on_cnt = (s32) value [1];
+		}
+		else if (strcmp (line, "end") == 0)
+		{
+			// Every bit count needs its count line, and nothing may follow the end
+			if (seen_count_cnt != 1 + rm->max_on_cnt - rm->min_on_cnt || fgetc (stream) != EOF)
+				return FALSE;
+			
+			*error_line = 0;
+			return TRUE;
+		}
+		else if ((arg = RunManifest_int_after_keyword (line, "subset")) != NULL)
+		{
+			if (!RunManifest_int_parse_values (arg, value, 2) || value [1] < 0 || value [1] > 0xffff || (value [1] == 0 ? value [0] != -1 : (value [0] < 0 || value [0] >= value [1])))
+				return FALSE;
+			
+			rm->subset = (s32) value [0];
+			rm->subset_cnt = (s32) value [1];
+		}
+		else if ((arg = RunManifest_int_after_keyword (line, "tags")) != NULL)
+		{
+			if (!RunManifest_int_parse_values (arg, value, 2) || value [0] < 0 || value [0] > s32_MAX || value [1] < -1 || value [1] > s32_MAX)
+				return FALSE;
+			
+			rm->first_tag = (s32) value [0];
+			rm->end_tag = (s32) value [1];
+		}
+		else if ((arg = RunManifest_int_after_keyword (line, "options")) != NULL)
+		{
+			if (arg [0] == '\0' || strlen (arg) >= RUNMANIFEST_MAX_OPTIONS_SIZE)
+				return FALSE;
+			
+			strcpy (rm->options, arg);
+		}
+		else if ((arg = RunManifest_int_after_keyword (line, "op_cnt")) != NULL)
+		{
+			if (!RunManifest_int_parse_values (arg, value, 1) || value [0] < 0)
+				return FALSE;
+			
+			rm->op_cnt = value [0];
+		}
+		else if ((arg = RunManifest_int_after_keyword (line, "rejected")) != NULL)
+		{
+			if (!RunManifest_int_parse_values (arg, value, 3) || value [0] < 0 || value [1] < 0 || value [2] < 0)
+				return FALSE;
+			
+			rm->not_stable_cnt = value [0];
+			rm->not_canonical_cnt = value [1];
+			rm->not_connected_cnt = value [2];
+		}
+		else if ((arg = RunManifest_int_after_keyword (line, "count")) != NULL)
+		{
+			// The count lines come in order of bit count, from the lowest
+			if (!RunManifest_int_parse_values (arg, value, 3) || value [0] != rm->min_on_cnt + seen_count_cnt || value [0] > rm->max_on_cnt || value [1] < 0 ||
+					value [2] < 0)
+				return FALSE;
+			
+			rm->strict_cnt [value [0]] = value [1];
+			rm->pseudo_cnt [value [0]] = value [2];
+			seen_count_cnt++;
+		}
+		else if ((arg = RunManifest_int_after_keyword (line, "parts")) != NULL)
+		{
+			// The parts lines follow the count line of their bit count, and can't add up to more than the pseudo still lifes of that bit count
+			if (!RunManifest_int_parse_values (arg, value, 3) || seen_count_cnt == 0 || value [0] != rm->min_on_cnt + seen_count_cnt - 1 || value [1] < 3 ||
+					value [1] > RUNMANIFEST_MAX_PART_CNT || value [2] <= 0 || rm->pseudo_part_cnt [value [0]] [value [1]] != 0)
+				return FALSE;
+			
+			rm->pseudo_part_cnt [value [0]] [value [1]] = value [2];
+			
+			s64 in_parts_cnt = 0;
+			s32 part_cnt;
+			for (part_cnt = 3; part_cnt <= RUNMANIFEST_MAX_PART_CNT; part_cnt++)
+				in_parts_cnt += rm->pseudo_part_cnt [value [0]] [part_cnt];
+			
+			if (in_parts_cnt > rm->pseudo_cnt [value [0]])
+				return FALSE;
+		}
+		else if ((arg = RunManifest_int_after_keyword (line, "output")) != NULL)
+		{
+			u64 size;
+			unsigned checksum;
+			int name_ix = 0;
+			if (sscanf (arg, "%" SCNu64 " %8x %n", &size, &checksum, &name_ix) != 2 || name_ix == 0 || arg [name_ix] == '\0' ||
+					!RunManifest_add_output (rm, arg + name_ix, size, (u32) checksum))
+				return FALSE;
+		}
+		else
+			return FALSE;
+	}
+	
+	*error_line = 0;
+	return FALSE;
+}
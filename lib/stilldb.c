@@ -0,0 +1,778 @@
+// A compact binary format for still life databases. All multi-byte numbers are little-endian
+//
+// File header (STILLDB_FILE_HEADER_SIZE bytes):
+//   0  "SLDB"
+//   4  u16 format version
+//   6  u16 header size
+//   8  u8  on-cells in each still life of the file
+//   9  u8  kind of still lifes, STILLDB_KIND_STRICT or STILLDB_KIND_PSEUDO, or STILLDB_KIND_CONTAINER for a file in the format of lib/stilldbcontainer.c,
+//          or STILLDB_KIND_STREAM for a stream of framed records
+//   10 u8  fewest stable parts for the pseudo still lifes in the file, or 0 if not restricted to one number of parts
+//   11 u8  encoding of the records, STILLDB_ENCODING_PLAIN or STILLDB_ENCODING_DELTA
+//   12 u8  min on-cells of the search that made the file
+//   13 u8  max on-cells of the search that made the file
+//   14 u16 number of subsets the search space was divided in, or 0 for a full search
+//   16 u16 searched subset, only valid if the number of subsets is not 0
+//   18 unused, always 0
+//
+// Each record (STILLDB_RECORD_HEADER_SIZE bytes followed by (width * height + 7) / 8 bytes of cells):
+//   0  u8  on-cells
+//   1  u8  kind of still life, STILLDB_KIND_STRICT or STILLDB_KIND_PSEUDO
+//   2  u8  width of the bounding box
+//   3  u8  height of the bounding box
+//   4  the cells of the bounding box row by row, packed with the first cell in the most significant bit of each byte. The last byte is padded with 0 bits
+//
+// With STILLDB_ENCODING_DELTA each record starts with a type byte. Type 0 is a keyframe, followed by the u8 x and y position of the bounding box in the grid
+// of the search and a record as above. Type n from 1 to 255 gives the still life by the n cells that differ from the previous record, which is efficient
+// because the search finds still lifes of the same bit count in order of how they were built. The cells are given by their index (y * 64) + x in the grid
+// of the search, in increasing order, as a stream of bits that fills each byte from the most significant bit and is padded with 0 bits to a whole byte.
+// The first cell is stored as its index in 15 bits, and each following one by the gap g, which is its index minus the index of the cell before minus one:
+//   0  followed by g in 2 bits, if g < 4 (a nearby cell in the same row)
+//   10 followed by g - 60 in 3 bits, if 60 <= g < 68 (a cell close to straight below)
+//   11 followed by g in 15 bits otherwise
+// The records of a file only depend on the records after the latest keyframe, and there is a keyframe at least every STILLDB_KEYFRAME_INTERVAL records
+//
+// A stream of framed records, made to be read while it is written, for example through a pipe, has a file header with kind STILLDB_KIND_STREAM and on-cells
+// and parts set to 0, followed by still lifes of all bit counts and kinds in plain encoding, each in a frame:
+//   0  u16 size of the rest of the frame, or 0 for the frame that ends the stream
+//   2  u8  fewest stable parts of a pseudo still life, or 0 for a strict still life
+//   3  a record as above
+
+#define STILLDB_FORMAT_VERSION 1
+#define STILLDB_FILE_HEADER_SIZE 32
+#define STILLDB_RECORD_HEADER_SIZE 4
+#define STILLDB_MAX_SIDE 64
+#define STILLDB_MAX_RECORD_SIZE (STILLDB_RECORD_HEADER_SIZE + ((STILLDB_MAX_SIDE * STILLDB_MAX_SIDE) / 8))
+
+#define STILLDB_KIND_STRICT 0
+#define STILLDB_KIND_PSEUDO 1
+#define STILLDB_KIND_CONTAINER 2
+#define STILLDB_KIND_STREAM 3
+
+#define STILLDB_ENCODING_PLAIN 0
+#define STILLDB_ENCODING_DELTA 1
+
+#define STILLDB_KEYFRAME_INTERVAL 64
+#define STILLDB_KEYFRAME_HEADER_SIZE 3
+#define STILLDB_MAX_CODED_RECORD_SIZE (STILLDB_KEYFRAME_HEADER_SIZE + STILLDB_MAX_RECORD_SIZE)
+#define STILLDB_DELTA_GRID_HEIGHT (256 + STILLDB_MAX_SIDE)
+
+#define STILLDB_FRAME_HEADER_SIZE 3
+#define STILLDB_MAX_FRAME_SIZE (STILLDB_FRAME_HEADER_SIZE + STILLDB_MAX_RECORD_SIZE)
+
+typedef struct
+{
+	s32 on_cnt;
+	s32 kind;
+	s32 part_cnt;
+	s32 min_on_cnt;
+	s32 max_on_cnt;
+	s32 subset_cnt;
+	s32 subset;
+	s32 encoding;
+} StillDB_FileHeader;
+
+// The rows of a still life shifted to the top-left corner, so that the leftmost column of the bounding box is in the most significant bit of each row. x and y
+// are the position of the bounding box in the grid of the search, which is only stored with STILLDB_ENCODING_DELTA, and read as 0 from other files
+typedef struct
+{
+	s32 on_cnt;
+	s32 kind;
+	s32 x;
+	s32 y;
+	s32 width;
+	s32 height;
+	u64 row [STILLDB_MAX_SIDE];
+} StillDB_Record;
+
+// The state needed to encode or decode the records of one file, or of one category of a container. With STILLDB_ENCODING_DELTA this holds the previous still
+// life at its position in the grid of the search
+typedef struct
+{
+	s32 encoding;
+	s32 records_since_keyframe;
+	int has_previous;
+	s32 kind;
+	s32 y_on;
+	s32 y_off;
+	u64 grid [STILLDB_DELTA_GRID_HEIGHT];
+} StillDB_Codec;
+
+// Reads up to size bytes from source and returns the number of bytes read, like fread
+typedef s32 (*StillDB_ReadBytes) (void *source, u8 *buf, s32 size);
+
+
+// Internal functions
+
+static __force_inline void StillDB_int_put_u16 (u8 *buf, u32 value)
+{
+	buf [0] = (u8) value;
+	buf [1] = (u8) (value >> 8);
+}
+
+static __force_inline u32 StillDB_int_get_u16 (const u8 *buf)
+{
+	return ((u32) buf [0]) | (((u32) buf [1]) << 8);
+}
+
+static __force_inline s32 StillDB_int_cell_byte_cnt (s32 width, s32 height)
+{
+	return ((width * height) + 7) >> 3;
+}
+
+static __not_inline s32 StillDB_int_read_file_bytes (void *source, u8 *buf, s32 size)
+{
+	return (s32) fread (buf, 1, size, (FILE *) source);
+}
+
+// Makes the record the previous still life of the codec
+static __not_inline void StillDB_int_set_previous (StillDB_Codec *codec, const StillDB_Record *rec)
+{
+	s32 y;
+	for (y = codec->y_on; y < codec->y_off; y++)
+		codec->grid [y] = 0;
+	
+	s32 row_ix;
+	for (row_ix = 0; row_ix < rec->height; row_ix++)
+		codec->grid [rec->y + row_ix] = rec->row [row_ix] >> rec->x;
+	
+	codec->has_previous = TRUE;
+	codec->kind = rec->kind;
+	codec->y_on = rec->y;
+	codec->y_off = rec->y + rec->height;
+}
+
+static __force_inline void StillDB_int_put_bits (u8 *buf, s32 *bit_ix, u32 value, s32 bit_cnt)
+{
+	while (bit_cnt > 0)
+	{
+		bit_cnt--;
+		if ((*bit_ix & 7) == 0)
+			buf [*bit_ix >> 3] = 0;
+		
+		buf [*bit_ix >> 3] |= (u8) (((value >> bit_cnt) & 1) << (7 - (*bit_ix & 7)));
+		(*bit_ix)++;
+	}
+}
+
+// Returns the next bit_cnt bits of a delta coded record, reading more bytes from source as needed, or -1 if source ends
+static __force_inline s32 StillDB_int_get_bits (void *source, StillDB_ReadBytes read_bytes, u8 *byte, s32 *bits_left, s32 bit_cnt)
+{
+	s32 value = 0;
+	
+	while (bit_cnt > 0)
+	{
+		if (*bits_left == 0)
+		{
+			if (read_bytes (source, byte, 1) != 1)
+				return -1;
+			
+			*bits_left = 8;
+		}
+		
+		(*bits_left)--;
+		bit_cnt--;
+		value = (value << 1) | ((*byte >> *bits_left) & 1);
+	}
+	
+	return value;
+}
+
+// Encodes a record as its differences from the previous one, and returns the size, or 0 if a keyframe would be as small
+static __not_inline s32 StillDB_int_encode_delta (const StillDB_Codec *codec, const StillDB_Record *rec, u8 *buf)
+{
+	s32 keyframe_size = STILLDB_KEYFRAME_HEADER_SIZE + STILLDB_RECORD_HEADER_SIZE + StillDB_int_cell_byte_cnt (rec->width, rec->height);
+	s32 y_on = lower_of_s32 (codec->y_on, rec->y);
+	s32 y_off = higher_of_s32 (codec->y_off, rec->y + rec->height);
+	
+	u8 *bit_buf = buf + 1;
+	s32 bit_ix = 0;
+	s32 diff_cnt = 0;
+	s32 prev_cell_ix = -1;
+	
+	s32 y;
+	for (y = y_on; y < y_off; y++)
+	{
+		u64 row = (y >= rec->y && y < rec->y + rec->height ? rec->row [y - rec->y] >> rec->x : 0);
+		u64 diff = codec->grid [y] ^ row;
+		
+		while (diff != 0)
+		{
+			// Each cell takes at most 17 bits
+			if (++diff_cnt > 255 || 1 + ((bit_ix + 17 + 7) >> 3) >= keyframe_size)
+				return 0;
+			
+			s32 bit = most_significant_bit_u64 (diff);
+			diff ^= ((u64) 1) << bit;
+			
+			s32 cell_ix = (64 * y) + (63 - bit);
+			s32 gap = cell_ix - prev_cell_ix - 1;
+			
+			if (prev_cell_ix < 0)
+				StillDB_int_put_bits (bit_buf, &bit_ix, cell_ix, 15);
+			else if (gap < 4)
+				StillDB_int_put_bits (bit_buf, &bit_ix, gap, 3);
+			else if (gap >= 60 && gap < 68)
+				StillDB_int_put_bits (bit_buf, &bit_ix, 0x10 | (gap - 60), 5);
+			else
+				StillDB_int_put_bits (bit_buf, &bit_ix, 0x18000 | gap, 17);
+			
+			prev_cell_ix = cell_ix;
+		}
+	}
+	
+	if (diff_cnt == 0)
+		return 0;
+	
+	buf [0] = (u8) diff_cnt;
+	return 1 + ((bit_ix + 7) >> 3);
+}
+
+// Applies diff_cnt differing cells, read from source, to the previous still life of the codec and makes a record of the result
+static __not_inline int StillDB_int_decode_delta (StillDB_Codec *codec, void *source, StillDB_ReadBytes read_bytes, s32 diff_cnt, StillDB_Record *rec)
+{
+	s32 y_on = codec->y_on;
+	s32 y_off = codec->y_off;
+	s32 prev_cell_ix = -1;
+	u8 byte = 0;
+	s32 bits_left = 0;
+	
+	s32 diff_ix;
+	for (diff_ix = 0; diff_ix < diff_cnt; diff_ix++)
+	{
+		s32 cell_ix;
+		if (prev_cell_ix < 0)
+			cell_ix = StillDB_int_get_bits (source, read_bytes, &byte, &bits_left, 15);
+		else
+		{
+			s32 gap;
+			if (StillDB_int_get_bits (source, read_bytes, &byte, &bits_left, 1) == 0)
+				gap = StillDB_int_get_bits (source, read_bytes, &byte, &bits_left, 2);
+			else if (StillDB_int_get_bits (source, read_bytes, &byte, &bits_left, 1) == 0)
+			{
+				gap = StillDB_int_get_bits (source, read_bytes, &byte, &bits_left, 3);
+				if (gap >= 0)
+					gap += 60;
+			}
+			else
+				gap = StillDB_int_get_bits (source, read_bytes, &byte, &bits_left, 15);
+			
+			cell_ix = (gap < 0 ? -1 : prev_cell_ix + 1 + gap);
+		}
+		
+		if (cell_ix < 0 || cell_ix >= 64 * STILLDB_DELTA_GRID_HEIGHT)
+			return FALSE;
+		
+		prev_cell_ix = cell_ix;
+		s32 y = cell_ix >> 6;
+		codec->grid [y] ^= ((u64) 1) << (63 - (cell_ix & 63));
+		
+		y_on = lower_of_s32 (y_on, y);
+		y_off = higher_of_s32 (y_off, y + 1);
+	}
+	
+	while (y_on < y_off && codec->grid [y_on] == 0)
+		y_on++;
+	while (y_off > y_on && codec->grid [y_off - 1] == 0)
+		y_off--;
+	
+	if (y_off - y_on > STILLDB_MAX_SIDE || y_on > 255)
+		return FALSE;
+	
+	u64 all_rows = 0;
+	s32 on_cnt = 0;
+	
+	s32 y;
+	for (y = y_on; y < y_off; y++)
+	{
+		all_rows |= codec->grid [y];
+		on_cnt += bit_count_u64 (codec->grid [y]);
+	}
+	
+	rec->on_cnt = on_cnt;
+	rec->kind = codec->kind;
+	rec->x = (all_rows == 0 ? 0 : 63 - most_significant_bit_u64 (all_rows));
+	rec->y = (all_rows == 0 ? 0 : y_on);
+	rec->width = (all_rows == 0 ? 0 : 64 - (rec->x + least_significant_bit_u64 (all_rows)));
+	rec->height = y_off - y_on;
+	
+	for (y = y_on; y < y_off; y++)
+		rec->row [y - y_on] = codec->grid [y] << rec->x;
+	
+	codec->y_on = y_on;
+	codec->y_off = y_off;
+	return (on_cnt <= 255);
+}
+
+
+// External functions
+
+// Little-endian numbers, as used in the container and index files too
+
+static __force_inline void StillDB_put_u32 (u8 *buf, u32 value)
+{
+	s32 byte_ix;
+	for (byte_ix = 0; byte_ix < 4; byte_ix++)
+		buf [byte_ix] = (u8) (value >> (8 * byte_ix));
+}
+
+static __force_inline void StillDB_put_u64 (u8 *buf, u64 value)
+{
+	s32 byte_ix;
+	for (byte_ix = 0; byte_ix < 8; byte_ix++)
+		buf [byte_ix] = (u8) (value >> (8 * byte_ix));
+}
+
+static __force_inline u32 StillDB_get_u32 (const u8 *buf)
+{
+	u32 value = 0;
+	
+	s32 byte_ix;
+	for (byte_ix = 0; byte_ix < 4; byte_ix++)
+		value |= ((u32) buf [byte_ix]) << (8 * byte_ix);
+	
+	return value;
+}
+
+static __force_inline u64 StillDB_get_u64 (const u8 *buf)
+{
+	u64 value = 0;
+	
+	s32 byte_ix;
+	for (byte_ix = 0; byte_ix < 8; byte_ix++)
+		value |= ((u64) buf [byte_ix]) << (8 * byte_ix);
+	
+	return value;
+}
+
+// Puts the STILLDB_FILE_HEADER_SIZE bytes of the file header in buf
+static __not_inline int StillDB_encode_file_header (const StillDB_FileHeader *fh, u8 *buf)
+{
+	if (!fh || !buf || fh->on_cnt < 0 || fh->on_cnt > 255 || fh->kind < STILLDB_KIND_STRICT || fh->kind > STILLDB_KIND_STREAM || fh->part_cnt < 0 || fh->part_cnt > 255 ||
+			fh->min_on_cnt < 0 || fh->min_on_cnt > 255 || fh->max_on_cnt < 0 || fh->max_on_cnt > 255 || fh->subset_cnt < 0 || fh->subset_cnt > 0xffff ||
+			(fh->subset_cnt > 0 && (fh->subset < 0 || fh->subset >= fh->subset_cnt)) || fh->encoding < STILLDB_ENCODING_PLAIN || fh->encoding > STILLDB_ENCODING_DELTA)
+		return ffsc (__func__);
+	
+	memset (buf, 0, STILLDB_FILE_HEADER_SIZE);
+	
+	memcpy (buf, "SLDB", 4);
+	StillDB_int_put_u16 (buf + 4, STILLDB_FORMAT_VERSION);
+	StillDB_int_put_u16 (buf + 6, STILLDB_FILE_HEADER_SIZE);
+	buf [8] = (u8) fh->on_cnt;
+	buf [9] = (u8) fh->kind;
+	buf [10] = (u8) fh->part_cnt;
+	buf [11] = (u8) fh->encoding;
+	buf [12] = (u8) fh->min_on_cnt;
+	buf [13] = (u8) fh->max_on_cnt;
+	StillDB_int_put_u16 (buf + 14, fh->subset_cnt);
+	StillDB_int_put_u16 (buf + 16, (fh->subset_cnt > 0 ? fh->subset : 0));
+	
+	return TRUE;
+}
+
+static __not_inline int StillDB_write_file_header (FILE *stream, const StillDB_FileHeader *fh)
+{
+	if (!stream || !fh)
+		return ffsc (__func__);
+	
+	u8 buf [STILLDB_FILE_HEADER_SIZE];
+	if (!StillDB_encode_file_header (fh, buf))
+		return FALSE;
+	
+	return (fwrite (buf, 1, STILLDB_FILE_HEADER_SIZE, stream) == STILLDB_FILE_HEADER_SIZE);
+}
+
+// Returns FALSE if the stream doesn't start with a valid header of a version we can read
+static __not_inline int StillDB_read_file_header (FILE *stream, StillDB_FileHeader *fh)
+{
+	if (fh)
+		memset (fh, 0, sizeof (StillDB_FileHeader));
+	
+	if (!stream || !fh)
+		return ffsc (__func__);
+	
+	u8 buf [STILLDB_FILE_HEADER_SIZE];
+	if (fread (buf, 1, 8, stream) != 8 || memcmp (buf, "SLDB", 4) != 0 || StillDB_int_get_u16 (buf + 4) != STILLDB_FORMAT_VERSION)
+		return FALSE;
+	
+	s32 header_size = StillDB_int_get_u16 (buf + 6);
+	if (header_size != STILLDB_FILE_HEADER_SIZE || fread (buf + 8, 1, header_size - 8, stream) != (size_t) (header_size - 8))
+		return FALSE;
+	
+	fh->on_cnt = buf [8];
+	fh->kind = buf [9];
+	fh->part_cnt = buf [10];
+	fh->encoding = buf [11];
+	fh->min_on_cnt = buf [12];
+	fh->max_on_cnt = buf [13];
+	fh->subset_cnt = StillDB_int_get_u16 (buf + 14);
+	fh->subset = (fh->subset_cnt > 0 ? (s32) StillDB_int_get_u16 (buf + 16) : -1);
+	
+	return ((fh->kind >= STILLDB_KIND_STRICT && fh->kind <= STILLDB_KIND_STREAM) &&
+			(fh->encoding == STILLDB_ENCODING_PLAIN || fh->encoding == STILLDB_ENCODING_DELTA));
+}
+
+// Fills in a record from the population rectangle of a 64 bit wide grid
+static __not_inline int StillDB_record_from_grid (const GoLGrid *gg, s32 on_cnt, s32 kind, StillDB_Record *rec)
+{
+	if (!gg || !gg->grid || gg->grid_rect.width != 64 || !rec || gg->pop_y_off - gg->pop_y_on > STILLDB_MAX_SIDE)
+		return ffsc (__func__);
+	
+	rec->on_cnt = on_cnt;
+	rec->kind = kind;
+	rec->x = 0;
+	rec->y = 0;
+	
+	if (gg->pop_x_off <= gg->pop_x_on)
+	{
+		rec->width = 0;
+		rec->height = 0;
+		return TRUE;
+	}
+	
+	rec->x = gg->pop_x_on;
+	rec->y = gg->pop_y_on;
+	rec->width = gg->pop_x_off - gg->pop_x_on;
+	rec->height = gg->pop_y_off - gg->pop_y_on;
+	
+	s32 row_ix;
+	for (row_ix = 0; row_ix < rec->height; row_ix++)
+		rec->row [row_ix] = gg->grid [gg->pop_y_on + row_ix] << gg->pop_x_on;
+	
+	return TRUE;
+}
+
+// Places the still life of a record in the top-left corner of a 64 bit wide grid
+static __not_inline int StillDB_record_to_grid (const StillDB_Record *rec, GoLGrid *gg)
+{
+	if (!rec || !gg || !gg->grid || gg->grid_rect.width != 64 || gg->grid_rect.height < rec->height)
+		return ffsc (__func__);
+	
+	GoLGrid_clear_64_wide (gg);
+	if (rec->width == 0 || rec->height == 0)
+		return TRUE;
+	
+	s32 row_ix;
+	for (row_ix = 0; row_ix < rec->height; row_ix++)
+		gg->grid [row_ix] = rec->row [row_ix];
+	
+	gg->pop_x_on = 0;
+	gg->pop_x_off = rec->width;
+	gg->pop_y_on = 0;
+	gg->pop_y_off = rec->height;
+	
+	return TRUE;
+}
+
+// Encodes a record into buf, which must have room for STILLDB_MAX_RECORD_SIZE bytes. Returns the size of the encoded record
+static __not_inline s32 StillDB_encode_record (const StillDB_Record *rec, u8 *buf)
+{
+	if (!rec || !buf || rec->on_cnt < 0 || rec->on_cnt > 255 || rec->width < 0 || rec->width > STILLDB_MAX_SIDE || rec->height < 0 || rec->height > STILLDB_MAX_SIDE)
+		return ffsc (__func__);
+	
+	buf [0] = (u8) rec->on_cnt;
+	buf [1] = (u8) rec->kind;
+	buf [2] = (u8) rec->width;
+	buf [3] = (u8) rec->height;
+	
+	u8 *cell_buf = buf + STILLDB_RECORD_HEADER_SIZE;
+	s32 byte_ix = 0;
+	
+	// The accumulator holds fewer than 8 pending bits at its top between rows
+	u64 row_mask = (rec->width == 64 ? u64_MAX : ~(u64_MAX >> rec->width));
+	u64 acc = 0;
+	s32 acc_bit_cnt = 0;
+	
+	s32 row_ix;
+	for (row_ix = 0; row_ix < rec->height; row_ix++)
+	{
+		u64 row = rec->row [row_ix] & row_mask;
+		acc |= (row >> acc_bit_cnt);
+		
+		s32 total_bit_cnt = acc_bit_cnt + rec->width;
+		if (total_bit_cnt >= 64)
+		{
+			s32 byte_in_word;
+			for (byte_in_word = 0; byte_in_word < 8; byte_in_word++)
+				cell_buf [byte_ix++] = (u8) (acc >> (56 - (8 * byte_in_word)));
+			
+			acc = (acc_bit_cnt == 0 ? 0 : row << (64 - acc_bit_cnt));
+			acc_bit_cnt = total_bit_cnt - 64;
+		}
+		else
+			acc_bit_cnt = total_bit_cnt;
+		
+		while (acc_bit_cnt >= 8)
+		{
+			cell_buf [byte_ix++] = (u8) (acc >> 56);
+			acc <<= 8;
+			acc_bit_cnt -= 8;
+		}
+	}
+	
+	if (acc_bit_cnt > 0)
+		cell_buf [byte_ix++] = (u8) (acc >> 56);
+	
+	return STILLDB_RECORD_HEADER_SIZE + byte_ix;
+}
+
+// Returns the size of the decoded record, or 0 if size is too small to hold a complete record or the record is invalid
+static __not_inline s32 StillDB_decode_record (const u8 *buf, s32 size, StillDB_Record *rec)
+{
+	if (!buf || !rec)
+		return ffsc (__func__);
+	
+	if (size < STILLDB_RECORD_HEADER_SIZE)
+		return 0;
+	
+	rec->on_cnt = buf [0];
+	rec->kind = buf [1];
+	rec->x = 0;
+	rec->y = 0;
+	rec->width = buf [2];
+	rec->height = buf [3];
+	
+	if (rec->width > STILLDB_MAX_SIDE || rec->height > STILLDB_MAX_SIDE || (rec->kind != STILLDB_KIND_STRICT && rec->kind != STILLDB_KIND_PSEUDO))
+		return 0;
+	
+	s32 byte_cnt = StillDB_int_cell_byte_cnt (rec->width, rec->height);
+	if (size < STILLDB_RECORD_HEADER_SIZE + byte_cnt)
+		return 0;
+	
+	const u8 *cell_buf = buf + STILLDB_RECORD_HEADER_SIZE;
+	s32 byte_ix = 0;
+	
+	// The accumulator is refilled a byte at a time at its bottom while it has room for one more
+	u64 acc = 0;
+	s32 acc_bit_cnt = 0;
+	
+	s32 row_ix;
+	for (row_ix = 0; row_ix < rec->height; row_ix++)
+	{
+		while (acc_bit_cnt <= 56 && byte_ix < byte_cnt)
+		{
+			acc |= ((u64) cell_buf [byte_ix++]) << (56 - acc_bit_cnt);
+			acc_bit_cnt += 8;
+		}
+		
+		if (acc_bit_cnt >= rec->width)
+		{
+			rec->row [row_ix] = (rec->width == 64 ? acc : acc & ~(u64_MAX >> rec->width));
+			acc = (rec->width == 64 ? 0 : acc << rec->width);
+			acc_bit_cnt -= rec->width;
+		}
+		else
+		{
+			// Only happens for rows wider than 56 cells, where the last few bits come from the byte that didn't fit in the accumulator
+			s32 missing_bit_cnt = rec->width - acc_bit_cnt;
+			u64 next_byte = cell_buf [byte_ix++];
+			
+			rec->row [row_ix] = acc | ((next_byte >> (8 - missing_bit_cnt)) << (64 - rec->width));
+			acc = next_byte << (56 + missing_bit_cnt);
+			acc_bit_cnt = 8 - missing_bit_cnt;
+		}
+	}
+	
+	return STILLDB_RECORD_HEADER_SIZE + byte_cnt;
+}
+
+static __not_inline int StillDB_init_codec (StillDB_Codec *codec, s32 encoding)
+{
+	if (!codec || encoding < STILLDB_ENCODING_PLAIN || encoding > STILLDB_ENCODING_DELTA)
+		return ffsc (__func__);
+	
+	memset (codec, 0, sizeof (StillDB_Codec));
+	codec->encoding = encoding;
+	return TRUE;
+}
+
+// Encodes the next record of a file into buf, which must have room for STILLDB_MAX_CODED_RECORD_SIZE bytes. Returns the size of the encoded record
+static __not_inline s32 StillDB_encode_next (StillDB_Codec *codec, const StillDB_Record *rec, u8 *buf)
+{
+	if (!codec || !rec || !buf)
+		return ffsc (__func__);
+	
+	if (codec->encoding == STILLDB_ENCODING_PLAIN)
+		return StillDB_encode_record (rec, buf);
+	
+	if (rec->x < 0 || rec->y < 0 || rec->y > 255 || rec->width < 0 || rec->x + rec->width > 64 || rec->height < 0 || rec->height > STILLDB_MAX_SIDE)
+		return ffsc (__func__);
+	
+	s32 size = 0;
+	if (codec->has_previous && rec->kind == codec->kind && codec->records_since_keyframe < STILLDB_KEYFRAME_INTERVAL)
+		size = StillDB_int_encode_delta (codec, rec, buf);
+	
+	if (size > 0)
+		codec->records_since_keyframe++;
+	else
+	{
+		s32 record_size = StillDB_encode_record (rec, buf + STILLDB_KEYFRAME_HEADER_SIZE);
+		if (record_size == 0)
+			return 0;
+		
+		buf [0] = 0;
+		buf [1] = (u8) rec->x;
+		buf [2] = (u8) rec->y;
+		size = STILLDB_KEYFRAME_HEADER_SIZE + record_size;
+		codec->records_since_keyframe = 1;
+	}
+	
+	StillDB_int_set_previous (codec, rec);
+	return size;
+}
+
+// Reads the next record of a file, or of a category of a container, from source. Returns 1 if a record was read, 0 at the end, and -1 if the data ends in
+// the middle of a record or contains an invalid record
+static __not_inline int StillDB_read_next (StillDB_Codec *codec, void *source, StillDB_ReadBytes read_bytes, StillDB_Record *rec)
+{
+	if (!codec || !read_bytes || !rec)
+	{
+		ffsc (__func__);
+		return -1;
+	}
+	
+	u8 buf [STILLDB_MAX_CODED_RECORD_SIZE];
+	u8 *record_buf = buf;
+	s32 first_read_size = (codec->encoding == STILLDB_ENCODING_DELTA ? 1 : STILLDB_RECORD_HEADER_SIZE);
+	
+	s32 header_read = read_bytes (source, buf, first_read_size);
+	if (header_read == 0)
+		return 0;
+	if (header_read != first_read_size)
+		return -1;
+	
+	if (codec->encoding == STILLDB_ENCODING_DELTA)
+	{
+		if (buf [0] != 0)
+			return (codec->has_previous && StillDB_int_decode_delta (codec, source, read_bytes, buf [0], rec) ? 1 : -1);
+		
+		if (read_bytes (source, buf + 1, STILLDB_KEYFRAME_HEADER_SIZE + STILLDB_RECORD_HEADER_SIZE - 1) != STILLDB_KEYFRAME_HEADER_SIZE + STILLDB_RECORD_HEADER_SIZE - 1)
+			return -1;
+		
+		record_buf = buf + STILLDB_KEYFRAME_HEADER_SIZE;
+	}
+	
+	if (record_buf [2] > STILLDB_MAX_SIDE || record_buf [3] > STILLDB_MAX_SIDE)
+		return -1;
+	
+	s32 byte_cnt = StillDB_int_cell_byte_cnt (record_buf [2], record_buf [3]);
+	if (read_bytes (source, record_buf + STILLDB_RECORD_HEADER_SIZE, byte_cnt) != byte_cnt)
+		return -1;
+	
+	if (StillDB_decode_record (record_buf, STILLDB_RECORD_HEADER_SIZE + byte_cnt, rec) == 0)
+		return -1;
+	
+	if (codec->encoding == STILLDB_ENCODING_DELTA)
+	{
+		rec->x = buf [1];
+		rec->y = buf [2];
+		if (rec->x + rec->width > 64)
+			return -1;
+		
+		StillDB_int_set_previous (codec, rec);
+	}
+	
+	return 1;
+}
+
+static __not_inline int StillDB_write_record (FILE *stream, StillDB_Codec *codec, const StillDB_Record *rec)
+{
+	if (!stream || !codec || !rec)
+		return ffsc (__func__);
+	
+	u8 buf [STILLDB_MAX_CODED_RECORD_SIZE];
+	s32 size = StillDB_encode_next (codec, rec, buf);
+	
+	return (size > 0 && fwrite (buf, 1, size, stream) == (size_t) size);
+}
+
+// Returns 1 if a record was read, 0 at the end of the stream, and -1 if the stream ends in the middle of a record or contains an invalid record
+static __not_inline int StillDB_read_record (FILE *stream, StillDB_Codec *codec, StillDB_Record *rec)
+{
+	if (!stream || !codec || !rec)
+	{
+		ffsc (__func__);
+		return -1;
+	}
+	
+	return StillDB_read_next (codec, stream, StillDB_int_read_file_bytes, rec);
+}
+
+// Encodes a record and the fewest stable parts of it, or 0 for a strict still life, as a frame of a stream. buf must have room for STILLDB_MAX_FRAME_SIZE
+// bytes. Returns the size of the frame
+static __not_inline s32 StillDB_encode_frame (const StillDB_Record *rec, s32 part_cnt, u8 *buf)
+{
+	if (!rec || !buf || part_cnt < 0 || part_cnt > 255)
+		return ffsc (__func__);
+	
+	s32 record_size = StillDB_encode_record (rec, buf + STILLDB_FRAME_HEADER_SIZE);
+	if (record_size == 0)
+		return 0;
+	
+	StillDB_int_put_u16 (buf, 1 + record_size);
+	buf [2] = (u8) part_cnt;
+	return STILLDB_FRAME_HEADER_SIZE + record_size;
+}
+
+// Returns 1 if a frame was read, 0 at the frame that ends the stream, and -1 if the stream ends without that frame or contains an invalid frame
+static __not_inline int StillDB_read_frame (FILE *stream, StillDB_Record *rec, s32 *part_cnt)
+{
+	if (!stream || !rec || !part_cnt)
+	{
+		ffsc (__func__);
+		return -1;
+	}
+	
+	u8 buf [STILLDB_MAX_FRAME_SIZE];
+	if (fread (buf, 1, 2, stream) != 2)
+		return -1;
+	
+	s32 size = StillDB_int_get_u16 (buf);
+	if (size == 0)
+		return 0;
+	
+	if (size < 1 + STILLDB_RECORD_HEADER_SIZE || size > STILLDB_MAX_FRAME_SIZE - 2 || fread (buf + 2, 1, size, stream) != (size_t) size)
+		return -1;
+	
+	*part_cnt = buf [2];
+	return (StillDB_decode_record (buf + STILLDB_FRAME_HEADER_SIZE, size - 1, rec) == size - 1 ? 1 : -1);
+}
+
+// Gets the bit count, kind and fewest stable parts (or 0) of the still lifes in a database file from a filename like "32_bits_pseudo_3_parts.txt", as the
+// text files don't record them. on_cnt and kind are set to -1 if the filename doesn't tell
+static __not_inline void StillDB_get_category_from_filename (const char *filename, s32 *on_cnt, s32 *kind, s32 *part_cnt)
+{
+	if (!filename || !on_cnt || !kind || !part_cnt)
+		return (void) ffsc (__func__);
+	
+	*on_cnt = -1;
+	*kind = -1;
+	*part_cnt = 0;
+	
+	const char *name = filename;
+	const char *c;
+	for (c = filename; *c != '\0'; c++)
+		if (*c == '/' || *c == '\\')
+			name = c + 1;
+	
+	int bit_cnt;
+	int parts;
+	int size = 0;
+	if (sscanf (name, "%d_bits_%n", &bit_cnt, &size) != 1 || size == 0 || bit_cnt < 0 || bit_cnt > 255)
+		return;
+	
+	name += size;
+	if (strncmp (name, "strict", 6) == 0)
+		*kind = STILLDB_KIND_STRICT;
+	else if (sscanf (name, "pseudo_%d_parts", &parts) == 1 && parts > 2 && parts <= 255)
+	{
+		*kind = STILLDB_KIND_PSEUDO;
+		*part_cnt = parts;
+	}
+	else if (strncmp (name, "pseudo", 6) == 0)
+		*kind = STILLDB_KIND_PSEUDO;
+	else
+		return;
+	
+	*on_cnt = bit_cnt;
+}
@@ -0,0 +1,406 @@
+// A single file holding the still life records of many database files, for example all bit counts and kinds of still lifes of one search. The records of
+// each category (bit count, kind and number of parts) are written in blocks as they are produced, and an index at the end of the file lists the blocks of
+// each category, so a reader can get all records of one category without reading the others. The records are the same as in lib/stilldb.c, so each one also
+// carries its bit count and kind. All multi-byte numbers are little-endian
+//
+// File header: a StillDB file header with kind STILLDB_KIND_CONTAINER and on-cells and parts set to 0. The encoding of the header applies to the records of
+// each category, so with STILLDB_ENCODING_DELTA each record depends on the previous records of its own category
+//
+// Each block (STILLDB_CONTAINER_BLOCK_HEADER_SIZE bytes followed by the records):
+//   0  u8  on-cells of the category
+//   1  u8  kind of the category, STILLDB_KIND_STRICT or STILLDB_KIND_PSEUDO
+//   2  u8  fewest stable parts of the category, or 0
+//   3  u8  unused, always 0
+//   4  u32 size of the records that follow. A record can continue in the next block of the same category
+//
+// Index, after the last block. For each category (STILLDB_CONTAINER_CATEGORY_ENTRY_SIZE bytes):
+//   0  u8  on-cells
+//   1  u8  kind
+//   2  u8  fewest stable parts, or 0
+//   3  u8  unused, always 0
+//   4  u32 number of blocks
+//   8  u64 number of records
+//   16 for each block, u64 file offset of the block header (STILLDB_CONTAINER_BLOCK_ENTRY_SIZE bytes)
+//
+// Trailer, the last STILLDB_CONTAINER_TRAILER_SIZE bytes of the file:
+//   0  u64 file offset of the index
+//   8  u32 number of categories
+//   12 "SLDX"
+
+#define STILLDB_CONTAINER_BLOCK_HEADER_SIZE 8
+#define STILLDB_CONTAINER_CATEGORY_ENTRY_SIZE 16
+#define STILLDB_CONTAINER_BLOCK_ENTRY_SIZE 8
+#define STILLDB_CONTAINER_TRAILER_SIZE 16
+
+typedef struct
+{
+	s32 on_cnt;
+	s32 kind;
+	s32 part_cnt;
+	s64 record_cnt;
+	
+	s32 block_cnt;
+	s32 max_block_cnt;
+	s64 *block_offset;
+} StillDBContainer_Category;
+
+typedef struct
+{
+	FILE *file;
+	StillDB_FileHeader fh;
+	s64 file_size;
+	int write_error;
+	
+	s32 max_category_cnt;
+	s32 category_cnt;
+	StillDBContainer_Category *category;
+} StillDBContainer;
+
+// Reads the records of one category of a container, following its blocks
+typedef struct
+{
+	const StillDBContainer *ct;
+	s32 category_ix;
+	s32 next_block_ix;
+	s64 block_bytes_left;
+	StillDB_Codec codec;
+} StillDBContainer_Reader;
+
+
+// Internal functions
+
+static __not_inline int StillDBContainer_int_write (StillDBContainer *ct, const void *data, s32 size)
+{
+	if (fwrite (data, 1, size, ct->file) != (size_t) size)
+	{
+		ct->write_error = TRUE;
+		return FALSE;
+	}
+	
+	ct->file_size += size;
+	return TRUE;
+}
+
+static __not_inline int StillDBContainer_int_add_block_offset (StillDBContainer_Category *cat, s64 block_offset)
+{
+	if (cat->block_cnt == cat->max_block_cnt)
+	{
+		s32 new_max_block_cnt = (cat->max_block_cnt > 0 ? 2 * cat->max_block_cnt : 64);
+		s64 *new_block_offset = realloc (cat->block_offset, new_max_block_cnt * sizeof (s64));
+		if (!new_block_offset)
+			return FALSE;
+		
+		cat->block_offset = new_block_offset;
+		cat->max_block_cnt = new_max_block_cnt;
+	}
+	
+	cat->block_offset [cat->block_cnt++] = block_offset;
+	return TRUE;
+}
+
+static __not_inline void StillDBContainer_int_free (StillDBContainer *ct)
+{
+	if (ct->category)
+	{
+		s32 category_ix;
+		for (category_ix = 0; category_ix < ct->category_cnt; category_ix++)
+			free (ct->category [category_ix].block_offset);
+		
+		free (ct->category);
+	}
+	
+	ct->category = NULL;
+	ct->category_cnt = 0;
+}
+
+// Reads size bytes of the records of the category, continuing in the next block when needed. Returns the number of bytes read
+static __not_inline s32 StillDBContainer_int_read_bytes (void *source, u8 *buf, s32 size)
+{
+	StillDBContainer_Reader *rd = (StillDBContainer_Reader *) source;
+	const StillDBContainer_Category *cat = &rd->ct->category [rd->category_ix];
+	s32 read_cnt = 0;
+	
+	while (read_cnt < size)
+	{
+		if (rd->block_bytes_left == 0)
+		{
+			if (rd->next_block_ix >= cat->block_cnt)
+				break;
+			
+			u8 block_header [STILLDB_CONTAINER_BLOCK_HEADER_SIZE];
+			if (fseek_s64 (rd->ct->file, cat->block_offset [rd->next_block_ix], SEEK_SET) != 0 ||
+					fread (block_header, 1, STILLDB_CONTAINER_BLOCK_HEADER_SIZE, rd->ct->file) != STILLDB_CONTAINER_BLOCK_HEADER_SIZE ||
+					block_header [0] != cat->on_cnt || block_header [1] != cat->kind || block_header [2] != cat->part_cnt)
+				break;
+			
+			rd->block_bytes_left = StillDB_get_u32 (block_header + 4);
+			rd->next_block_ix++;
+			continue;
+		}
+		
+		s32 chunk_size = (size - read_cnt < rd->block_bytes_left ? size - read_cnt : (s32) rd->block_bytes_left);
+		s32 chunk_read = (s32) fread (buf + read_cnt, 1, chunk_size, rd->ct->file);
+		read_cnt += chunk_read;
+		rd->block_bytes_left -= chunk_read;
+		
+		if (chunk_read != chunk_size)
+			break;
+	}
+	
+	return read_cnt;
+}
+
+
+// External functions
+
+// Starts writing a container to a file opened for binary writing. The search parameters are taken from fh, the other fields of it are ignored
+static __not_inline int StillDBContainer_create (StillDBContainer *ct, FILE *file, const StillDB_FileHeader *fh, s32 max_category_cnt)
+{
+	if (!ct || !file || !fh || max_category_cnt <= 0)
+		return ffsc (__func__);
+	
+	memset (ct, 0, sizeof (StillDBContainer));
+	ct->fh = *fh;
+	ct->fh.on_cnt = 0;
+	ct->fh.kind = STILLDB_KIND_CONTAINER;
+	ct->fh.part_cnt = 0;
+	ct->max_category_cnt = max_category_cnt;
+	
+	ct->category = calloc (max_category_cnt, sizeof (StillDBContainer_Category));
+	if (!ct->category)
+		return FALSE;
+	
+	if (!StillDB_write_file_header (file, &ct->fh))
+	{
+		StillDBContainer_int_free (ct);
+		return FALSE;
+	}
+	
+	ct->file = file;
+	ct->file_size = STILLDB_FILE_HEADER_SIZE;
+	return TRUE;
+}
+
+// Returns the index of the new category, or -1 if there is no room for more categories. Categories can be added while blocks are written by another thread,
+// as long as the new category is handed over to that thread with proper synchronization before its first block is written
+static __not_inline s32 StillDBContainer_add_category (StillDBContainer *ct, s32 on_cnt, s32 kind, s32 part_cnt)
+{
+	if (!ct || !ct->category || on_cnt < 0 || on_cnt > 255 || (kind != STILLDB_KIND_STRICT && kind != STILLDB_KIND_PSEUDO) || part_cnt < 0 || part_cnt > 255)
+	{
+		ffsc (__func__);
+		return -1;
+	}
+	
+	if (ct->category_cnt == ct->max_category_cnt)
+		return -1;
+	
+	StillDBContainer_Category *cat = &ct->category [ct->category_cnt];
+	memset (cat, 0, sizeof (StillDBContainer_Category));
+	cat->on_cnt = on_cnt;
+	cat->kind = kind;
+	cat->part_cnt = part_cnt;
+	
+	return ct->category_cnt++;
+}
+
+// Writes a block of records, or parts of records, of a category
+static __not_inline int StillDBContainer_write_block (StillDBContainer *ct, s32 category_ix, const void *data, s32 size)
+{
+	if (!ct || !ct->category || category_ix < 0 || category_ix >= ct->max_category_cnt || !data || size <= 0)
+		return ffsc (__func__);
+	
+	StillDBContainer_Category *cat = &ct->category [category_ix];
+	if (!StillDBContainer_int_add_block_offset (cat, ct->file_size))
+	{
+		ct->write_error = TRUE;
+		return FALSE;
+	}
+	
+	u8 block_header [STILLDB_CONTAINER_BLOCK_HEADER_SIZE];
+	block_header [0] = (u8) cat->on_cnt;
+	block_header [1] = (u8) cat->kind;
+	block_header [2] = (u8) cat->part_cnt;
+	block_header [3] = 0;
+	StillDB_put_u32 (block_header + 4, (u32) size);
+	
+	return StillDBContainer_int_write (ct, block_header, STILLDB_CONTAINER_BLOCK_HEADER_SIZE) && StillDBContainer_int_write (ct, data, size);
+}
+
+static __not_inline s32 StillDBContainer_find_category (const StillDBContainer *ct, s32 on_cnt, s32 kind, s32 part_cnt)
+{
+	if (!ct || !ct->category)
+	{
+		ffsc (__func__);
+		return -1;
+	}
+	
+	s32 category_ix;
+	for (category_ix = 0; category_ix < ct->category_cnt; category_ix++)
+		if (ct->category [category_ix].on_cnt == on_cnt && ct->category [category_ix].kind == kind && ct->category [category_ix].part_cnt == part_cnt)
+			return category_ix;
+	
+	return -1;
+}
+
+// The number of records is only stored in the index, so the writer of the container must set it before calling StillDBContainer_finish
+static __not_inline void StillDBContainer_set_record_cnt (StillDBContainer *ct, s32 category_ix, s64 record_cnt)
+{
+	if (!ct || !ct->category || category_ix < 0 || category_ix >= ct->category_cnt)
+		return (void) ffsc (__func__);
+	
+	ct->category [category_ix].record_cnt = record_cnt;
+}
+
+// Writes the index and closes the file. Returns FALSE if any write failed
+static __not_inline int StillDBContainer_finish (StillDBContainer *ct)
+{
+	if (!ct || !ct->file || !ct->category)
+		return ffsc (__func__);
+	
+	s64 index_offset = ct->file_size;
+	u8 buf [STILLDB_CONTAINER_CATEGORY_ENTRY_SIZE];
+	
+	s32 category_ix;
+	for (category_ix = 0; category_ix < ct->category_cnt && !ct->write_error; category_ix++)
+	{
+		const StillDBContainer_Category *cat = &ct->category [category_ix];
+		
+		memset (buf, 0, STILLDB_CONTAINER_CATEGORY_ENTRY_SIZE);
+		buf [0] = (u8) cat->on_cnt;
+		buf [1] = (u8) cat->kind;
+		buf [2] = (u8) cat->part_cnt;
+		StillDB_put_u32 (buf + 4, (u32) cat->block_cnt);
+		StillDB_put_u64 (buf + 8, (u64) cat->record_cnt);
+		StillDBContainer_int_write (ct, buf, STILLDB_CONTAINER_CATEGORY_ENTRY_SIZE);
+		
+		s32 block_ix;
+		for (block_ix = 0; block_ix < cat->block_cnt; block_ix++)
+		{
+			StillDB_put_u64 (buf, (u64) cat->block_offset [block_ix]);
+			StillDBContainer_int_write (ct, buf, STILLDB_CONTAINER_BLOCK_ENTRY_SIZE);
+		}
+	}
+	
+	StillDB_put_u64 (buf, (u64) index_offset);
+	StillDB_put_u32 (buf + 8, (u32) ct->category_cnt);
+	memcpy (buf + 12, "SLDX", 4);
+	StillDBContainer_int_write (ct, buf, STILLDB_CONTAINER_TRAILER_SIZE);
+	
+	int success = !ct->write_error;
+	if (fclose (ct->file) != 0)
+		success = FALSE;
+	
+	ct->file = NULL;
+	StillDBContainer_int_free (ct);
+	return success;
+}
+
+// Reads the file header and the index of a container from a file opened for binary reading, which is closed by StillDBContainer_close. Returns FALSE if
+// the file isn't a valid container
+static __not_inline int StillDBContainer_open (StillDBContainer *ct, FILE *file)
+{
+	if (!ct || !file)
+		return ffsc (__func__);
+	
+	memset (ct, 0, sizeof (StillDBContainer));
+	ct->file = file;
+	
+	if (fseek (file, 0, SEEK_SET) != 0 || !StillDB_read_file_header (file, &ct->fh) || ct->fh.kind != STILLDB_KIND_CONTAINER)
+		return FALSE;
+	
+	u8 buf [STILLDB_CONTAINER_CATEGORY_ENTRY_SIZE];
+	if (fseek_s64 (file, -STILLDB_CONTAINER_TRAILER_SIZE, SEEK_END) != 0 || fread (buf, 1, STILLDB_CONTAINER_TRAILER_SIZE, file) != STILLDB_CONTAINER_TRAILER_SIZE ||
+			memcmp (buf + 12, "SLDX", 4) != 0)
+		return FALSE;
+	
+	s64 index_offset = StillDB_get_u64 (buf);
+	u32 category_cnt = StillDB_get_u32 (buf + 8);
+	if (category_cnt == 0 || category_cnt > 0x10000 || fseek_s64 (file, index_offset, SEEK_SET) != 0)
+		return FALSE;
+	
+	ct->max_category_cnt = category_cnt;
+	ct->category = calloc (category_cnt, sizeof (StillDBContainer_Category));
+	if (!ct->category)
+		return FALSE;
+	
+	int valid = TRUE;
+	while (valid && ct->category_cnt < ct->max_category_cnt)
+	{
+		if (fread (buf, 1, STILLDB_CONTAINER_CATEGORY_ENTRY_SIZE, file) != STILLDB_CONTAINER_CATEGORY_ENTRY_SIZE)
+		{
+			valid = FALSE;
+			break;
+		}
+		
+		StillDBContainer_Category *cat = &ct->category [ct->category_cnt++];
+		cat->on_cnt = buf [0];
+		cat->kind = buf [1];
+		cat->part_cnt = buf [2];
+		cat->record_cnt = StillDB_get_u64 (buf + 8);
+		
+		u32 block_cnt = StillDB_get_u32 (buf + 4);
+		cat->block_offset = (block_cnt <= 0x1000000 ? malloc ((block_cnt > 0 ? block_cnt : 1) * sizeof (s64)) : NULL);
+		if (!cat->block_offset)
+		{
+			valid = FALSE;
+			break;
+		}
+		
+		cat->max_block_cnt = block_cnt;
+		while ((u32) cat->block_cnt < block_cnt && fread (buf, 1, STILLDB_CONTAINER_BLOCK_ENTRY_SIZE, file) == STILLDB_CONTAINER_BLOCK_ENTRY_SIZE)
+			cat->block_offset [cat->block_cnt++] = StillDB_get_u64 (buf);
+		
+		if ((u32) cat->block_cnt != block_cnt)
+			valid = FALSE;
+	}
+	
+	if (!valid)
+	{
+		StillDBContainer_int_free (ct);
+		return FALSE;
+	}
+	
+	return TRUE;
+}
+
+static __not_inline void StillDBContainer_close (StillDBContainer *ct)
+{
+	if (!ct)
+		return (void) ffsc (__func__);
+	
+	if (ct->file)
+		fclose (ct->file);
+	
+	ct->file = NULL;
+	StillDBContainer_int_free (ct);
+}
+
+static __not_inline int StillDBContainer_open_category (const StillDBContainer *ct, s32 category_ix, StillDBContainer_Reader *rd)
+{
+	if (!ct || !ct->category || category_ix < 0 || category_ix >= ct->category_cnt || !rd)
+		return ffsc (__func__);
+	
+	rd->ct = ct;
+	rd->category_ix = category_ix;
+	rd->next_block_ix = 0;
+	rd->block_bytes_left = 0;
+	
+	return StillDB_init_codec (&rd->codec, ct->fh.encoding);
+}
+
+// Returns 1 if a record was read, 0 at the end of the category, and -1 if the category ends in the middle of a record, contains an invalid record or a block
+// could not be read
+static __not_inline int StillDBContainer_read_record (StillDBContainer_Reader *rd, StillDB_Record *rec)
+{
+	if (!rd || !rec)
+	{
+		ffsc (__func__);
+		return -1;
+	}
+	
+	int result = StillDB_read_next (&rd->codec, rd, StillDBContainer_int_read_bytes, rec);
+	if (result == 0 && rd->next_block_ix < rd->ct->category [rd->category_ix].block_cnt)
+		return -1;
+	
+	return result;
+}
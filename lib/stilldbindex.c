@@ -0,0 +1,370 @@
+// An index of the still lifes in any number of database files, to look up a pattern without going through the databases. It is an open addressing hash
+// table of the canonical hash of each still life from GoLUtils_make_canonical, made in a 64 by 64 grid with random data from a fixed seed, so a still life
+// in any orientation and position gives the same hash. Only the hash is stored, so a pattern that is not in the index is reported as found with a probability
+// of about the number of entries divided by 2^64. The number of slots is a power of two and at least twice the number of entries, and a hash is looked for
+// from the slot given by its lowest bits and then in the following slots until an empty one. The file is made to be memory mapped, so a lookup only reads
+// the few slots it needs, if STILLDB_INDEX_USE_MMAP is defined and sys/mman.h and unistd.h are included. All multi-byte numbers are little-endian
+//
+// Header (STILLDB_INDEX_HEADER_SIZE bytes):
+//   0  "SLDI"
+//   4  u32 format version
+//   8  u64 number of slots
+//   16 u64 number of entries
+//   24 u64 hash of the block, to check that the hashes are made in the same way as when the index was built
+//
+// Each slot (STILLDB_INDEX_SLOT_SIZE bytes), all 0 for an empty slot:
+//   0  u64 canonical hash, where a hash of 0 is stored as 1
+//   8  u8  on-cells
+//   9  u8  kind of still life, STILLDB_KIND_STRICT or STILLDB_KIND_PSEUDO
+//   10 u8  fewest stable parts of a pseudo still life that needs more than two, if the database tells, otherwise 0
+//   11 unused, always 0
+
+#define STILLDB_INDEX_FORMAT_VERSION 1
+#define STILLDB_INDEX_HEADER_SIZE 32
+#define STILLDB_INDEX_SLOT_SIZE 16
+#define STILLDB_INDEX_MIN_SLOT_CNT 1024
+#define STILLDB_INDEX_GRID_SIDE 64
+#define STILLDB_INDEX_SEED_1 0x5a1f7e3b9c0d2468u
+#define STILLDB_INDEX_SEED_2 0x13579bdf2468ace0u
+
+typedef struct
+{
+	u64 slot_cnt;
+	u64 entry_cnt;
+	u8 *slot;
+	
+	// The whole file, either memory mapped or read into memory
+	u8 *data;
+	u64 data_size;
+	int is_mapped;
+	int is_writable;
+	FILE *file;
+	
+	RandomDataArray rda;
+	GoLGrid *pattern;
+	GoLGrid *canonical;
+	GoLGrid *temp_1;
+	GoLGrid *temp_2;
+} StillDBIndex;
+
+
+// Internal functions
+
+// The random data is made from a fixed seed, so it is the same every time, and the seed of other users of random_u64 is restored afterwards
+static __not_inline int StillDBIndex_int_init_hashing (StillDBIndex *ix)
+{
+	u64 saved_state_0 = random_u64_state_0;
+	u64 saved_state_1 = random_u64_state_1;
+	random_u64_set_seed (STILLDB_INDEX_SEED_1, STILLDB_INDEX_SEED_2, FALSE);
+	
+	int success = RandomDataArray_create (&ix->rda, (STILLDB_INDEX_GRID_SIDE >> 6) * STILLDB_INDEX_GRID_SIDE);
+	
+	random_u64_state_0 = saved_state_0;
+	random_u64_state_1 = saved_state_1;
+	
+	ix->pattern = GoLUtils_alloc_std_grid (0, 0, STILLDB_INDEX_GRID_SIDE, STILLDB_INDEX_GRID_SIDE);
+	ix->canonical = GoLUtils_alloc_std_grid (0, 0, STILLDB_INDEX_GRID_SIDE, STILLDB_INDEX_GRID_SIDE);
+	ix->temp_1 = GoLUtils_alloc_std_grid (0, 0, STILLDB_INDEX_GRID_SIDE, STILLDB_INDEX_GRID_SIDE);
+	ix->temp_2 = GoLUtils_alloc_std_grid (0, 0, STILLDB_INDEX_GRID_SIDE, STILLDB_INDEX_GRID_SIDE);
+	
+	return (success && ix->pattern && ix->canonical && ix->temp_1 && ix->temp_2);
+}
+
+static __not_inline void StillDBIndex_int_free (StillDBIndex *ix)
+{
+	if (ix->data)
+	{
+#ifdef STILLDB_INDEX_USE_MMAP
+		if (ix->is_mapped)
+			munmap (ix->data, ix->data_size);
+		else
+			free (ix->data);
+#else
+		free (ix->data);
+#endif
+	}
+	
+	if (ix->file)
+		fclose (ix->file);
+	
+	if (ix->rda.data_alloc)
+		RandomDataArray_free (&ix->rda);
+	
+	if (ix->pattern)
+		GoLUtils_free_std_grid (&ix->pattern);
+	if (ix->canonical)
+		GoLUtils_free_std_grid (&ix->canonical);
+	if (ix->temp_1)
+		GoLUtils_free_std_grid (&ix->temp_1);
+	if (ix->temp_2)
+		GoLUtils_free_std_grid (&ix->temp_2);
+	
+	memset (ix, 0, sizeof (StillDBIndex));
+}
+
+// Used as the check value in the header
+static __not_inline u64 StillDBIndex_int_block_hash (StillDBIndex *ix)
+{
+	GoLGrid_clear_noinline (ix->pattern);
+	GoLGrid_set_cell_on (ix->pattern, 0, 0);
+	GoLGrid_set_cell_on (ix->pattern, 1, 0);
+	GoLGrid_set_cell_on (ix->pattern, 0, 1);
+	GoLGrid_set_cell_on (ix->pattern, 1, 1);
+	
+	return GoLUtils_make_canonical (ix->pattern, ix->canonical, &ix->rda, ix->temp_1, ix->temp_2);
+}
+
+// Returns the slot that holds hash, or the empty slot where it would be added
+static __force_inline u8 *StillDBIndex_int_find_slot (const StillDBIndex *ix, u64 hash)
+{
+	u64 slot_mask = ix->slot_cnt - 1;
+	u64 slot_ix = hash & slot_mask;
+	
+	while (TRUE)
+	{
+		u8 *slot = ix->slot + (slot_ix * STILLDB_INDEX_SLOT_SIZE);
+		u64 slot_hash = StillDB_get_u64 (slot);
+		if (slot_hash == hash || slot_hash == 0)
+			return slot;
+		
+		slot_ix = (slot_ix + 1) & slot_mask;
+	}
+}
+
+
+// External functions
+
+// Starts a new index file with room for max_entry_cnt still lifes. The file is filled in place through a memory map where possible, so the index doesn't have
+// to fit in memory, otherwise it is built in memory and written by StillDBIndex_close
+static __not_inline int StillDBIndex_create (StillDBIndex *ix, const char *filename, u64 max_entry_cnt)
+{
+	if (!ix || !filename)
+		return ffsc (__func__);
+	
+	memset (ix, 0, sizeof (StillDBIndex));
+	if (!StillDBIndex_int_init_hashing (ix))
+	{
+		StillDBIndex_int_free (ix);
+		return FALSE;
+	}
+	
+	ix->slot_cnt = STILLDB_INDEX_MIN_SLOT_CNT;
+	while (ix->slot_cnt < 2 * max_entry_cnt)
+		ix->slot_cnt *= 2;
+	
+	ix->data_size = STILLDB_INDEX_HEADER_SIZE + (ix->slot_cnt * STILLDB_INDEX_SLOT_SIZE);
+	ix->is_writable = TRUE;
+	ix->file = fopen (filename, "w+b");
+	if (!ix->file)
+	{
+		StillDBIndex_int_free (ix);
+		return FALSE;
+	}
+
+#ifdef STILLDB_INDEX_USE_MMAP
+	// A file extended with ftruncate reads as zeros, so all slots start empty
+	int fd = fileno (ix->file);
+	if (ftruncate (fd, (off_t) ix->data_size) == 0)
+	{
+		void *map = mmap (NULL, ix->data_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (map != MAP_FAILED)
+		{
+			ix->data = map;
+			ix->is_mapped = TRUE;
+		}
+	}
+#endif
+	
+	if (!ix->data)
+		ix->data = calloc (ix->data_size, 1);
+	
+	if (!ix->data)
+	{
+		StillDBIndex_int_free (ix);
+		return FALSE;
+	}
+	
+	ix->slot = ix->data + STILLDB_INDEX_HEADER_SIZE;
+	return TRUE;
+}
+
+// Opens an index for lookups. Returns FALSE if the file is not a valid index or its hashes are made differently
+static __not_inline int StillDBIndex_open (StillDBIndex *ix, const char *filename)
+{
+	if (!ix || !filename)
+		return ffsc (__func__);
+	
+	memset (ix, 0, sizeof (StillDBIndex));
+	ix->file = fopen (filename, "rb");
+	if (!ix->file || !StillDBIndex_int_init_hashing (ix))
+	{
+		StillDBIndex_int_free (ix);
+		return FALSE;
+	}
+	
+	u8 header [STILLDB_INDEX_HEADER_SIZE];
+	if (fread (header, 1, STILLDB_INDEX_HEADER_SIZE, ix->file) != STILLDB_INDEX_HEADER_SIZE || memcmp (header, "SLDI", 4) != 0 ||
+			StillDB_get_u32 (header + 4) != STILLDB_INDEX_FORMAT_VERSION)
+	{
+		StillDBIndex_int_free (ix);
+		return FALSE;
+	}
+	
+	ix->slot_cnt = StillDB_get_u64 (header + 8);
+	ix->entry_cnt = StillDB_get_u64 (header + 16);
+	ix->data_size = STILLDB_INDEX_HEADER_SIZE + (ix->slot_cnt * STILLDB_INDEX_SLOT_SIZE);
+	
+	if (ix->slot_cnt < STILLDB_INDEX_MIN_SLOT_CNT || (ix->slot_cnt & (ix->slot_cnt - 1)) != 0 || ix->slot_cnt > (u64_MAX / (4 * STILLDB_INDEX_SLOT_SIZE)) ||
+			ix->entry_cnt > ix->slot_cnt / 2 || StillDB_get_u64 (header + 24) != StillDBIndex_int_block_hash (ix) || fseek_s64 (ix->file, 0, SEEK_END) != 0 ||
+			(u64) ftell_s64 (ix->file) != ix->data_size)
+	{
+		StillDBIndex_int_free (ix);
+		return FALSE;
+	}
+
+#ifdef STILLDB_INDEX_USE_MMAP
+	void *map = mmap (NULL, ix->data_size, PROT_READ, MAP_SHARED, fileno (ix->file), 0);
+	if (map != MAP_FAILED)
+	{
+		ix->data = map;
+		ix->is_mapped = TRUE;
+	}
+#endif
+	
+	if (!ix->data)
+	{
+		ix->data = malloc (ix->data_size);
+		if (!ix->data || fseek (ix->file, 0, SEEK_SET) != 0 || fread (ix->data, 1, ix->data_size, ix->file) != ix->data_size)
+		{
+			StillDBIndex_int_free (ix);
+			return FALSE;
+		}
+	}
+	
+	ix->slot = ix->data + STILLDB_INDEX_HEADER_SIZE;
+	return TRUE;
+}
+
+// Prepares ix only for making hashes with StillDBIndex_hash_record and StillDBIndex_hash_grid, without an index file
+static __not_inline int StillDBIndex_create_hasher (StillDBIndex *ix)
+{
+	if (!ix)
+		return ffsc (__func__);
+	
+	memset (ix, 0, sizeof (StillDBIndex));
+	if (!StillDBIndex_int_init_hashing (ix))
+	{
+		StillDBIndex_int_free (ix);
+		return FALSE;
+	}
+	
+	return TRUE;
+}
+
+// Returns the canonical hash of the still life in a record
+static __not_inline u64 StillDBIndex_hash_record (StillDBIndex *ix, const StillDB_Record *rec)
+{
+	if (!ix || !ix->pattern || !rec)
+		return ffsc (__func__);
+	
+	StillDB_record_to_grid (rec, ix->pattern);
+	return GoLUtils_make_canonical (ix->pattern, ix->canonical, &ix->rda, ix->temp_1, ix->temp_2);
+}
+
+// Returns the canonical hash of a pattern in any grid. The pattern must fit in 64 by 64 cells
+static __not_inline u64 StillDBIndex_hash_grid (StillDBIndex *ix, const GoLGrid *gg)
+{
+	if (!ix || !ix->pattern || !gg)
+		return ffsc (__func__);
+	
+	GoLUtils_copy_to_top_left (gg, ix->pattern);
+	return GoLUtils_make_canonical (ix->pattern, ix->canonical, &ix->rda, ix->temp_1, ix->temp_2);
+}
+
+// Returns 1 if the still life was added, 0 if it was already in the index, -1 if it is in the index as another bit count or kind, and -2 if the index is
+// full. A pseudo still life that is already in the index without its number of parts gets it added
+static __not_inline s32 StillDBIndex_add (StillDBIndex *ix, u64 hash, s32 on_cnt, s32 kind, s32 part_cnt)
+{
+	if (!ix || !ix->slot || !ix->is_writable || on_cnt < 0 || on_cnt > 255 || (kind != STILLDB_KIND_STRICT && kind != STILLDB_KIND_PSEUDO) || part_cnt < 0 || part_cnt > 255)
+	{
+		ffsc (__func__);
+		return -1;
+	}
+	
+	if (hash == 0)
+		hash = 1;
+	
+	u8 *slot = StillDBIndex_int_find_slot (ix, hash);
+	if (StillDB_get_u64 (slot) == hash)
+	{
+		if (slot [8] != on_cnt || slot [9] != kind)
+			return -1;
+		
+		if (part_cnt > 0)
+			slot [10] = (u8) part_cnt;
+		
+		return 0;
+	}
+	
+	if (2 * (ix->entry_cnt + 1) > ix->slot_cnt)
+		return -2;
+	
+	StillDB_put_u64 (slot, hash);
+	slot [8] = (u8) on_cnt;
+	slot [9] = (u8) kind;
+	slot [10] = (u8) part_cnt;
+	
+	ix->entry_cnt++;
+	return 1;
+}
+
+// Returns TRUE if the hash is in the index, and then the bit count, kind and fewest stable parts (or 0) of the still life
+static __not_inline int StillDBIndex_lookup (const StillDBIndex *ix, u64 hash, s32 *on_cnt, s32 *kind, s32 *part_cnt)
+{
+	if (!ix || !ix->slot || !on_cnt || !kind || !part_cnt)
+		return ffsc (__func__);
+	
+	if (hash == 0)
+		hash = 1;
+	
+	const u8 *slot = StillDBIndex_int_find_slot (ix, hash);
+	if (StillDB_get_u64 (slot) != hash)
+		return FALSE;
+	
+	*on_cnt = slot [8];
+	*kind = slot [9];
+	*part_cnt = slot [10];
+	return TRUE;
+}
+
+// Writes the header of a new index and closes it, or just closes an index opened for lookups or a hasher. Returns FALSE on a write error
+static __not_inline int StillDBIndex_close (StillDBIndex *ix)
+{
+	if (!ix)
+		return ffsc (__func__);
+	
+	int success = TRUE;
+	if (ix->is_writable && ix->data)
+	{
+		memcpy (ix->data, "SLDI", 4);
+		StillDB_put_u32 (ix->data + 4, STILLDB_INDEX_FORMAT_VERSION);
+		StillDB_put_u64 (ix->data + 8, ix->slot_cnt);
+		StillDB_put_u64 (ix->data + 16, ix->entry_cnt);
+		StillDB_put_u64 (ix->data + 24, StillDBIndex_int_block_hash (ix));
+
+#ifdef STILLDB_INDEX_USE_MMAP
+		if (ix->is_mapped)
+			success = (msync (ix->data, ix->data_size, MS_SYNC) == 0);
+		else
+			success = (fwrite (ix->data, 1, ix->data_size, ix->file) == ix->data_size);
+#else
+		success = (fwrite (ix->data, 1, ix->data_size, ix->file) == ix->data_size);
+#endif
+		
+		if (fflush (ix->file) != 0)
+			success = FALSE;
+	}
+	
+	StillDBIndex_int_free (ix);
+	return success;
+}
@@ -0,0 +1,523 @@
+// Fast reading of text database files, with one still life per line as LifeHistory RLE or an apgcode, possibly followed by other columns. The whole file
+// is memory mapped if STILLDB_READER_USE_MMAP is defined and sys/mman.h and unistd.h are included, and otherwise read into memory. It is split into chunks
+// of about STILLDB_READER_CHUNK_SIZE bytes at line breaks, which can be decoded by several threads at once, and the still lifes are handed to a callback in
+// batches of up to STILLDB_READER_BATCH_SIZE records from consecutive lines of one chunk
+//
+// RLE is decoded straight into the 64-bit rows of a StillDB_Record, by or-ing in each run of on-cells with a single mask, instead of setting the cells one
+// at a time in a GoLGrid as GoLGrid_parse_life_history does. Apgcodes are parsed through a grid
+
+#define STILLDB_READER_CHUNK_SIZE (1024 * 1024)
+#define STILLDB_READER_BATCH_SIZE 1024
+#define STILLDB_READER_MAX_THREADS 256
+#define STILLDB_READER_MAX_APGCODE_SIZE 1024
+
+// Longer runs can only be in a line that is not a still life of the database, and are clamped so that counts and positions can't overflow
+#define STILLDB_READER_MAX_RUN_LENGTH (1024 * 1024)
+
+typedef struct
+{
+	s32 thread_ix;
+	s32 record_cnt;
+	StillDB_Record record [STILLDB_READER_BATCH_SIZE];
+	s64 line_number [STILLDB_READER_BATCH_SIZE];
+} StillDBReader_Batch;
+
+// Called for each batch of still lifes, and should return FALSE to stop reading. With more than one thread it is called from all of them at once, and the
+// batches come in no particular order
+typedef int (*StillDBReader_Callback) (void *context, const StillDBReader_Batch *batch);
+
+typedef struct
+{
+	s32 on_cnt;
+	s32 kind;
+	
+	// The whole file, either memory mapped or read into memory
+	char *data;
+	s64 data_size;
+	int is_mapped;
+	
+	// Chunk n starts at chunk_start [n] with line number chunk_first_line [n], and chunk_start [chunk_cnt] is data_size
+	s32 chunk_cnt;
+	s64 *chunk_start;
+	s64 *chunk_first_line;
+	
+	// Shared by the threads of StillDBReader_read
+	pthread_mutex_t mutex;
+	StillDBReader_Callback callback;
+	void *context;
+	s32 next_chunk_ix;
+	int stop;
+	
+	// The results of StillDBReader_read. invalid_line_number is the first line that is not a pattern of at most STILLDB_MAX_SIDE by STILLDB_MAX_SIDE cells,
+	// or 0 if reading stopped for another reason or not at all
+	s64 record_cnt;
+	s64 invalid_line_number;
+} StillDBReader;
+
+typedef struct
+{
+	StillDBReader *rd;
+	pthread_t thread;
+	int started;
+	GoLGrid *gg;
+	StillDBReader_Batch *batch;
+} StillDBReader_Thread;
+
+
+// Internal functions
+
+static __not_inline void StillDBReader_int_free (StillDBReader *rd)
+{
+	if (rd->data)
+	{
+#ifdef STILLDB_READER_USE_MMAP
+		if (rd->is_mapped)
+			munmap (rd->data, (size_t) rd->data_size);
+		else
+			free (rd->data);
+#else
+		free (rd->data);
+#endif
+	}
+	
+	free (rd->chunk_start);
+	free (rd->chunk_first_line);
+	
+	rd->data = NULL;
+	rd->chunk_start = NULL;
+	rd->chunk_first_line = NULL;
+}
+
+// Splits the file into chunks that end with a line break, except the last one, and counts the lines before each chunk
+static __not_inline int StillDBReader_int_make_chunks (StillDBReader *rd)
+{
+	s64 max_chunk_cnt = (rd->data_size / STILLDB_READER_CHUNK_SIZE) + 1;
+	rd->chunk_start = malloc ((max_chunk_cnt + 1) * sizeof (s64));
+	rd->chunk_first_line = malloc ((max_chunk_cnt + 1) * sizeof (s64));
+	if (!rd->chunk_start || !rd->chunk_first_line)
+		return FALSE;
+	
+	rd->chunk_cnt = 0;
+	s64 start = 0;
+	s64 line_number = 1;
+	
+	while (start < rd->data_size)
+	{
+		rd->chunk_start [rd->chunk_cnt] = start;
+		rd->chunk_first_line [rd->chunk_cnt] = line_number;
+		rd->chunk_cnt++;
+		
+		s64 wanted_end = start + STILLDB_READER_CHUNK_SIZE;
+		if (wanted_end >= rd->data_size)
+			break;
+		
+		const char *line_break = memchr (rd->data + wanted_end - 1, '\n', rd->data_size - (wanted_end - 1));
+		if (!line_break)
+			break;
+		
+		const char *chunk_end = line_break + 1;
+		const char *c = rd->data + start;
+		while ((c = memchr (c, '\n', chunk_end - c)) != NULL)
+		{
+			line_number++;
+			c++;
+		}
+		
+		start = chunk_end - rd->data;
+	}
+	
+	rd->chunk_start [rd->chunk_cnt] = rd->data_size;
+	return TRUE;
+}
+
+// Stores a completed row of RLE at line y, where the rows before the first non-empty one at top_y are not stored. Returns FALSE if the pattern gets too high
+static __force_inline int StillDBReader_int_put_row (StillDB_Record *rec, u64 row, s32 y, s32 *top_y, s32 *row_cnt)
+{
+	if (row == 0)
+		return TRUE;
+	
+	if (*top_y < 0)
+		*top_y = y;
+	
+	if (y - *top_y >= STILLDB_MAX_SIDE)
+		return FALSE;
+	
+	while (*row_cnt < y - *top_y)
+		rec->row [(*row_cnt)++] = 0;
+	
+	rec->row [(*row_cnt)++] = row;
+	return TRUE;
+}
+
+// Decodes LifeHistory RLE that ends at '!' or line_end. States other than 'o', 'A', 'C' and 'E' are off-cells, as in GoLGrid_parse_life_history with only
+// an on-cell grid. Each run of on-cells is or-ed into the current row with one mask, where x = 0 is the most significant bit, and the rows are shifted to the
+// left edge at the end
+static __force_inline int StillDBReader_int_decode_rle (const char *c, const char *line_end, StillDB_Record *rec)
+{
+	s32 x = 0;
+	s32 y = 0;
+	s32 top_y = -1;
+	s32 row_cnt = 0;
+	s32 min_x = 64;
+	s32 max_x = 0;
+	u64 row = 0;
+	
+	while (c < line_end && *c != '!')
+	{
+		char symbol = *c++;
+		if (symbol == ' ' || symbol == '\t')
+			continue;
+		
+		s32 cnt = 1;
+		if (symbol >= '0' && symbol <= '9')
+		{
+			cnt = symbol - '0';
+			while (c < line_end && *c >= '0' && *c <= '9')
+			{
+				cnt = (10 * cnt) + (*c++ - '0');
+				if (cnt > STILLDB_READER_MAX_RUN_LENGTH)
+					cnt = STILLDB_READER_MAX_RUN_LENGTH;
+			}
+			
+			if (c >= line_end)
+				return FALSE;
+			
+			symbol = *c++;
+		}
+		
+		if (symbol == 'o' || symbol == 'A' || symbol == 'C' || symbol == 'E')
+		{
+			if (cnt == 0)
+				continue;
+			
+			if (x + cnt > 64)
+				return FALSE;
+			
+			row |= (u64_MAX << (64 - cnt)) >> x;
+			if (x < min_x)
+				min_x = x;
+			
+			x += cnt;
+			if (x > max_x)
+				max_x = x;
+		}
+		else if (symbol == '.' || symbol == 'b' || symbol == 'B' || symbol == 'D' || symbol == 'F')
+		{
+			x += cnt;
+			if (x > 64)
+				x = 65;
+		}
+		else if (symbol == '$')
+		{
+			if (cnt == 0)
+				continue;
+			
+			if (!StillDBReader_int_put_row (rec, row, y, &top_y, &row_cnt))
+				return FALSE;
+			
+			row = 0;
+			x = 0;
+			y += cnt;
+			if (y > STILLDB_READER_MAX_RUN_LENGTH)
+				return FALSE;
+		}
+		else
+			return FALSE;
+	}
+	
+	if (!StillDBReader_int_put_row (rec, row, y, &top_y, &row_cnt) || row_cnt == 0)
+		return FALSE;
+	
+	if (min_x > 0)
+	{
+		s32 row_ix;
+		for (row_ix = 0; row_ix < row_cnt; row_ix++)
+			rec->row [row_ix] <<= min_x;
+	}
+	
+	rec->width = max_x - min_x;
+	rec->height = row_cnt;
+	return TRUE;
+}
+
+static __not_inline int StillDBReader_int_decode_apgcode (const char *line, const char *line_end, GoLGrid *gg, StillDB_Record *rec)
+{
+	const char *code_end = line;
+	while (code_end < line_end && *code_end != ' ' && *code_end != '\t')
+		code_end++;
+	
+	char code [STILLDB_READER_MAX_APGCODE_SIZE];
+	if (code_end - line >= STILLDB_READER_MAX_APGCODE_SIZE)
+		return FALSE;
+	
+	memcpy (code, line, code_end - line);
+	code [code_end - line] = '\0';
+	
+	if (!GoLGrid_parse_still_life_apgcode (code, 0, 0, gg) || GoLGrid_is_empty (gg) || gg->pop_y_off - gg->pop_y_on > STILLDB_MAX_SIDE ||
+			!StillDB_record_from_grid (gg, rec->on_cnt, rec->kind, rec))
+		return FALSE;
+	
+	rec->x = 0;
+	rec->y = 0;
+	return TRUE;
+}
+
+static __force_inline int StillDBReader_int_decode_line (const char *line, const char *line_end, s32 on_cnt, s32 kind, GoLGrid *gg, StillDB_Record *rec)
+{
+	rec->on_cnt = on_cnt;
+	rec->kind = kind;
+	rec->x = 0;
+	rec->y = 0;
+	
+	if (line_end - line >= 2 && line [0] == 'x' && line [1] == 's')
+		return StillDBReader_int_decode_apgcode (line, line_end, gg, rec);
+	else
+		return StillDBReader_int_decode_rle (line, line_end, rec);
+}
+
+static __not_inline void StillDBReader_int_stop (StillDBReader *rd, s64 invalid_line_number)
+{
+	pthread_mutex_lock (&rd->mutex);
+	
+	if (invalid_line_number > 0 && (rd->invalid_line_number == 0 || invalid_line_number < rd->invalid_line_number))
+		rd->invalid_line_number = invalid_line_number;
+	
+	rd->stop = TRUE;
+	pthread_mutex_unlock (&rd->mutex);
+}
+
+static __not_inline int StillDBReader_int_deliver_batch (StillDBReader_Thread *th)
+{
+	StillDBReader *rd = th->rd;
+	if (th->batch->record_cnt == 0)
+		return TRUE;
+	
+	if (rd->callback && !rd->callback (rd->context, th->batch))
+	{
+		StillDBReader_int_stop (rd, 0);
+		return FALSE;
+	}
+	
+	pthread_mutex_lock (&rd->mutex);
+	rd->record_cnt += th->batch->record_cnt;
+	pthread_mutex_unlock (&rd->mutex);
+	
+	th->batch->record_cnt = 0;
+	return TRUE;
+}
+
+// Decodes all lines of a chunk, and stops at the first invalid one, so that the lowest invalid line number reported by any thread is the first in the file
+static __not_inline int StillDBReader_int_decode_chunk (StillDBReader_Thread *th, s32 chunk_ix)
+{
+	StillDBReader *rd = th->rd;
+	StillDBReader_Batch *batch = th->batch;
+	
+	const char *line = rd->data + rd->chunk_start [chunk_ix];
+	const char *chunk_end = rd->data + rd->chunk_start [chunk_ix + 1];
+	s64 line_number = rd->chunk_first_line [chunk_ix];
+	
+	while (line < chunk_end)
+	{
+		const char *line_end = memchr (line, '\n', chunk_end - line);
+		const char *next_line = (line_end ? line_end + 1 : chunk_end);
+		if (!line_end)
+			line_end = chunk_end;
+		
+		if (line_end > line && line_end [-1] == '\r')
+			line_end--;
+		
+		if (line_end > line)
+		{
+			if (!StillDBReader_int_decode_line (line, line_end, rd->on_cnt, rd->kind, th->gg, &batch->record [batch->record_cnt]))
+			{
+				StillDBReader_int_stop (rd, line_number);
+				return FALSE;
+			}
+			
+			batch->line_number [batch->record_cnt++] = line_number;
+			if (batch->record_cnt == STILLDB_READER_BATCH_SIZE && !StillDBReader_int_deliver_batch (th))
+				return FALSE;
+		}
+		
+		line = next_line;
+		line_number++;
+	}
+	
+	return StillDBReader_int_deliver_batch (th);
+}
+
+static __not_inline void *StillDBReader_int_run_thread (void *arg)
+{
+	StillDBReader_Thread *th = (StillDBReader_Thread *) arg;
+	StillDBReader *rd = th->rd;
+	
+	while (TRUE)
+	{
+		pthread_mutex_lock (&rd->mutex);
+		
+		s32 chunk_ix = rd->next_chunk_ix;
+		int done = (rd->stop || chunk_ix >= rd->chunk_cnt);
+		if (!done)
+			rd->next_chunk_ix++;
+		
+		pthread_mutex_unlock (&rd->mutex);
+		
+		if (done || !StillDBReader_int_decode_chunk (th, chunk_ix))
+			break;
+	}
+	
+	return NULL;
+}
+
+
+// External functions
+
+// Decodes a line of a text database file without its line break, as LifeHistory RLE or an apgcode, either possibly followed by other columns, into a record
+// with the still life in the top-left corner. gg is only used for apgcodes, and must be a 64 bit wide grid with room for at least STILLDB_MAX_SIDE rows. Returns
+// FALSE if the line is not a pattern of at most STILLDB_MAX_SIDE by STILLDB_MAX_SIDE cells
+static __not_inline int StillDBReader_decode_line (const char *line, const char *line_end, s32 on_cnt, s32 kind, GoLGrid *gg, StillDB_Record *rec)
+{
+	if (!line || !line_end || !gg || !rec)
+		return ffsc (__func__);
+	
+	return StillDBReader_int_decode_line (line, line_end, on_cnt, kind, gg, rec);
+}
+
+// The bit count and kind of the still lifes are not recorded in a text file, and are given by the caller, usually from StillDB_get_category_from_filename
+static __not_inline int StillDBReader_open (StillDBReader *rd, const char *filename, s32 on_cnt, s32 kind)
+{
+	if (!rd || !filename)
+		return ffsc (__func__);
+	
+	memset (rd, 0, sizeof (StillDBReader));
+	rd->on_cnt = on_cnt;
+	rd->kind = kind;
+	
+	FILE *f = fopen (filename, "rb");
+	if (!f)
+		return FALSE;
+	
+	s64 size;
+	if (fseek_s64 (f, 0, SEEK_END) != 0 || (size = ftell_s64 (f)) < 0)
+	{
+		fclose (f);
+		return FALSE;
+	}
+	
+	rd->data_size = size;
+
+#ifdef STILLDB_READER_USE_MMAP
+	if (rd->data_size > 0)
+	{
+		void *map = mmap (NULL, (size_t) rd->data_size, PROT_READ, MAP_PRIVATE, fileno (f), 0);
+		if (map != MAP_FAILED)
+		{
+			posix_madvise (map, (size_t) rd->data_size, POSIX_MADV_SEQUENTIAL);
+			rd->data = map;
+			rd->is_mapped = TRUE;
+		}
+	}
+#endif
+	
+	if (!rd->data && rd->data_size > 0)
+	{
+		rd->data = malloc (rd->data_size);
+		if (!rd->data || fseek (f, 0, SEEK_SET) != 0 || fread (rd->data, 1, rd->data_size, f) != (size_t) rd->data_size)
+		{
+			fclose (f);
+			StillDBReader_int_free (rd);
+			return FALSE;
+		}
+	}
+	
+	fclose (f);
+	
+	if (!StillDBReader_int_make_chunks (rd))
+	{
+		StillDBReader_int_free (rd);
+		return FALSE;
+	}
+	
+	return TRUE;
+}
+
+static __not_inline void StillDBReader_close (StillDBReader *rd)
+{
+	if (!rd)
+	{
+		ffsc (__func__);
+		return;
+	}
+	
+	StillDBReader_int_free (rd);
+}
+
+// Decodes all still lifes of the file with thread_cnt threads, where the calling thread is one of them, and hands them to callback, or only counts them if
+// callback is NULL. With a single thread the batches come in the order of the file. Returns FALSE if a line is not a pattern, with its number in
+// rd->invalid_line_number, or if the callback stopped the reading or there was not enough memory. The number of still lifes handed to the callback is
+// in rd->record_cnt
+static __not_inline int StillDBReader_read (StillDBReader *rd, s32 thread_cnt, StillDBReader_Callback callback, void *context)
+{
+	if (!rd || thread_cnt < 1 || thread_cnt > STILLDB_READER_MAX_THREADS)
+		return ffsc (__func__);
+	
+	rd->callback = callback;
+	rd->context = context;
+	rd->next_chunk_ix = 0;
+	rd->stop = FALSE;
+	rd->record_cnt = 0;
+	rd->invalid_line_number = 0;
+	
+	if (thread_cnt > rd->chunk_cnt)
+		thread_cnt = (rd->chunk_cnt > 0 ? rd->chunk_cnt : 1);
+	
+	StillDBReader_Thread *th = calloc (thread_cnt, sizeof (StillDBReader_Thread));
+	int allocated = (th != NULL);
+	
+	s32 thread_ix;
+	for (thread_ix = 0; allocated && thread_ix < thread_cnt; thread_ix++)
+	{
+		th [thread_ix].rd = rd;
+		th [thread_ix].gg = GoLUtils_alloc_std_grid (0, 0, 64, STILLDB_MAX_SIDE);
+		th [thread_ix].batch = malloc (sizeof (StillDBReader_Batch));
+		if (!th [thread_ix].gg || !th [thread_ix].batch)
+			allocated = FALSE;
+		else
+		{
+			th [thread_ix].batch->thread_ix = thread_ix;
+			th [thread_ix].batch->record_cnt = 0;
+		}
+	}
+	
+	if (allocated)
+	{
+		pthread_mutex_init (&rd->mutex, NULL);
+		
+		// If a thread can't be started, the others take its share of the chunks
+		for (thread_ix = 1; thread_ix < thread_cnt; thread_ix++)
+			th [thread_ix].started = (pthread_create (&th [thread_ix].thread, NULL, StillDBReader_int_run_thread, &th [thread_ix]) == 0);
+		
+		StillDBReader_int_run_thread (&th [0]);
+		
+		for (thread_ix = 1; thread_ix < thread_cnt; thread_ix++)
+			if (th [thread_ix].started)
+				pthread_join (th [thread_ix].thread, NULL);
+		
+		pthread_mutex_destroy (&rd->mutex);
+	}
+	
+	if (th)
+	{
+		for (thread_ix = 0; thread_ix < thread_cnt; thread_ix++)
+		{
+			if (th [thread_ix].gg)
+				GoLUtils_free_std_grid (&th [thread_ix].gg);
+			
+			free (th [thread_ix].batch);
+		}
+		
+		free (th);
+	}
+	
+	return (allocated && !rd->stop);
+}
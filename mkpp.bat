@@ -1 +1 @@
-gcc postprocess.c -lm -o pp.exe -std=c99 -O3 -Wall -Wextra -Werror -fmax-errors=2 -Wno-unused-function -fno-tree-loop-distribute-patterns -march=native
+gcc postprocess.c -lm -o pp.exe -std=c99 -O3 -Wall -Wextra -Werror -fmax-errors=2 -Wno-unused-function -fno-tree-loop-distribute-patterns -march=native -pthread
@@ -0,0 +1 @@
+gcc scdb.c -lm -o scdb.exe -std=c99 -O3 -Wall -Wextra -Werror -fmax-errors=2 -Wno-unused-function -fno-tree-loop-distribute-patterns -march=native -pthread
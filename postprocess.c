@@ -1,14 +1,56 @@
+// For copy_file_range, which is used to append whole files without copying them through user space
+#ifdef __linux__
+	#define _GNU_SOURCE
+	#define USE_ZERO_COPY
+#endif
+
 #include <stdlib.h>
 #include <inttypes.h>
 #include <memory.h>
 #include <time.h>
 #include <string.h>
 #include <stdio.h>
+#include <pthread.h>
+
+#ifdef USE_ZERO_COPY
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
 
 #include "lib/lib.c"
+#include "lib/rect.c"
+#include "lib/celllist.c"
+#include "lib/objects.c"
+#include "lib/randomarray.c"
+#include "lib/golgrid.c"
+#include "lib/gridunsafe.c"
+#include "lib/gridmisc.c"
+#include "lib/golutils.c"
+#include "lib/stilldb.c"
+#include "lib/stilldbcontainer.c"
+#include "lib/runmanifest.c"
 
 #define MAX_FILENAME_SIZE 256
-#define MAX_LINE_LENGTH 1024
+#define BLOCK_SIZE (8 * 1024 * 1024)
+#define NEWLINE_SCAN_SIZE 4096
+#define SORT_MAX_KEY_SIZE (3 + (64 * 8))
+#define SORT_RUN_RECORD_HEADER_SIZE 8
+#define SORT_MIN_CHUNK_SIZE (1024 * 1024)
+#define SORT_MAX_MERGE_FAN_IN 64
+#define SORT_MAX_FILE_NUMBER 0xffff
+#define MAX_SORT_THREADS 64
+#define DEFAULT_SORT_THREADS 4
+#define DEFAULT_SORT_MEMORY_MB 1024
+#define MAX_COUNT_THREADS 64
+#define DEFAULT_COUNT_THREADS 4
+#define COUNT_MAX_LINE_SIZE 256
+
+#define COUNT_FILE_MISSING 0
+#define COUNT_FILE_MANIFEST 1
+#define COUNT_FILE_SEARCH_OUTPUT 2
+#define COUNT_FILE_DATABASE 3
+#define COUNT_FILE_KIND_CNT 4
 
 
 static __not_inline int make_filename (const char *template, s32 cur_file_number, s32 template_entry, s32 template_size, char *filename)
@@ -30,29 +72,152 @@ static __not_inline int make_filename (const char *template, s32 cur_file_number
 	return TRUE;
 }
 
-static __not_inline int read_line (FILE *f, char *buf)
+// Counts the newlines in buf, NEWLINE_SCAN_SIZE bytes at a time with an inner loop that GCC vectorizes
+static __not_inline s64 count_newlines (const u8 *buf, s64 size)
+{
+	s64 newline_cnt = 0;
+	while (size > 0)
+	{
+		s32 scan_size = (size < NEWLINE_SCAN_SIZE ? (s32) size : NEWLINE_SCAN_SIZE);
+		u32 scan_cnt = 0;
+		
+		s32 byte_ix;
+		for (byte_ix = 0; byte_ix < scan_size; byte_ix++)
+			scan_cnt += (buf [byte_ix] == '\n');
+		
+		newline_cnt += scan_cnt;
+		buf += scan_size;
+		size -= scan_size;
+	}
+	
+	return newline_cnt;
+}
+
+// Returns the size of the start of buf that holds at most max_line_cnt lines, ending right after the last newline if there are that many, and otherwise
+// taking all of buf. The number of complete lines in the returned size is stored in line_cnt
+static __not_inline s64 take_lines (const u8 *buf, s64 size, s64 max_line_cnt, s64 *line_cnt)
+{
+	s64 taken_size = 0;
+	*line_cnt = 0;
+	
+	// Whole scans are counted without looking at where the newlines are, until the scan that holds the last wanted one
+	while (taken_size < size)
+	{
+		s32 scan_size = (size - taken_size < NEWLINE_SCAN_SIZE ? (s32) (size - taken_size) : NEWLINE_SCAN_SIZE);
+		s64 scan_cnt = count_newlines (buf + taken_size, scan_size);
+		
+		if (*line_cnt + scan_cnt >= max_line_cnt)
+			break;
+		
+		*line_cnt += scan_cnt;
+		taken_size += scan_size;
+	}
+	
+	while (taken_size < size && *line_cnt < max_line_cnt)
+	{
+		const u8 *newline = memchr (buf + taken_size, '\n', size - taken_size);
+		if (!newline)
+			return size;
+		
+		taken_size = (newline + 1) - buf;
+		(*line_cnt)++;
+	}
+	
+	return taken_size;
+}
+
+static __not_inline int write_block (FILE *out_file, const char *out_filename, const u8 *buf, s64 size)
+{
+	if (fwrite (buf, 1, size, out_file) != (size_t) size)
+	{
+		fprintf (stderr, "Write error on out file %s\n", out_filename);
+		return FALSE;
+	}
+	
+	return TRUE;
+}
+
+#ifdef USE_ZERO_COPY
+// Appends a whole in file to the out file without copying the data through user space, and counts its lines by looking at the data through a read-only
+// mapping, which doesn't copy it either. The out file is created when there is something to write to it. Returns the number of lines, or -1 on failure. A last
+// line without a newline is counted too
+static __not_inline s64 append_file_zero_copy (FILE *in_file, const char *in_filename, FILE **out_file, const char *out_filename)
 {
-	if (!fgets (buf, MAX_LINE_LENGTH, f))
+	int in_fd = fileno (in_file);
+	
+	struct stat in_stat;
+	if (fstat (in_fd, &in_stat) != 0)
 	{
-		fclose (f);
+		fprintf (stderr, "Failed to read in file %s\n", in_filename);
+		return -1;
+	}
+	
+	s64 size = in_stat.st_size;
+	if (size == 0)
 		return 0;
+	
+	if (!*out_file)
+	{
+		*out_file = fopen (out_filename, "wb");
+		if (!*out_file)
+		{
+			fprintf (stderr, "Failed to open out file %s\n", out_filename);
+			return -1;
+		}
 	}
 	
-	if (strlen (buf) >= MAX_LINE_LENGTH - 4)
+	int out_fd = fileno (*out_file);
+	const u8 *data = mmap (NULL, size, PROT_READ, MAP_PRIVATE, in_fd, 0);
+	if (data == MAP_FAILED)
 	{
-		fprintf (stderr, "Line buffer overflow\n");
-		fclose (f);
+		fprintf (stderr, "Failed to map in file %s\n", in_filename);
 		return -1;
 	}
 	
-	return 1;
+	posix_madvise ((void *) data, size, POSIX_MADV_SEQUENTIAL);
+	s64 line_cnt = count_newlines (data, size) + (data [size - 1] != '\n' ? 1 : 0);
+	
+	// copy_file_range is not supported between all file systems, and then the mapping is written instead
+	s64 copied_size = 0;
+	while (copied_size < size)
+	{
+		ssize_t result = copy_file_range (in_fd, NULL, out_fd, NULL, size - copied_size, 0);
+		if (result <= 0)
+			break;
+		
+		copied_size += result;
+	}
+	
+	while (copied_size < size)
+	{
+		ssize_t result = write (out_fd, data + copied_size, size - copied_size);
+		if (result <= 0)
+		{
+			fprintf (stderr, "Write error on out file %s\n", out_filename);
+			munmap ((void *) data, size);
+			return -1;
+		}
+		
+		copied_size += result;
+	}
+	
+	munmap ((void *) data, size);
+	return line_cnt;
 }
+#endif
 
+// The in files are copied in large blocks, and when the out files are limited to a number of lines the line boundaries are found by scanning each block
+// for newlines. Lines can be of any length
 static __not_inline int post_process (const char *in_template, s32 in_template_entry, s32 in_template_size, s32 in_first_number, s32 in_last_number,
 		const char *out_template, s32 out_template_entry, s32 out_template_size, s64 lines_per_out_file)
 {
-	FILE *in_file = NULL;
-	s32 cur_in_file_number = in_first_number;
+	u8 *block = malloc (BLOCK_SIZE);
+	if (!block)
+	{
+		fprintf (stderr, "Out of memory allocating block buffer\n");
+		return FALSE;
+	}
+	
 	char in_filename [MAX_FILENAME_SIZE + 1];
 	
 	FILE *out_file = NULL;
@@ -61,145 +226,1626 @@ static __not_inline int post_process (const char *in_template, s32 in_template_e
 	
 	s64 pattern_cnt = 0;
 	s64 lines_in_cur_out_file = 0;
+	int success = TRUE;
 	
-	while (TRUE)
+	s32 cur_in_file_number;
+	for (cur_in_file_number = in_first_number; success && cur_in_file_number <= in_last_number; cur_in_file_number++)
 	{
-		char line_buf [MAX_LINE_LENGTH + 1];
+		make_filename (in_template, cur_in_file_number, in_template_entry, in_template_size, in_filename);
+		FILE *in_file = fopen (in_filename, "rb");
+		if (!in_file)
+		{
+			fprintf (stderr, "Failed to open in file %s\n", in_filename);
+			success = FALSE;
+			break;
+		}
+		
+#ifdef USE_ZERO_COPY
+		if (lines_per_out_file < 0)
+		{
+			make_filename (out_template, cur_out_file_number, out_template_entry, out_template_size, out_filename);
+			s64 line_cnt = append_file_zero_copy (in_file, in_filename, &out_file, out_filename);
+			fclose (in_file);
+			
+			if (line_cnt < 0)
+				success = FALSE;
+			else
+				pattern_cnt += line_cnt;
+			
+			continue;
+		}
+#endif
 		
-		if (in_file)
+		int last_byte_is_newline = TRUE;
+		while (success)
 		{
-			int result = read_line (in_file, line_buf);
-			if (result == -1)
+			s64 block_size = fread (block, 1, BLOCK_SIZE, in_file);
+			if (block_size == 0)
 			{
-				if (out_file)
-					fclose (out_file);
+				if (ferror (in_file))
+				{
+					fprintf (stderr, "Failed to read in file %s\n", in_filename);
+					success = FALSE;
+				}
 				
-				return FALSE;
+				break;
 			}
-			if (result == 0)
+			
+			last_byte_is_newline = (block [block_size - 1] == '\n');
+			
+			s64 block_pos = 0;
+			while (block_pos < block_size)
 			{
-				in_file = NULL;
-				cur_in_file_number++;
+				if (!out_file)
+				{
+					if (!make_filename (out_template, cur_out_file_number, out_template_entry, out_template_size, out_filename))
+					{
+						fprintf (stderr, "Overflow in out file template\n");
+						success = FALSE;
+						break;
+					}
+					
+					out_file = fopen (out_filename, "wb");
+					if (!out_file)
+					{
+						fprintf (stderr, "Failed to open out file %s\n", out_filename);
+						success = FALSE;
+						break;
+					}
+				}
+				
+				s64 line_cnt;
+				s64 max_line_cnt = (lines_per_out_file >= 0 ? lines_per_out_file - lines_in_cur_out_file : block_size + 1);
+				s64 take_size = take_lines (block + block_pos, block_size - block_pos, max_line_cnt, &line_cnt);
+				
+				if (!write_block (out_file, out_filename, block + block_pos, take_size))
+				{
+					success = FALSE;
+					break;
+				}
+				
+				block_pos += take_size;
+				pattern_cnt += line_cnt;
+				lines_in_cur_out_file += line_cnt;
+				
+				if (lines_per_out_file >= 0 && lines_in_cur_out_file >= lines_per_out_file)
+				{
+					if (fclose (out_file) != 0)
+					{
+						fprintf (stderr, "Write error on out file %s\n", out_filename);
+						success = FALSE;
+					}
+					
+					out_file = NULL;
+					cur_out_file_number++;
+					lines_in_cur_out_file = 0;
+				}
 			}
-			if (result == 1)
-				pattern_cnt++;
 		}
 		
-		if (!in_file)
+		fclose (in_file);
+		
+		// A last line without a newline is still a pattern, and the next in file continues on the same line of the out file
+		if (success && !last_byte_is_newline)
 		{
-			if (cur_in_file_number > in_last_number)
-			{
-				if (out_file)
-					fclose (out_file);
-				
-				fprintf (stderr, "Done: %" PRIi64 " patterns found\n", pattern_cnt);
-				return TRUE;
-			}
+			pattern_cnt++;
+			lines_in_cur_out_file++;
 			
-			make_filename (in_template, cur_in_file_number, in_template_entry, in_template_size, in_filename);
-			in_file = fopen (in_filename, "r");
-			if (!in_file)
+			if (lines_per_out_file >= 0 && lines_in_cur_out_file >= lines_per_out_file)
 			{
-				if (out_file)
-					fclose (out_file);
+				if (fclose (out_file) != 0)
+				{
+					fprintf (stderr, "Write error on out file %s\n", out_filename);
+					success = FALSE;
+				}
 				
-				fprintf (stderr, "Failed to open in file %s\n", in_filename);
-				return FALSE;
+				out_file = NULL;
+				cur_out_file_number++;
+				lines_in_cur_out_file = 0;
 			}
+		}
+	}
+	
+	if (out_file && fclose (out_file) != 0 && success)
+	{
+		fprintf (stderr, "Write error on out file %s\n", out_filename);
+		success = FALSE;
+	}
+	
+	free (block);
+	
+	if (success)
+		fprintf (stderr, "Done: %" PRIi64 " patterns found\n", pattern_cnt);
+	
+	return success;
+}
+
+// Sorting the lines of a series of numbered text files. Each line is keyed by the cells of its still life, packed row by row, so that the order doesn't depend on
+// how the RLE is written, and lines that are not RLE, like apgcodes, are keyed by their first word. Chunks of the in files are sorted in parallel by separate
+// threads and spilled to temporary run files, which are then merged. As the still lifes of a search are always written in the same orientation, two lines
+// with the same key are the same still life found twice
+
+typedef struct
+{
+	const char *line;
+	const u8 *key;
+	u32 line_size;
+	u16 key_size;
+	u16 file_number;
+} SortEntry;
+
+// Hands out chunks of whole lines of the in files to the sorting threads, one file after the other
+typedef struct
+{
+	pthread_mutex_t mutex;
+	const char *in_template;
+	s32 in_template_entry;
+	s32 in_template_size;
+	s32 cur_file_number;
+	s32 last_file_number;
+	FILE *file;
+	char *carry;
+	s64 carry_size;
+	
+	const char *out_filename;
+	s32 run_cnt;
+	s64 line_cnt;
+	int failed;
+} SortState;
+
+typedef struct
+{
+	SortState *ss;
+	s64 chunk_size;
+	pthread_t thread;
+} SortThread;
+
+typedef struct
+{
+	FILE *file;
+	u16 key_size;
+	u16 file_number;
+	u32 line_size;
+	u8 key [SORT_MAX_KEY_SIZE];
+	char *line;
+	u32 line_capacity;
+} RunReader;
+
+static __not_inline void make_run_filename (const char *out_filename, s32 run_ix, char *run_filename)
+{
+	sprintf (run_filename, "%s.run_%05d.tmp", out_filename, run_ix);
+}
+
+// Makes the key of a line of RLE, or of the first word of the line if it is not RLE of a pattern that fits in 64 by 64 cells. Returns the size of the key
+static __not_inline s32 make_sort_key (const char *line, s32 line_size, u8 *key)
+{
+	u64 row [64];
+	s32 x = 0;
+	s32 y = 0;
+	s32 count = 0;
+	int is_rle = FALSE;
+	
+	memset (row, 0, sizeof (row));
+	
+	s32 char_ix;
+	for (char_ix = 0; char_ix < line_size; char_ix++)
+	{
+		char c = line [char_ix];
+		if (c >= '0' && c <= '9')
+		{
+			count = (10 * count) + (c - '0');
+			if (count > 64)
+				break;
 			
 			continue;
 		}
 		
-		if (!out_file || (lines_per_out_file >= 0 && lines_in_cur_out_file >= lines_per_out_file))
+		s32 run = (count > 0 ? count : 1);
+		count = 0;
+		
+		if (c == '.' || c == 'b')
+			x += run;
+		else if (c == 'A' || c == 'o')
+		{
+			if (x + run > 64 || y >= 64)
+				break;
+			
+			row [y] |= ((run == 64 ? u64_MAX : (((u64) 1) << run) - 1) << (64 - x - run));
+			x += run;
+		}
+		else if (c == '$')
+		{
+			y += run;
+			x = 0;
+		}
+		else
+		{
+			is_rle = (c == '!');
+			break;
+		}
+	}
+	
+	if (!is_rle)
+	{
+		s32 word_size = 0;
+		while (word_size < line_size && word_size < SORT_MAX_KEY_SIZE - 1 && line [word_size] != ' ' && line [word_size] != '\t' && line [word_size] != '\r')
+			word_size++;
+		
+		key [0] = 1;
+		memcpy (key + 1, line, word_size);
+		return 1 + word_size;
+	}
+	
+	// The pattern is moved to the top-left corner, in case the RLE has empty rows or columns around it
+	s32 top_y = 0;
+	s32 bottom_y = (y < 64 ? y : 63);
+	while (top_y <= bottom_y && row [top_y] == 0)
+		top_y++;
+	while (bottom_y >= top_y && row [bottom_y] == 0)
+		bottom_y--;
+	
+	u64 or_of_rows = 0;
+	s32 row_ix;
+	for (row_ix = top_y; row_ix <= bottom_y; row_ix++)
+		or_of_rows |= row [row_ix];
+	
+	s32 left_x = (or_of_rows == 0 ? 0 : 63 - most_significant_bit_u64 (or_of_rows));
+	s32 width = (or_of_rows == 0 ? 0 : (64 - left_x) - least_significant_bit_u64 (or_of_rows));
+	s32 height = (bottom_y >= top_y ? 1 + bottom_y - top_y : 0);
+	s32 bytes_per_row = (width + 7) >> 3;
+	
+	key [0] = 0;
+	key [1] = (u8) width;
+	key [2] = (u8) height;
+	
+	s32 key_size = 3;
+	for (row_ix = top_y; row_ix <= bottom_y; row_ix++)
+	{
+		u64 shifted_row = row [row_ix] << left_x;
+		
+		s32 byte_ix;
+		for (byte_ix = 0; byte_ix < bytes_per_row; byte_ix++)
+			key [key_size++] = (u8) (shifted_row >> (56 - (8 * byte_ix)));
+	}
+	
+	return key_size;
+}
+
+static __force_inline int compare_keys (const u8 *key_1, s32 key_size_1, const u8 *key_2, s32 key_size_2)
+{
+	int order = memcmp (key_1, key_2, (key_size_1 < key_size_2 ? key_size_1 : key_size_2));
+	if (order != 0)
+		return order;
+	
+	return (key_size_1 > key_size_2) - (key_size_1 < key_size_2);
+}
+
+// Lines with the same key are ordered by in file, so that the first one found is the one that is kept
+static int compare_sort_entries (const void *arg_1, const void *arg_2)
+{
+	const SortEntry *entry_1 = (const SortEntry *) arg_1;
+	const SortEntry *entry_2 = (const SortEntry *) arg_2;
+	
+	int order = compare_keys (entry_1->key, entry_1->key_size, entry_2->key, entry_2->key_size);
+	if (order != 0)
+		return order;
+	
+	return (entry_1->file_number > entry_2->file_number) - (entry_1->file_number < entry_2->file_number);
+}
+
+// Reads the next chunk of whole lines into buf. A chunk never holds lines from more than one in file, and the last line of a file doesn't need a newline.
+// Returns the size of the chunk, 0 when all in files are read, or -1 on failure
+static __not_inline s64 read_sort_chunk (SortState *ss, char *buf, s64 buf_size, s32 *file_number)
+{
+	pthread_mutex_lock (&ss->mutex);
+	s64 size = -1;
+	
+	while (!ss->failed)
+	{
+		if (!ss->file)
 		{
-			if (out_file && (lines_per_out_file >= 0 && lines_in_cur_out_file >= lines_per_out_file))
+			if (ss->cur_file_number > ss->last_file_number)
 			{
-				fclose (out_file);
-				cur_out_file_number++;
-				lines_in_cur_out_file = 0;
+				size = 0;
+				break;
 			}
 			
-			if (!make_filename (out_template, cur_out_file_number, out_template_entry, out_template_size, out_filename))
+			char in_filename [MAX_FILENAME_SIZE + 1];
+			make_filename (ss->in_template, ss->cur_file_number, ss->in_template_entry, ss->in_template_size, in_filename);
+			
+			ss->file = fopen (in_filename, "rb");
+			if (!ss->file)
 			{
-				fclose (in_file);
-				fprintf (stderr, "Overflow in out file template\n");
-				return FALSE;
+				fprintf (stderr, "Failed to open in file %s\n", in_filename);
+				ss->failed = TRUE;
+				break;
 			}
-			
-			out_file = fopen (out_filename, "w");
-			if (!out_file)
+		}
+		
+		memcpy (buf, ss->carry, ss->carry_size);
+		size = ss->carry_size + fread (buf + ss->carry_size, 1, buf_size - ss->carry_size, ss->file);
+		ss->carry_size = 0;
+		*file_number = ss->cur_file_number;
+		
+		if (size < buf_size)
+		{
+			if (ferror (ss->file))
 			{
-				fclose (in_file);
-				fprintf (stderr, "Failed to open out file %s\n", out_filename);
-				return FALSE;
+				fprintf (stderr, "Failed to read in file %d\n", ss->cur_file_number);
+				ss->failed = TRUE;
+				size = -1;
+				break;
 			}
+			
+			fclose (ss->file);
+			ss->file = NULL;
+			ss->cur_file_number++;
+			
+			if (size == 0)
+				continue;
+			
+			break;
 		}
 		
-		s32 line_size = strlen (line_buf);
-		s32 written_size = fwrite (line_buf, sizeof (char), line_size, out_file);
-		if (written_size < line_size)
+		const char *last_newline = NULL;
+		s64 search_ix;
+		for (search_ix = size - 1; search_ix >= 0 && !last_newline; search_ix--)
+			if (buf [search_ix] == '\n')
+				last_newline = buf + search_ix;
+		
+		if (!last_newline)
 		{
-			fclose (in_file);
-			fclose (out_file);
-			fprintf (stderr, "Write error on out file %s\n", out_filename);
-			return FALSE;
+			fprintf (stderr, "Line longer than %" PRIi64 " bytes in in file %d, use more memory\n", buf_size, ss->cur_file_number);
+			ss->failed = TRUE;
+			size = -1;
+			break;
 		}
 		
-		lines_in_cur_out_file++;
+		ss->carry_size = (buf + size) - (last_newline + 1);
+		memcpy (ss->carry, last_newline + 1, ss->carry_size);
+		size -= ss->carry_size;
+		break;
 	}
+	
+	pthread_mutex_unlock (&ss->mutex);
+	return size;
 }
 
-static __not_inline int verify_template (const char *template, int must_be_template, char *filename, s32 *template_entry, s32 *template_size)
+static __not_inline int write_run_record (FILE *f, const u8 *key, u16 key_size, u16 file_number, const char *line, u32 line_size)
 {
-	strcpy (filename, template);
-	*template_entry = 0;
-	*template_size = 0;
+	u8 header [SORT_RUN_RECORD_HEADER_SIZE];
+	header [0] = (u8) key_size;
+	header [1] = (u8) (key_size >> 8);
+	header [2] = (u8) file_number;
+	header [3] = (u8) (file_number >> 8);
+	header [4] = (u8) line_size;
+	header [5] = (u8) (line_size >> 8);
+	header [6] = (u8) (line_size >> 16);
+	header [7] = (u8) (line_size >> 24);
 	
-	s32 template_ix = 0;
-	while (template [template_ix] != '\0')
+	return (fwrite (header, 1, SORT_RUN_RECORD_HEADER_SIZE, f) == SORT_RUN_RECORD_HEADER_SIZE && fwrite (key, 1, key_size, f) == key_size &&
+			fwrite (line, 1, line_size, f) == line_size);
+}
+
+// Returns 1 if a record was read, 0 at the end of the run and -1 on failure
+static __not_inline int read_run_record (RunReader *rr)
+{
+	u8 header [SORT_RUN_RECORD_HEADER_SIZE];
+	size_t header_size = fread (header, 1, SORT_RUN_RECORD_HEADER_SIZE, rr->file);
+	if (header_size == 0 && !ferror (rr->file))
+		return 0;
+	
+	if (header_size != SORT_RUN_RECORD_HEADER_SIZE)
+		return -1;
+	
+	rr->key_size = header [0] | (header [1] << 8);
+	rr->file_number = header [2] | (header [3] << 8);
+	rr->line_size = header [4] | (header [5] << 8) | (header [6] << 16) | ((u32) header [7] << 24);
+	
+	if (rr->key_size > SORT_MAX_KEY_SIZE)
+		return -1;
+	
+	if (rr->line_size > rr->line_capacity)
 	{
-		if (template [template_ix] == '#')
-			filename [template_ix] = '0';
-		template_ix++;
+		char *line = realloc (rr->line, rr->line_size);
+		if (!line)
+			return -1;
+		
+		rr->line = line;
+		rr->line_capacity = rr->line_size;
 	}
 	
-	template_ix = 0;
-	s32 hash_on = -1;
-	s32 hash_off = -1;
+	return (fread (rr->key, 1, rr->key_size, rr->file) == rr->key_size && fread (rr->line, 1, rr->line_size, rr->file) == rr->line_size ? 1 : -1);
+}
+
+// Grows a buffer to hold at least needed_size bytes. Returns FALSE if out of memory
+static __not_inline int grow_buffer (void **buf, s64 *capacity, s64 needed_size)
+{
+	if (needed_size <= *capacity)
+		return TRUE;
 	
-	while (TRUE)
+	s64 new_capacity = 2 * (*capacity);
+	if (new_capacity < needed_size)
+		new_capacity = needed_size;
+	
+	void *new_buf = realloc (*buf, new_capacity);
+	if (!new_buf)
+		return FALSE;
+	
+	*buf = new_buf;
+	*capacity = new_capacity;
+	return TRUE;
+}
+
+static __not_inline void *run_sort_thread (void *arg)
+{
+	SortThread *th = (SortThread *) arg;
+	SortState *ss = th->ss;
+	
+	s64 entry_capacity = (th->chunk_size / 32) * sizeof (SortEntry);
+	s64 key_arena_capacity = th->chunk_size / 2;
+	char *chunk = malloc (th->chunk_size);
+	SortEntry *entry = malloc (entry_capacity);
+	u8 *key_arena = malloc (key_arena_capacity);
+	int success = (chunk && entry && key_arena);
+	
+	while (success)
 	{
-		char c = template [template_ix];
+		s32 file_number;
+		s64 chunk_size = read_sort_chunk (ss, chunk, th->chunk_size, &file_number);
+		if (chunk_size <= 0)
+			break;
 		
-		if (c != '#')
-			if (hash_on >= 0 && hash_off < 0)
-				hash_off = template_ix;
+		s64 entry_cnt = 0;
+		s64 key_arena_size = 0;
+		s64 line_start = 0;
 		
-		if (c == '\0')
+		while (success && line_start < chunk_size)
 		{
-			if (must_be_template && hash_off < 0)
-				return FALSE;
+			const char *newline = memchr (chunk + line_start, '\n', chunk_size - line_start);
+			s64 line_end = (newline ? newline - chunk : chunk_size);
 			
-			*template_entry = hash_on;
-			*template_size = hash_off - hash_on;
-			return TRUE;
+			// Empty lines hold no pattern, and a line ending in CR LF is the same pattern as one ending in LF
+			s64 line_size = line_end - line_start;
+			if (line_size > 0 && chunk [line_start + line_size - 1] == '\r')
+				line_size--;
+			
+			if (line_size > 0)
+			{
+				success = (grow_buffer ((void **) &entry, &entry_capacity, (entry_cnt + 1) * sizeof (SortEntry)) &&
+						grow_buffer ((void **) &key_arena, &key_arena_capacity, key_arena_size + SORT_MAX_KEY_SIZE));
+				if (!success)
+					break;
+				
+				SortEntry *e = &entry [entry_cnt++];
+				e->line = chunk + line_start;
+				e->line_size = line_size;
+				e->file_number = (u16) file_number;
+				e->key_size = make_sort_key (e->line, line_size, key_arena + key_arena_size);
+				key_arena_size += e->key_size;
+			}
+			
+			line_start = line_end + 1;
 		}
 		
-		if (c == '#')
+		if (!success)
 		{
-			if (hash_off >= 0)
-				return FALSE;
-			if (hash_on < 0)
-				hash_on = template_ix;
+			fprintf (stderr, "Out of memory sorting lines\n");
+			break;
 		}
 		
-		template_ix++;
+		// The key arena may have moved while it grew, so the keys are only pointed to now
+		const u8 *key = key_arena;
+		s64 entry_ix;
+		for (entry_ix = 0; entry_ix < entry_cnt; entry_ix++)
+		{
+			entry [entry_ix].key = key;
+			key += entry [entry_ix].key_size;
+		}
+		
+		qsort (entry, entry_cnt, sizeof (SortEntry), compare_sort_entries);
+		
+		pthread_mutex_lock (&ss->mutex);
+		s32 run_ix = ss->run_cnt++;
+		ss->line_cnt += entry_cnt;
+		pthread_mutex_unlock (&ss->mutex);
+		
+		char run_filename [MAX_FILENAME_SIZE + 32];
+		make_run_filename (ss->out_filename, run_ix, run_filename);
+		
+		FILE *run_file = fopen (run_filename, "wb");
+		success = (run_file != NULL);
+		
+		for (entry_ix = 0; success && entry_ix < entry_cnt; entry_ix++)
+			success = write_run_record (run_file, entry [entry_ix].key, entry [entry_ix].key_size, entry [entry_ix].file_number, entry [entry_ix].line,
+					entry [entry_ix].line_size);
+		
+		if (run_file && fclose (run_file) != 0)
+			success = FALSE;
+		
+		if (!success)
+			fprintf (stderr, "Write error on temporary file %s\n", run_filename);
+	}
+	
+	if (!chunk || !entry || !key_arena)
+		fprintf (stderr, "Out of memory allocating sort buffers\n");
+	
+	if (!success)
+	{
+		pthread_mutex_lock (&ss->mutex);
+		ss->failed = TRUE;
+		pthread_mutex_unlock (&ss->mutex);
+	}
+	
+	free (chunk);
+	free (key_arena);
+	free (entry);
+	return NULL;
+}
+
+static __force_inline int compare_run_readers (const RunReader *rr_1, const RunReader *rr_2)
+{
+	int order = compare_keys (rr_1->key, rr_1->key_size, rr_2->key, rr_2->key_size);
+	if (order != 0)
+		return order;
+	
+	return (rr_1->file_number > rr_2->file_number) - (rr_1->file_number < rr_2->file_number);
+}
+
+static __not_inline void sift_down_run_heap (const RunReader *rr, s32 *heap, s32 heap_size, s32 heap_ix)
+{
+	while (TRUE)
+	{
+		s32 lowest_ix = heap_ix;
+		s32 child_ix = (2 * heap_ix) + 1;
+		
+		if (child_ix < heap_size && compare_run_readers (&rr [heap [child_ix]], &rr [heap [lowest_ix]]) < 0)
+			lowest_ix = child_ix;
+		if (child_ix + 1 < heap_size && compare_run_readers (&rr [heap [child_ix + 1]], &rr [heap [lowest_ix]]) < 0)
+			lowest_ix = child_ix + 1;
+		
+		if (lowest_ix == heap_ix)
+			return;
+		
+		s32 temp = heap [heap_ix];
+		heap [heap_ix] = heap [lowest_ix];
+		heap [lowest_ix] = temp;
+		heap_ix = lowest_ix;
 	}
 }
 
-static __not_inline int main_do (int argc, const char *const *argv)
+// Merges run_cnt runs starting at first_run_ix, and deletes them. With out_run_ix >= 0 the result is written as a new run, otherwise the lines are written
+// to out_file, and each line with the same key as the line before is reported as a duplicate and left out
+static __not_inline int merge_runs (const char *out_filename, s32 first_run_ix, s32 run_cnt, s32 out_run_ix, FILE *out_file, s64 *line_cnt, s64 *duplicate_cnt)
 {
-	int usage_fail = FALSE;
+	RunReader *rr = calloc (run_cnt, sizeof (RunReader));
+	s32 *heap = malloc (run_cnt * sizeof (s32));
+	int success = (rr && heap);
+	
+	char run_filename [MAX_FILENAME_SIZE + 32];
+	FILE *out_run = NULL;
+	if (success && out_run_ix >= 0)
+	{
+		make_run_filename (out_filename, out_run_ix, run_filename);
+		out_run = fopen (run_filename, "wb");
+		success = (out_run != NULL);
+	}
+	
+	s32 heap_size = 0;
+	s32 run_ix;
+	for (run_ix = 0; success && run_ix < run_cnt; run_ix++)
+	{
+		make_run_filename (out_filename, first_run_ix + run_ix, run_filename);
+		rr [run_ix].file = fopen (run_filename, "rb");
+		
+		int result = (rr [run_ix].file ? read_run_record (&rr [run_ix]) : -1);
+		if (result < 0)
+			success = FALSE;
+		else if (result > 0)
+			heap [heap_size++] = run_ix;
+	}
+	
+	s32 heap_ix;
+	for (heap_ix = (heap_size / 2) - 1; success && heap_ix >= 0; heap_ix--)
+		sift_down_run_heap (rr, heap, heap_size, heap_ix);
+	
+	u8 prev_key [SORT_MAX_KEY_SIZE];
+	s32 prev_key_size = -1;
+	s32 prev_file_number = 0;
+	
+	while (success && heap_size > 0)
+	{
+		RunReader *top = &rr [heap [0]];
+		
+		if (out_run)
+			success = write_run_record (out_run, top->key, top->key_size, top->file_number, top->line, top->line_size);
+		else if (prev_key_size >= 0 && compare_keys (prev_key, prev_key_size, top->key, top->key_size) == 0)
+		{
+			fprintf (stderr, "Duplicate in files %d and %d: %.*s\n", prev_file_number, top->file_number, (int) top->line_size, top->line);
+			(*duplicate_cnt)++;
+		}
+		else
+		{
+			success = (fwrite (top->line, 1, top->line_size, out_file) == top->line_size && fputc ('\n', out_file) != EOF);
+			(*line_cnt)++;
+			
+			memcpy (prev_key, top->key, top->key_size);
+			prev_key_size = top->key_size;
+			prev_file_number = top->file_number;
+		}
+		
+		int result = read_run_record (top);
+		if (result < 0)
+			success = FALSE;
+		else if (result == 0)
+			heap [0] = heap [--heap_size];
+		
+		sift_down_run_heap (rr, heap, heap_size, 0);
+	}
+	
+	if (out_run && fclose (out_run) != 0)
+		success = FALSE;
+	
+	for (run_ix = 0; rr && run_ix < run_cnt; run_ix++)
+	{
+		if (rr [run_ix].file)
+			fclose (rr [run_ix].file);
+		
+		free (rr [run_ix].line);
+		make_run_filename (out_filename, first_run_ix + run_ix, run_filename);
+		remove (run_filename);
+	}
+	
+	free (rr);
+	free (heap);
+	
+	if (!success)
+		fprintf (stderr, "Failed to merge temporary files of %s\n", out_filename);
+	
+	return success;
+}
+
+// Sorts all lines of the in files into one out file, leaving out and reporting duplicates. Returns FALSE if anything failed or any duplicates were found
+static __not_inline int sort_files (const char *in_template, s32 in_template_entry, s32 in_template_size, s32 in_first_number, s32 in_last_number,
+		const char *out_filename, s32 thread_cnt, s64 memory_limit)
+{
+	SortState ss;
+	memset (&ss, 0, sizeof (SortState));
+	pthread_mutex_init (&ss.mutex, NULL);
+	ss.in_template = in_template;
+	ss.in_template_entry = in_template_entry;
+	ss.in_template_size = in_template_size;
+	ss.cur_file_number = in_first_number;
+	ss.last_file_number = in_last_number;
+	ss.out_filename = out_filename;
+	
+	// Each thread has its chunk of text, an entry for every 32 bytes of it and half its size for the keys, and the reader has one more chunk for the carry.
+	// Files with lines much shorter than 32 bytes need more entries, which are grown as needed beyond the memory limit
+	s64 chunk_size = (s64) (memory_limit / ((thread_cnt * (1.5 + (sizeof (SortEntry) / 32.0))) + 1.0));
+	if (chunk_size < SORT_MIN_CHUNK_SIZE)
+		chunk_size = SORT_MIN_CHUNK_SIZE;
+	
+	SortThread *th = malloc (thread_cnt * sizeof (SortThread));
+	ss.carry = malloc (chunk_size);
+	if (!th || !ss.carry)
+	{
+		fprintf (stderr, "Out of memory allocating sort buffers\n");
+		return FALSE;
+	}
+	
+	s32 thread_ix;
+	for (thread_ix = 0; thread_ix < thread_cnt; thread_ix++)
+	{
+		th [thread_ix].ss = &ss;
+		th [thread_ix].chunk_size = chunk_size;
+		
+		if (pthread_create (&th [thread_ix].thread, NULL, run_sort_thread, &th [thread_ix]) != 0)
+		{
+			fprintf (stderr, "Failed to start sort thread\n");
+			exit (EXIT_FAILURE);
+		}
+	}
+	
+	for (thread_ix = 0; thread_ix < thread_cnt; thread_ix++)
+		pthread_join (th [thread_ix].thread, NULL);
+	
+	if (ss.file)
+		fclose (ss.file);
+	
+	free (th);
+	free (ss.carry);
+	
+	FILE *out_file = (ss.failed ? NULL : fopen (out_filename, "wb"));
+	if (!ss.failed && !out_file)
+		fprintf (stderr, "Failed to open out file %s\n", out_filename);
+	
+	// Too many runs to open at the same time are merged into bigger runs first
+	s32 first_run_ix = 0;
+	s32 run_off = ss.run_cnt;
+	int success = (out_file != NULL);
+	
+	while (success && run_off - first_run_ix > SORT_MAX_MERGE_FAN_IN)
+	{
+		success = merge_runs (out_filename, first_run_ix, SORT_MAX_MERGE_FAN_IN, run_off, NULL, NULL, NULL);
+		first_run_ix += SORT_MAX_MERGE_FAN_IN;
+		run_off++;
+	}
+	
+	s64 line_cnt = 0;
+	s64 duplicate_cnt = 0;
+	if (success)
+		success = merge_runs (out_filename, first_run_ix, run_off - first_run_ix, -1, out_file, &line_cnt, &duplicate_cnt);
+	
+	if (out_file && fclose (out_file) != 0 && success)
+	{
+		fprintf (stderr, "Write error on out file %s\n", out_filename);
+		success = FALSE;
+	}
+	
+	if (!success)
+	{
+		s32 run_ix;
+		for (run_ix = first_run_ix; run_ix < run_off; run_ix++)
+		{
+			char run_filename [MAX_FILENAME_SIZE + 32];
+			make_run_filename (out_filename, run_ix, run_filename);
+			remove (run_filename);
+		}
+		
+		return FALSE;
+	}
+	
+	fprintf (stderr, "Done: %" PRIi64 " patterns sorted, %" PRIi64 " duplicates\n", line_cnt, duplicate_cnt);
+	return (duplicate_cnt == 0);
+}
+
+// Adds the counts of the subset in rm to the total, which is taken as the first subset if subset_cnt_read is 0. The subset must be from a search with the same
+// bit counts, subsets and options as the ones added before, and when the in files are numbered, the subset given by the number of its file. Returns FALSE
+// after saying why otherwise
+static __not_inline int add_subset_counts (RunManifest *total, s32 *subset_cnt_read, const RunManifest *rm, const char *in_filename, s32 in_template_entry,
+		s32 cur_in_file_number)
+{
+	if (*subset_cnt_read > 0 && (rm->min_on_cnt != total->min_on_cnt || rm->max_on_cnt != total->max_on_cnt || rm->subset_cnt != total->subset_cnt ||
+			strcmp (rm->options, total->options) != 0))
+	{
+		printf ("%s is from a search with other on-cells, subsets or options than the first one\n", in_filename);
+		return FALSE;
+	}
+	
+	if (in_template_entry >= 0 && rm->subset != cur_in_file_number)
+	{
+		printf ("%s is for subset %d\n", in_filename, rm->subset);
+		return FALSE;
+	}
+	
+	if (*subset_cnt_read == 0)
+	{
+		total->min_on_cnt = rm->min_on_cnt;
+		total->max_on_cnt = rm->max_on_cnt;
+		total->subset_cnt = rm->subset_cnt;
+		strcpy (total->options, rm->options);
+	}
+	
+	(*subset_cnt_read)++;
+	total->op_cnt += rm->op_cnt;
+	total->not_stable_cnt += rm->not_stable_cnt;
+	total->not_canonical_cnt += rm->not_canonical_cnt;
+	total->not_connected_cnt += rm->not_connected_cnt;
+	
+	s32 on_cnt;
+	for (on_cnt = rm->min_on_cnt; on_cnt <= rm->max_on_cnt; on_cnt++)
+	{
+		total->strict_cnt [on_cnt] += rm->strict_cnt [on_cnt];
+		total->pseudo_cnt [on_cnt] += rm->pseudo_cnt [on_cnt];
+		
+		s32 part_cnt;
+		for (part_cnt = 3; part_cnt <= RUNMANIFEST_MAX_PART_CNT; part_cnt++)
+			total->pseudo_part_cnt [on_cnt] [part_cnt] += rm->pseudo_part_cnt [on_cnt] [part_cnt];
+	}
+	
+	return TRUE;
+}
+
+// Prints the totals of each bit count like the result of a search. They are only for the full search space if no file was missing or invalid and all subsets
+// were added
+static __not_inline void print_subset_counts (const RunManifest *total, s32 subset_cnt_read, int all_files_valid)
+{
+	int is_full_search = (all_files_valid && (total->subset_cnt == 0 ? subset_cnt_read == 1 : subset_cnt_read == total->subset_cnt));
+	
+	s32 on_cnt;
+	for (on_cnt = total->min_on_cnt; on_cnt <= total->max_on_cnt; on_cnt++)
+	{
+		printf ("\nNumber of on-cells: %10d\n", on_cnt);
+		if (is_full_search)
+			printf ("Result for full search space:\n");
+		else
+			printf ("Result for %d of %d subsets of search space:\n", subset_cnt_read, total->subset_cnt);
+		
+		printf ("Strict still lifes: %10" PRIu64 "\n", total->strict_cnt [on_cnt]);
+		printf ("Pseudo still lifes: %10" PRIu64 "\n", total->pseudo_cnt [on_cnt]);
+		
+		s32 part_cnt;
+		for (part_cnt = 3; part_cnt <= RUNMANIFEST_MAX_PART_CNT; part_cnt++)
+			if (total->pseudo_part_cnt [on_cnt] [part_cnt] > 0)
+				printf ("  in %2d stable parts: %10" PRIu64 "\n", part_cnt, total->pseudo_part_cnt [on_cnt] [part_cnt]);
+	}
+}
+
+// Adds up the counts of the manifests written by the subsets of a search, checking that each one is complete and that they are from the same search. The
+// totals are printed like the result of a search, so they can be compared with that or given to "StillCount v -c"
+static __not_inline int sum_manifests (const char *in_template, s32 in_template_entry, s32 in_template_size, s32 in_first_number, s32 in_last_number)
+{
+	double start_time = get_wall_time ();
+	
+	RunManifest *rm = malloc (sizeof (RunManifest));
+	RunManifest *total = malloc (sizeof (RunManifest));
+	if (!rm || !total)
+	{
+		fprintf (stderr, "Out of memory allocating manifests\n");
+		free (rm);
+		free (total);
+		return FALSE;
+	}
+	
+	RunManifest_init (rm);
+	RunManifest_init (total);
+	
+	char in_filename [MAX_FILENAME_SIZE + 1];
+	s32 read_cnt = 0;
+	s32 missing_cnt = 0;
+	s32 invalid_cnt = 0;
+	s64 output_cnt = 0;
+	u64 output_size = 0;
+	
+	s32 cur_in_file_number;
+	for (cur_in_file_number = in_first_number; cur_in_file_number <= in_last_number; cur_in_file_number++)
+	{
+		make_filename (in_template, cur_in_file_number, in_template_entry, in_template_size, in_filename);
+		FILE *in_file = fopen (in_filename, "r");
+		if (!in_file)
+		{
+			printf ("Missing manifest %s\n", in_filename);
+			missing_cnt++;
+			continue;
+		}
+		
+		s32 error_line;
+		int is_valid = RunManifest_read (rm, in_file, &error_line);
+		fclose (in_file);
+		
+		if (!is_valid)
+		{
+			if (error_line > 0)
+				printf ("Invalid line %d in manifest %s\n", error_line, in_filename);
+			else
+				printf ("Incomplete manifest %s\n", in_filename);
+			
+			invalid_cnt++;
+			continue;
+		}
+		
+		// Each file number in the template is the subset of the manifest
+		if (!add_subset_counts (total, &read_cnt, rm, in_filename, in_template_entry, cur_in_file_number))
+		{
+			invalid_cnt++;
+			continue;
+		}
+		
+		s32 output_ix;
+		for (output_ix = 0; output_ix < rm->output_cnt; output_ix++)
+			output_size += rm->output [output_ix].size;
+		
+		output_cnt += rm->output_cnt;
+	}
+	
+	double sum_time = get_wall_time () - start_time;
+	printf ("%d manifests read, %d missing and %d invalid in %.3f s\n", read_cnt, missing_cnt, invalid_cnt, sum_time);
+	
+	if (read_cnt > 0)
+	{
+		printf ("Options: %s\n", total->options);
+		printf ("Outputs: %" PRIi64 " with %" PRIu64 " bytes\n", output_cnt, output_size);
+		printf ("Not stable = %" PRIu64 ", not canonical = %" PRIu64 ", not connected = %" PRIu64 "\n", total->not_stable_cnt, total->not_canonical_cnt,
+				total->not_connected_cnt);
+		printf ("Search operations = %" PRIu64 "\n", total->op_cnt);
+		
+		print_subset_counts (total, read_cnt, (missing_cnt == 0 && invalid_cnt == 0));
+	}
+	
+	RunManifest_free (rm);
+	RunManifest_free (total);
+	free (rm);
+	free (total);
+	
+	return (read_cnt > 0 && missing_cnt == 0 && invalid_cnt == 0);
+}
+
+// Adding up the still lifes of a campaign of subset searches without going through its database files. Each numbered file is a manifest, whose count lines
+// are used, or the output of a search, whose result lines are used, or else a text or binary database file, whose still lifes are counted. The files are
+// handled in parallel by separate threads, and on Linux a text database file is counted through a read-only mapping, so its data is never copied
+
+typedef struct
+{
+	s32 kind;
+	int is_valid;
+	s32 error_line;
+	s32 min_on_cnt;
+	s32 max_on_cnt;
+	s32 subset;
+	s32 subset_cnt;
+	s64 *strict_cnt;
+	s64 *pseudo_cnt;
+	s64 still_life_cnt;
+} CountFile;
+
+// Hands out the in files to the counting threads, one at a time
+typedef struct
+{
+	pthread_mutex_t mutex;
+	const char *in_template;
+	s32 in_template_entry;
+	s32 in_template_size;
+	s32 first_file_number;
+	s32 file_cnt;
+	s32 next_file_ix;
+	CountFile *cf;
+} CountState;
+
+typedef struct
+{
+	CountState *cs;
+	RunManifest *rm;
+	pthread_t thread;
+} CountThread;
+
+// A line of a text database file starts with the RLE of a still life, which ends with '!', or with its apgcode
+static __not_inline int is_database_line (const char *line)
+{
+	if (line [0] == 'x' && line [1] == 's' && line [2] >= '0' && line [2] <= '9')
+		return TRUE;
+	
+	size_t word_size = strcspn (line, " \r\n");
+	return (word_size > 0 && line [word_size - 1] == '!');
+}
+
+// Counts the lines of a whole file, where a last line without a newline is counted too. Returns FALSE on a read error
+static __not_inline int count_file_lines (FILE *in_file, s64 *line_cnt)
+{
+	*line_cnt = 0;
+	
+#ifdef USE_ZERO_COPY
+	int in_fd = fileno (in_file);
+	
+	struct stat in_stat;
+	if (fstat (in_fd, &in_stat) != 0)
+		return FALSE;
+	
+	s64 size = in_stat.st_size;
+	if (size == 0)
+		return TRUE;
+	
+	const u8 *data = mmap (NULL, size, PROT_READ, MAP_PRIVATE, in_fd, 0);
+	if (data == MAP_FAILED)
+		return FALSE;
+	
+	posix_madvise ((void *) data, size, POSIX_MADV_SEQUENTIAL);
+	*line_cnt = count_newlines (data, size) + (data [size - 1] != '\n' ? 1 : 0);
+	
+	munmap ((void *) data, size);
+	return TRUE;
+#else
+	u8 *block = malloc (BLOCK_SIZE);
+	if (!block)
+		return FALSE;
+	
+	int last_byte_is_newline = TRUE;
+	s64 block_size;
+	while ((block_size = fread (block, 1, BLOCK_SIZE, in_file)) > 0)
+	{
+		*line_cnt += count_newlines (block, block_size);
+		last_byte_is_newline = (block [block_size - 1] == '\n');
+	}
+	
+	free (block);
+	
+	if (!last_byte_is_newline)
+		(*line_cnt)++;
+	
+	return (ferror (in_file) == 0);
+#endif
+}
+
+// Counts the records of a binary database file, which is closed. A single file with all still lifes has the number of records of each category in its index,
+// so they are not read. Returns FALSE if the file is not valid
+static __not_inline int count_file_records (FILE *in_file, s64 *record_cnt)
+{
+	*record_cnt = 0;
+	
+	StillDB_FileHeader fh;
+	if (!StillDB_read_file_header (in_file, &fh))
+	{
+		fclose (in_file);
+		return FALSE;
+	}
+	
+	if (fh.kind == STILLDB_KIND_CONTAINER)
+	{
+		StillDBContainer ct;
+		if (!StillDBContainer_open (&ct, in_file))
+		{
+			fclose (in_file);
+			return FALSE;
+		}
+		
+		s32 category_ix;
+		for (category_ix = 0; category_ix < ct.category_cnt; category_ix++)
+			*record_cnt += ct.category [category_ix].record_cnt;
+		
+		StillDBContainer_close (&ct);
+		return TRUE;
+	}
+	
+	int result;
+	StillDB_Record rec;
+	
+	if (fh.kind == STILLDB_KIND_STREAM)
+	{
+		s32 part_cnt;
+		while ((result = StillDB_read_frame (in_file, &rec, &part_cnt)) == 1)
+			(*record_cnt)++;
+	}
+	else
+	{
+		StillDB_Codec codec;
+		StillDB_init_codec (&codec, fh.encoding);
+		
+		while ((result = StillDB_read_record (in_file, &codec, &rec)) == 1)
+			(*record_cnt)++;
+	}
+	
+	fclose (in_file);
+	return (result == 0);
+}
+
+// Reads the result lines that a search prints when it is done. Returns FALSE if they are not there for consecutive bit counts, each with both counts, with
+// *error_line set to the number of the line that is wrong, or 0 if the result is missing or incomplete
+static __not_inline int read_search_output (FILE *in_file, s64 *strict_cnt, s64 *pseudo_cnt, CountFile *cf, s32 *error_line)
+{
+	char line [COUNT_MAX_LINE_SIZE];
+	s32 line_number = 0;
+	s32 on_cnt = -1;
+	int seen_strict = FALSE;
+	int seen_pseudo = FALSE;
+	
+	cf->subset = -1;
+	cf->subset_cnt = -1;
+	*error_line = 0;
+	
+	while (fgets (line, COUNT_MAX_LINE_SIZE, in_file))
+	{
+		line_number++;
+		
+		int value;
+		int value_2;
+		s64 cnt;
+		
+		if (sscanf (line, "Number of on-cells: %d", &value) == 1)
+		{
+			if (value < 0 || value > RUNMANIFEST_MAX_ON_CNT || (on_cnt >= 0 && (value != on_cnt + 1 || !seen_strict || !seen_pseudo)))
+			{
+				*error_line = line_number;
+				return FALSE;
+			}
+			
+			if (on_cnt < 0)
+				cf->min_on_cnt = value;
+			
+			on_cnt = value;
+			seen_strict = FALSE;
+			seen_pseudo = FALSE;
+		}
+		else if (on_cnt >= 0 && sscanf (line, "Result for subset %d in (0..%d)", &value, &value_2) == 2)
+		{
+			cf->subset = value;
+			cf->subset_cnt = value_2 + 1;
+		}
+		else if (on_cnt >= 0 && strncmp (line, "Result for full search space", 28) == 0)
+		{
+			cf->subset = -1;
+			cf->subset_cnt = 0;
+		}
+		else if (on_cnt >= 0 && sscanf (line, "Strict still lifes: %" SCNi64, &cnt) == 1)
+		{
+			if (seen_strict || cnt < 0)
+			{
+				*error_line = line_number;
+				return FALSE;
+			}
+			
+			strict_cnt [on_cnt] = cnt;
+			seen_strict = TRUE;
+		}
+		else if (on_cnt >= 0 && sscanf (line, "Pseudo still lifes: %" SCNi64, &cnt) == 1)
+		{
+			if (seen_pseudo || cnt < 0)
+			{
+				*error_line = line_number;
+				return FALSE;
+			}
+			
+			pseudo_cnt [on_cnt] = cnt;
+			seen_pseudo = TRUE;
+		}
+	}
+	
+	if (ferror (in_file) || on_cnt < 0 || !seen_strict || !seen_pseudo || cf->subset_cnt < 0)
+		return FALSE;
+	
+	cf->max_on_cnt = on_cnt;
+	return TRUE;
+}
+
+// Finds out what kind of file the in file is from its first line, and reads its counts or counts its lines
+static __not_inline void count_file (CountState *cs, s32 file_ix, RunManifest *rm)
+{
+	CountFile *cf = &cs->cf [file_ix];
+	char in_filename [MAX_FILENAME_SIZE + 1];
+	make_filename (cs->in_template, cs->first_file_number + file_ix, cs->in_template_entry, cs->in_template_size, in_filename);
+	
+	FILE *in_file = fopen (in_filename, "rb");
+	if (!in_file)
+	{
+		cf->kind = COUNT_FILE_MISSING;
+		return;
+	}
+	
+	// An empty file is a database file without any still lifes, like the strict still lifes of subset 2
+	char line [COUNT_MAX_LINE_SIZE];
+	int is_empty = (fgets (line, COUNT_MAX_LINE_SIZE, in_file) == NULL);
+	rewind (in_file);
+	
+	if (!is_empty && strncmp (line, "SLDB", 4) == 0)
+	{
+		cf->kind = COUNT_FILE_DATABASE;
+		cf->is_valid = count_file_records (in_file, &cf->still_life_cnt);
+		return;
+	}
+	
+	if (is_empty || is_database_line (line))
+	{
+		cf->kind = COUNT_FILE_DATABASE;
+		cf->is_valid = count_file_lines (in_file, &cf->still_life_cnt);
+		fclose (in_file);
+		return;
+	}
+	
+	s64 strict_cnt [RUNMANIFEST_MAX_ON_CNT + 1];
+	s64 pseudo_cnt [RUNMANIFEST_MAX_ON_CNT + 1];
+	
+	if (strncmp (line, "StillCount manifest ", 20) == 0)
+	{
+		cf->kind = COUNT_FILE_MANIFEST;
+		cf->is_valid = RunManifest_read (rm, in_file, &cf->error_line);
+		if (cf->is_valid)
+		{
+			cf->min_on_cnt = rm->min_on_cnt;
+			cf->max_on_cnt = rm->max_on_cnt;
+			cf->subset = rm->subset;
+			cf->subset_cnt = rm->subset_cnt;
+			memcpy (strict_cnt, rm->strict_cnt, sizeof (strict_cnt));
+			memcpy (pseudo_cnt, rm->pseudo_cnt, sizeof (pseudo_cnt));
+		}
+	}
+	else
+	{
+		cf->kind = COUNT_FILE_SEARCH_OUTPUT;
+		cf->is_valid = read_search_output (in_file, strict_cnt, pseudo_cnt, cf, &cf->error_line);
+	}
+	
+	fclose (in_file);
+	
+	if (!cf->is_valid)
+		return;
+	
+	// Only the counts of the bit counts of the file are kept, as there may be many files
+	s32 on_cnt_cnt = 1 + cf->max_on_cnt - cf->min_on_cnt;
+	cf->strict_cnt = malloc (2 * on_cnt_cnt * sizeof (s64));
+	if (!cf->strict_cnt)
+	{
+		cf->is_valid = FALSE;
+		cf->error_line = -1;
+		return;
+	}
+	
+	cf->pseudo_cnt = cf->strict_cnt + on_cnt_cnt;
+	memcpy (cf->strict_cnt, strict_cnt + cf->min_on_cnt, on_cnt_cnt * sizeof (s64));
+	memcpy (cf->pseudo_cnt, pseudo_cnt + cf->min_on_cnt, on_cnt_cnt * sizeof (s64));
+}
+
+static __not_inline void *run_count_thread (void *arg)
+{
+	CountThread *th = (CountThread *) arg;
+	CountState *cs = th->cs;
+	
+	while (TRUE)
+	{
+		pthread_mutex_lock (&cs->mutex);
+		s32 file_ix = cs->next_file_ix++;
+		pthread_mutex_unlock (&cs->mutex);
+		
+		if (file_ix >= cs->file_cnt)
+			break;
+		
+		count_file (cs, file_ix, th->rm);
+	}
+	
+	return NULL;
+}
+
+// Adds up the counts of the manifests and search outputs among the in files and the still lifes of the database files, checking that the counts are from the
+// same search and that each one is for the subset given by its file number. Returns FALSE if any file is missing or invalid
+static __not_inline int count_files (const char *in_template, s32 in_template_entry, s32 in_template_size, s32 in_first_number, s32 in_last_number,
+		s32 thread_cnt)
+{
+	double start_time = get_wall_time ();
+	
+	CountState cs;
+	memset (&cs, 0, sizeof (CountState));
+	pthread_mutex_init (&cs.mutex, NULL);
+	cs.in_template = in_template;
+	cs.in_template_entry = in_template_entry;
+	cs.in_template_size = in_template_size;
+	cs.first_file_number = in_first_number;
+	cs.file_cnt = 1 + in_last_number - in_first_number;
+	
+	if (thread_cnt > cs.file_cnt)
+		thread_cnt = cs.file_cnt;
+	
+	cs.cf = calloc (cs.file_cnt, sizeof (CountFile));
+	CountThread *th = calloc (thread_cnt, sizeof (CountThread));
+	RunManifest *rm = malloc (sizeof (RunManifest));
+	RunManifest *total = malloc (sizeof (RunManifest));
+	int success = (cs.cf && th && rm && total);
+	
+	s32 thread_ix;
+	for (thread_ix = 0; success && thread_ix < thread_cnt; thread_ix++)
+	{
+		th [thread_ix].cs = &cs;
+		th [thread_ix].rm = malloc (sizeof (RunManifest));
+		if (!th [thread_ix].rm)
+			success = FALSE;
+		else
+			RunManifest_init (th [thread_ix].rm);
+	}
+	
+	if (!success)
+	{
+		fprintf (stderr, "Out of memory allocating counts\n");
+		for (thread_ix = 0; th && thread_ix < thread_cnt; thread_ix++)
+			free (th [thread_ix].rm);
+		
+		free (th);
+		free (cs.cf);
+		free (rm);
+		free (total);
+		return FALSE;
+	}
+	
+	for (thread_ix = 0; thread_ix < thread_cnt; thread_ix++)
+		if (pthread_create (&th [thread_ix].thread, NULL, run_count_thread, &th [thread_ix]) != 0)
+		{
+			fprintf (stderr, "Failed to start count thread\n");
+			exit (EXIT_FAILURE);
+		}
+	
+	for (thread_ix = 0; thread_ix < thread_cnt; thread_ix++)
+	{
+		pthread_join (th [thread_ix].thread, NULL);
+		RunManifest_free (th [thread_ix].rm);
+		free (th [thread_ix].rm);
+	}
+	
+	free (th);
+	pthread_mutex_destroy (&cs.mutex);
+	
+	// The files are added up in order, so the report doesn't depend on which thread was done first. The options of the search are not compared, as a search
+	// output doesn't show them and they don't change the counts
+	s32 kind_cnt [COUNT_FILE_KIND_CNT];
+	memset (kind_cnt, 0, sizeof (kind_cnt));
+	s32 count_cnt = 0;
+	s32 invalid_cnt = 0;
+	s64 still_life_cnt = 0;
+	RunManifest_init (total);
+	
+	s32 file_ix;
+	for (file_ix = 0; file_ix < cs.file_cnt; file_ix++)
+	{
+		const CountFile *cf = &cs.cf [file_ix];
+		s32 cur_in_file_number = in_first_number + file_ix;
+		char in_filename [MAX_FILENAME_SIZE + 1];
+		make_filename (in_template, cur_in_file_number, in_template_entry, in_template_size, in_filename);
+		
+		if (cf->kind == COUNT_FILE_MISSING)
+		{
+			printf ("Missing file %s\n", in_filename);
+			kind_cnt [COUNT_FILE_MISSING]++;
+			continue;
+		}
+		
+		if (!cf->is_valid)
+		{
+			if (cf->error_line < 0)
+				printf ("Out of memory reading %s\n", in_filename);
+			else if (cf->kind == COUNT_FILE_DATABASE)
+				printf ("Failed to read database file %s\n", in_filename);
+			else if (cf->error_line > 0)
+				printf ("Invalid line %d in %s %s\n", cf->error_line, (cf->kind == COUNT_FILE_MANIFEST ? "manifest" : "search output"), in_filename);
+			else
+				printf ("Incomplete %s %s\n", (cf->kind == COUNT_FILE_MANIFEST ? "manifest" : "search output"), in_filename);
+			
+			invalid_cnt++;
+			continue;
+		}
+		
+		if (cf->kind == COUNT_FILE_DATABASE)
+		{
+			kind_cnt [COUNT_FILE_DATABASE]++;
+			still_life_cnt += cf->still_life_cnt;
+			continue;
+		}
+		
+		RunManifest_init (rm);
+		rm->min_on_cnt = cf->min_on_cnt;
+		rm->max_on_cnt = cf->max_on_cnt;
+		rm->subset = cf->subset;
+		rm->subset_cnt = cf->subset_cnt;
+		memcpy (rm->strict_cnt + cf->min_on_cnt, cf->strict_cnt, (1 + cf->max_on_cnt - cf->min_on_cnt) * sizeof (s64));
+		memcpy (rm->pseudo_cnt + cf->min_on_cnt, cf->pseudo_cnt, (1 + cf->max_on_cnt - cf->min_on_cnt) * sizeof (s64));
+		
+		// Each file number in the template is the subset of the manifest or search output
+		if (!add_subset_counts (total, &count_cnt, rm, in_filename, in_template_entry, cur_in_file_number))
+		{
+			invalid_cnt++;
+			continue;
+		}
+		
+		kind_cnt [cf->kind]++;
+	}
+	
+	double count_time = get_wall_time () - start_time;
+	printf ("%d manifests, %d search outputs and %d database files read, %d missing and %d invalid in %.3f s with %d threads\n",
+			kind_cnt [COUNT_FILE_MANIFEST], kind_cnt [COUNT_FILE_SEARCH_OUTPUT], kind_cnt [COUNT_FILE_DATABASE], kind_cnt [COUNT_FILE_MISSING], invalid_cnt,
+			count_time, thread_cnt);
+	
+	if (kind_cnt [COUNT_FILE_DATABASE] > 0)
+		printf ("Still lifes in database files: %" PRIi64 "\n", still_life_cnt);
+	
+	if (count_cnt > 0)
+		print_subset_counts (total, count_cnt, (kind_cnt [COUNT_FILE_MISSING] == 0 && invalid_cnt == 0));
+	
+	for (file_ix = 0; file_ix < cs.file_cnt; file_ix++)
+		free (cs.cf [file_ix].strict_cnt);
+	
+	free (cs.cf);
+	RunManifest_free (rm);
+	RunManifest_free (total);
+	free (rm);
+	free (total);
+	
+	return (kind_cnt [COUNT_FILE_MISSING] == 0 && invalid_cnt == 0 && (count_cnt > 0 || kind_cnt [COUNT_FILE_DATABASE] > 0));
+}
+
+static __not_inline int verify_template (const char *template, int must_be_template, char *filename, s32 *template_entry, s32 *template_size)
+{
+	strcpy (filename, template);
+	*template_entry = 0;
+	*template_size = 0;
+	
+	s32 template_ix = 0;
+	while (template [template_ix] != '\0')
+	{
+		if (template [template_ix] == '#')
+			filename [template_ix] = '0';
+		template_ix++;
+	}
+	
+	template_ix = 0;
+	s32 hash_on = -1;
+	s32 hash_off = -1;
+	
+	while (TRUE)
+	{
+		char c = template [template_ix];
+		
+		if (c != '#')
+			if (hash_on >= 0 && hash_off < 0)
+				hash_off = template_ix;
+		
+		if (c == '\0')
+		{
+			if (must_be_template && hash_off < 0)
+				return FALSE;
+			
+			*template_entry = hash_on;
+			*template_size = hash_off - hash_on;
+			return TRUE;
+		}
+		
+		if (c == '#')
+		{
+			if (hash_off >= 0)
+				return FALSE;
+			if (hash_on < 0)
+				hash_on = template_ix;
+		}
+		
+		template_ix++;
+	}
+}
+
+static __not_inline int main_sort (int argc, const char *const *argv)
+{
+	int usage_fail = FALSE;
+	
+	char in_template [MAX_FILENAME_SIZE + 1];
+	s32 in_template_entry;
+	s32 in_template_size;
+	u32 cl_in_first_number;
+	u32 cl_in_last_number;
+	
+	char out_filename [MAX_FILENAME_SIZE + 1];
+	s32 out_template_entry;
+	s32 out_template_size;
+	u32 cl_thread_cnt = DEFAULT_SORT_THREADS;
+	u32 cl_memory_mb = DEFAULT_SORT_MEMORY_MB;
+	
+	if (argc < 6 || strlen (argv [2]) >= MAX_FILENAME_SIZE || strlen (argv [5]) >= MAX_FILENAME_SIZE)
+		usage_fail = TRUE;
+	
+	if (!usage_fail && !verify_template (argv [2], TRUE, in_template, &in_template_entry, &in_template_size))
+		usage_fail = TRUE;
+	
+	if (!usage_fail && (!str_to_u32 (argv [3], &cl_in_first_number) || !str_to_u32 (argv [4], &cl_in_last_number)))
+		usage_fail = TRUE;
+	
+	if (!usage_fail && (digits_in_u32 (cl_in_last_number) > in_template_size || cl_in_first_number > cl_in_last_number))
+		usage_fail = TRUE;
+	
+	// The run files only have room for 16-bit file numbers
+	if (!usage_fail && cl_in_last_number > SORT_MAX_FILE_NUMBER)
+	{
+		fprintf (stderr, "The last number can't be higher than %d\n", SORT_MAX_FILE_NUMBER);
+		return FALSE;
+	}
+	
+	if (!usage_fail && !verify_template (argv [5], FALSE, out_filename, &out_template_entry, &out_template_size))
+		usage_fail = TRUE;
+	
+	if (!usage_fail && out_template_entry >= 0)
+		usage_fail = TRUE;
+	
+	s32 arg_ix = 6;
+	while (!usage_fail && arg_ix < argc)
+	{
+		if (arg_ix + 1 >= argc)
+			usage_fail = TRUE;
+		else if (strcmp (argv [arg_ix], "-t") == 0)
+			usage_fail = (!str_to_u32 (argv [arg_ix + 1], &cl_thread_cnt) || cl_thread_cnt < 1 || cl_thread_cnt > MAX_SORT_THREADS);
+		else if (strcmp (argv [arg_ix], "-m") == 0)
+			usage_fail = (!str_to_u32 (argv [arg_ix + 1], &cl_memory_mb) || cl_memory_mb < 1);
+		else
+			usage_fail = TRUE;
+		
+		arg_ix += 2;
+	}
+	
+	if (usage_fail)
+	{
+		fprintf (stderr, "USAGE: pp sort <in template> <first number> <last number> <out file>\n");
+		fprintf (stderr, "          [-t <threads>] [-m <megabytes of memory>]\n");
+		fprintf (stderr, "where a template could be \"28_bits_strict_subset_####_of_1024.txt\"\n");
+		return FALSE;
+	}
+	
+	return sort_files (in_template, in_template_entry, in_template_size, (s32) cl_in_first_number, (s32) cl_in_last_number, out_filename,
+			(s32) cl_thread_cnt, (s64) cl_memory_mb * 1024 * 1024);
+}
+
+static __not_inline int main_manifest (int argc, const char *const *argv)
+{
+	int usage_fail = FALSE;
+	
+	char in_template [MAX_FILENAME_SIZE + 1];
+	s32 in_template_entry = -1;
+	s32 in_template_size = 0;
+	u32 cl_in_first_number = 0;
+	u32 cl_in_last_number = 0;
+	
+	if ((argc != 3 && argc != 5) || strlen (argv [2]) >= MAX_FILENAME_SIZE)
+		usage_fail = TRUE;
+	
+	// A single manifest is given by its name alone
+	if (!usage_fail && !verify_template (argv [2], (argc == 5), in_template, &in_template_entry, &in_template_size))
+		usage_fail = TRUE;
+	
+	if (!usage_fail && argc == 3 && in_template_entry >= 0)
+		usage_fail = TRUE;
+	
+	if (!usage_fail && argc == 5 && (!str_to_u32 (argv [3], &cl_in_first_number) || !str_to_u32 (argv [4], &cl_in_last_number)))
+		usage_fail = TRUE;
+	
+	if (!usage_fail && argc == 5 && (digits_in_u32 (cl_in_last_number) > in_template_size || cl_in_first_number > cl_in_last_number))
+		usage_fail = TRUE;
+	
+	if (usage_fail)
+	{
+		fprintf (stderr, "USAGE: pp manifest <in template> <first number> <last number>\n");
+		fprintf (stderr, "   or: pp manifest <manifest file>\n");
+		fprintf (stderr, "where a template could be \"20_to_28_bits_subset_####_of_0100.manifest\"\n");
+		return FALSE;
+	}
+	
+	return sum_manifests (in_template, in_template_entry, in_template_size, (s32) cl_in_first_number, (s32) cl_in_last_number);
+}
+
+static __not_inline int main_count (int argc, const char *const *argv)
+{
+	int usage_fail = FALSE;
+	
+	char in_template [MAX_FILENAME_SIZE + 1];
+	s32 in_template_entry;
+	s32 in_template_size;
+	u32 cl_in_first_number;
+	u32 cl_in_last_number;
+	u32 cl_thread_cnt = DEFAULT_COUNT_THREADS;
+	
+	if (argc < 5 || strlen (argv [2]) >= MAX_FILENAME_SIZE)
+		usage_fail = TRUE;
+	
+	if (!usage_fail && !verify_template (argv [2], TRUE, in_template, &in_template_entry, &in_template_size))
+		usage_fail = TRUE;
+	
+	if (!usage_fail && (!str_to_u32 (argv [3], &cl_in_first_number) || !str_to_u32 (argv [4], &cl_in_last_number)))
+		usage_fail = TRUE;
+	
+	if (!usage_fail && (digits_in_u32 (cl_in_last_number) > in_template_size || cl_in_first_number > cl_in_last_number))
+		usage_fail = TRUE;
+	
+	s32 arg_ix = 5;
+	while (!usage_fail && arg_ix < argc)
+	{
+		if (arg_ix + 1 >= argc)
+			usage_fail = TRUE;
+		else if (strcmp (argv [arg_ix], "-t") == 0)
+			usage_fail = (!str_to_u32 (argv [arg_ix + 1], &cl_thread_cnt) || cl_thread_cnt < 1 || cl_thread_cnt > MAX_COUNT_THREADS);
+		else
+			usage_fail = TRUE;
+		
+		arg_ix += 2;
+	}
+	
+	if (usage_fail)
+	{
+		fprintf (stderr, "USAGE: pp count <in template> <first number> <last number> [-t <threads>]\n");
+		fprintf (stderr, "where a template could be \"20_to_28_bits_subset_####_of_0100.manifest\"\n");
+		return FALSE;
+	}
+	
+	return count_files (in_template, in_template_entry, in_template_size, (s32) cl_in_first_number, (s32) cl_in_last_number, (s32) cl_thread_cnt);
+}
+
+static __not_inline int main_do (int argc, const char *const *argv)
+{
+	int usage_fail = FALSE;
+	
+	if (argc > 1 && strcmp (argv [1], "sort") == 0)
+		return main_sort (argc, argv);
+	
+	if (argc > 1 && strcmp (argv [1], "manifest") == 0)
+		return main_manifest (argc, argv);
+	
+	if (argc > 1 && strcmp (argv [1], "count") == 0)
+		return main_count (argc, argv);
 	
 	char in_template [MAX_FILENAME_SIZE + 1];
 	s32 in_template_entry;
@@ -243,6 +1889,10 @@ static __not_inline int main_do (int argc, const char *const *argv)
 	{
 		fprintf (stderr, "USAGE: pp <in template> <first number> <last number>\n");
 		fprintf (stderr, "          <out template> [<lines per out file>]\n");
+		fprintf (stderr, "   or: pp sort <in template> <first number> <last number> <out file>\n");
+		fprintf (stderr, "          [-t <threads>] [-m <megabytes of memory>]\n");
+		fprintf (stderr, "   or: pp manifest <in template> <first number> <last number>\n");
+		fprintf (stderr, "   or: pp count <in template> <first number> <last number> [-t <threads>]\n");
 		fprintf (stderr, "where a template could be \"28_bits_strict_subset_####_of_1024.txt\"\n");
 		return FALSE;
 	}
@@ -0,0 +1,1229 @@
+// For fileno, ftruncate and mmap, which are used for the index files and to read text database files, and clock_gettime
+#ifndef _WIN32
+	#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdlib.h>
+#include <inttypes.h>
+#include <memory.h>
+#include <time.h>
+#include <string.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include "lib/lib.c"
+#include "lib/rect.c"
+#include "lib/celllist.c"
+#include "lib/objects.c"
+#include "lib/randomarray.c"
+#include "lib/golgrid.c"
+#include "lib/gridunsafe.c"
+#include "lib/gridmisc.c"
+#include "lib/golutils.c"
+#include "lib/stilldb.c"
+
+#ifdef _WIN32
+	#include <io.h>
+	#include <fcntl.h>
+#else
+	#define STILLDB_INDEX_USE_MMAP
+	#define STILLDB_READER_USE_MMAP
+	#include <unistd.h>
+	#include <sys/mman.h>
+#endif
+
+#include "lib/stilldbcontainer.c"
+#include "lib/stilldbindex.c"
+#include "lib/stilldbreader.c"
+
+#define FILE_BUFFER_SIZE (1024 * 1024)
+#define LIFE_HISTORY_BUFFER_SIZE 16384
+#define MAX_REPORTED_INDEX_CONFLICTS 20
+#define DIFF_ENTRY_HEADER_SIZE 24
+#define DIFF_MAX_PARTITION_BITS 8
+#define DIFF_SPLIT_BITS 4
+#define DIFF_SPILL_BYTES_PER_INPUT_BYTE 4
+#define DEFAULT_DIFF_MEMORY_MB 256
+
+// Called for each still life read from a database file, with the number of its line in a text file or its record in a binary file. part_cnt is the fewest
+// stable parts of a pseudo still life if the file tells, otherwise 0 or 2. Returns FALSE to stop reading
+typedef int (*StillLifeVisitor) (void *context, const char *filename, int is_text, s64 item_number, const StillDB_Record *rec, s32 part_cnt);
+
+typedef struct
+{
+	const char *filename;
+	StillLifeVisitor visitor;
+	void *context;
+	s32 part_cnt;
+} TextFileVisit;
+
+typedef struct
+{
+	StillDBIndex ix;
+	s64 conflict_cnt;
+} IndexBuilder;
+
+// The still lifes of both sides of a diff are spread over partition files by the top bits of their canonical hash, each as a DIFF_ENTRY_HEADER_SIZE byte
+// header in the byte order of the machine followed by the encoded record:
+//   0  u64 canonical hash
+//   8  u32 index of the database file, where the files of the old side come first
+//   12 u16 size of the record
+//   14 u16 unused
+//   16 u64 line or record number in the file
+typedef struct
+{
+	StillDBIndex hasher;
+	const char *const *filename;
+	s32 file_cnt;
+	s32 old_file_cnt;
+	s32 cur_file_ix;
+	s8 *file_is_text;
+	
+	s64 memory_limit;
+	s32 partition_cnt;
+	s32 partition_bit_cnt;
+	FILE **partition;
+	GoLGrid *gg;
+	
+	s64 still_life_cnt [2];
+	s64 only_cnt [2];
+	s64 duplicate_cnt [2];
+} DiffState;
+
+
+// Opens a database file, or stdin if filename is "-", which is useful to read a stream of records from stillcount -o -
+static __not_inline FILE *open_database (const char *filename, StillDB_FileHeader *fh)
+{
+	FILE *f;
+	if (strcmp (filename, "-") == 0)
+	{
+#ifdef _WIN32
+		_setmode (_fileno (stdin), _O_BINARY);
+#endif
+		f = stdin;
+	}
+	else
+		f = fopen (filename, "rb");
+	
+	if (!f)
+	{
+		fprintf (stderr, "Failed to open database file %s\n", filename);
+		return NULL;
+	}
+	
+	if (setvbuf (f, NULL, _IOFBF, FILE_BUFFER_SIZE) || !StillDB_read_file_header (f, fh))
+	{
+		fprintf (stderr, "%s is not a still life database file\n", filename);
+		fclose (f);
+		return NULL;
+	}
+	
+	return f;
+}
+
+static __not_inline void print_category (FILE *stream, s32 on_cnt, s32 kind, s32 part_cnt)
+{
+	fprintf (stream, "%d bit %s still lifes", on_cnt, (kind == STILLDB_KIND_PSEUDO ? "pseudo" : "strict"));
+	if (part_cnt > 0)
+		fprintf (stream, " in %d parts", part_cnt);
+}
+
+static __not_inline void print_file_header (FILE *stream, const StillDB_FileHeader *fh)
+{
+	if (fh->kind == STILLDB_KIND_CONTAINER)
+		fprintf (stream, "Single file with all still lifes");
+	else if (fh->kind == STILLDB_KIND_STREAM)
+		fprintf (stream, "Stream of all still lifes");
+	else
+		print_category (stream, fh->on_cnt, fh->kind, fh->part_cnt);
+	
+	fprintf (stream, ", from a search of %d to %d bits", fh->min_on_cnt, fh->max_on_cnt);
+	if (fh->subset_cnt > 0)
+		fprintf (stream, " in subset %d of %d", fh->subset, fh->subset_cnt);
+	
+	if (fh->encoding == STILLDB_ENCODING_DELTA)
+		fprintf (stream, ", delta coded");
+	
+	fprintf (stream, "\n");
+}
+
+static __not_inline void write_record_as_rle (const StillDB_Record *rec, GoLGrid *gg, FILE *out_stream)
+{
+	StillDB_record_to_grid (rec, gg);
+	
+	char buf [LIFE_HISTORY_BUFFER_SIZE];
+	Rect bb;
+	GoLGrid_get_bounding_box (gg, &bb);
+	
+	s32 size = GoLGrid_print_life_history_to_buffer_64_wide (gg, &bb, FALSE, 1024, buf, LIFE_HISTORY_BUFFER_SIZE);
+	if (size > 0)
+		fwrite (buf, 1, size, out_stream);
+	else
+		GoLGrid_print_life_history_full (out_stream, &bb, gg, NULL, NULL, NULL, FALSE, 1024);
+}
+
+// Writes the still lifes of one category of a single file as LifeHistory RLE, or lists the categories if on_cnt is negative
+static __not_inline int convert_container_to_rle (const char *in_filename, FILE *in_file, FILE *out_stream, s32 on_cnt, s32 kind, s32 part_cnt)
+{
+	StillDBContainer ct;
+	if (!StillDBContainer_open (&ct, in_file))
+	{
+		fprintf (stderr, "%s has an invalid index\n", in_filename);
+		fclose (in_file);
+		return FALSE;
+	}
+	
+	if (on_cnt < 0)
+	{
+		print_file_header (out_stream, &ct.fh);
+		
+		s32 category_ix;
+		for (category_ix = 0; category_ix < ct.category_cnt; category_ix++)
+		{
+			const StillDBContainer_Category *cat = &ct.category [category_ix];
+			print_category (out_stream, cat->on_cnt, cat->kind, cat->part_cnt);
+			fprintf (out_stream, ": %" PRIi64 " records in %d blocks\n", cat->record_cnt, cat->block_cnt);
+		}
+		
+		StillDBContainer_close (&ct);
+		return TRUE;
+	}
+	
+	s32 category_ix = StillDBContainer_find_category (&ct, on_cnt, kind, part_cnt);
+	if (category_ix < 0)
+	{
+		fprintf (stderr, "There are no ");
+		print_category (stderr, on_cnt, kind, part_cnt);
+		fprintf (stderr, " in %s\n", in_filename);
+		StillDBContainer_close (&ct);
+		return FALSE;
+	}
+	
+	GoLGrid *gg = GoLUtils_alloc_std_grid (0, 0, 64, STILLDB_MAX_SIDE);
+	if (!gg)
+	{
+		StillDBContainer_close (&ct);
+		return FALSE;
+	}
+	
+	StillDBContainer_Reader rd;
+	StillDBContainer_open_category (&ct, category_ix, &rd);
+	
+	s64 record_cnt = 0;
+	int result;
+	StillDB_Record rec;
+	
+	while ((result = StillDBContainer_read_record (&rd, &rec)) == 1)
+	{
+		record_cnt++;
+		write_record_as_rle (&rec, gg, out_stream);
+	}
+	
+	StillDBContainer_close (&ct);
+	GoLUtils_free_std_grid (&gg);
+	
+	if (result < 0)
+	{
+		fprintf (stderr, "Invalid record after %" PRIi64 " records in %s\n", record_cnt, in_filename);
+		return FALSE;
+	}
+	
+	if (fflush (out_stream) != 0)
+	{
+		fprintf (stderr, "Write error on output\n");
+		return FALSE;
+	}
+	
+	return TRUE;
+}
+
+// Writes the still lifes of a stream of framed records as LifeHistory RLE, either all of them or one category, or counts them by category if info_only is set.
+// The still lifes are written as they arrive, so the stream may be a pipe from a search that is still running
+static __not_inline int convert_stream_to_rle (const char *in_filename, FILE *in_file, FILE *out_stream, int info_only, s32 on_cnt, s32 kind, s32 part_cnt)
+{
+	GoLGrid *gg = GoLUtils_alloc_std_grid (0, 0, 64, STILLDB_MAX_SIDE);
+	if (!gg)
+	{
+		fclose (in_file);
+		return FALSE;
+	}
+	
+	s64 category_cnt [256] [2];
+	memset (category_cnt, 0, sizeof (category_cnt));
+	
+	s64 record_cnt = 0;
+	int result;
+	StillDB_Record rec;
+	s32 rec_part_cnt;
+	
+	while ((result = StillDB_read_frame (in_file, &rec, &rec_part_cnt)) == 1)
+	{
+		record_cnt++;
+		category_cnt [rec.on_cnt] [rec.kind == STILLDB_KIND_PSEUDO ? 1 : 0]++;
+		
+		if (info_only || (on_cnt >= 0 && (rec.on_cnt != on_cnt || rec.kind != kind || (part_cnt > 0 && rec_part_cnt != part_cnt))))
+			continue;
+		
+		write_record_as_rle (&rec, gg, out_stream);
+	}
+	
+	fclose (in_file);
+	GoLUtils_free_std_grid (&gg);
+	
+	if (result < 0)
+	{
+		fprintf (stderr, "%s ends before the end of the search, or has an invalid record, after %" PRIi64 " records\n", in_filename, record_cnt);
+		return FALSE;
+	}
+	
+	if (info_only)
+	{
+		s32 on_ix;
+		for (on_ix = 0; on_ix < 256; on_ix++)
+		{
+			s32 kind_ix;
+			for (kind_ix = 0; kind_ix < 2; kind_ix++)
+				if (category_cnt [on_ix] [kind_ix] > 0)
+				{
+					print_category (out_stream, on_ix, (kind_ix == 1 ? STILLDB_KIND_PSEUDO : STILLDB_KIND_STRICT), 0);
+					fprintf (out_stream, ": %" PRIi64 " records\n", category_cnt [on_ix] [kind_ix]);
+				}
+		}
+		
+		fprintf (out_stream, "%" PRIi64 " records\n", record_cnt);
+	}
+	
+	if (fflush (out_stream) != 0)
+	{
+		fprintf (stderr, "Write error on output\n");
+		return FALSE;
+	}
+	
+	return TRUE;
+}
+
+// Writes the still lifes of a binary database file as LifeHistory RLE, one per line, exactly like the text database files. For a single file with all
+// still lifes of a search the category is selected by on_cnt, kind and part_cnt, and if on_cnt is negative the categories are listed instead
+static __not_inline int convert_to_rle (const char *in_filename, FILE *out_stream, int info_only, s32 on_cnt, s32 kind, s32 part_cnt)
+{
+	StillDB_FileHeader fh;
+	FILE *in_file = open_database (in_filename, &fh);
+	if (!in_file)
+		return FALSE;
+	
+	if (fh.kind == STILLDB_KIND_STREAM)
+	{
+		if (info_only)
+			print_file_header (out_stream, &fh);
+		
+		return convert_stream_to_rle (in_filename, in_file, out_stream, info_only, on_cnt, kind, part_cnt);
+	}
+	
+	if (fh.kind == STILLDB_KIND_CONTAINER)
+	{
+		if (!info_only && on_cnt < 0)
+		{
+			fprintf (stderr, "%s is a single file with all still lifes of a search, so the still lifes to convert must be selected\n", in_filename);
+			fclose (in_file);
+			return FALSE;
+		}
+		
+		return convert_container_to_rle (in_filename, in_file, out_stream, (info_only ? -1 : on_cnt), kind, part_cnt);
+	}
+	
+	if (on_cnt >= 0)
+	{
+		fprintf (stderr, "Still lifes can only be selected in a single file or a stream with all still lifes of a search\n");
+		fclose (in_file);
+		return FALSE;
+	}
+	
+	GoLGrid *gg = GoLUtils_alloc_std_grid (0, 0, 64, STILLDB_MAX_SIDE);
+	if (!gg)
+	{
+		fclose (in_file);
+		return FALSE;
+	}
+	
+	StillDB_Codec codec;
+	StillDB_init_codec (&codec, fh.encoding);
+	
+	s64 record_cnt = 0;
+	int result;
+	StillDB_Record rec;
+	
+	while ((result = StillDB_read_record (in_file, &codec, &rec)) == 1)
+	{
+		record_cnt++;
+		if (info_only)
+			continue;
+		
+		write_record_as_rle (&rec, gg, out_stream);
+	}
+	
+	fclose (in_file);
+	GoLUtils_free_std_grid (&gg);
+	
+	if (result < 0)
+	{
+		fprintf (stderr, "Invalid record after %" PRIi64 " records in %s\n", record_cnt, in_filename);
+		return FALSE;
+	}
+	
+	if (info_only)
+	{
+		print_file_header (out_stream, &fh);
+		fprintf (out_stream, "%" PRIi64 " records\n", record_cnt);
+	}
+	
+	if (fflush (out_stream) != 0)
+	{
+		fprintf (stderr, "Write error on output\n");
+		return FALSE;
+	}
+	
+	return TRUE;
+}
+
+// A line of a text database file or a query is either LifeHistory RLE or an apgcode, and may be followed by other columns. Returns FALSE if it is not a
+// pattern that fits in gg
+static __not_inline int parse_pattern_line (const char *line, GoLGrid *gg)
+{
+	int parsed;
+	int clipped = FALSE;
+	
+	if (line [0] == 'x' && line [1] == 's')
+		parsed = GoLGrid_parse_still_life_apgcode (line, 0, 0, gg);
+	else
+		parsed = GoLGrid_parse_life_history (line, 0, 0, gg, NULL, NULL, NULL, &clipped, NULL);
+	
+	return (parsed && !clipped && !GoLGrid_is_empty (gg));
+}
+
+// Reads a line without its line break into buf. Returns 1 if a line was read, 0 at the end of the file and -1 if the line is too long
+static __not_inline s32 read_line (FILE *f, char *buf, s32 buf_size)
+{
+	if (!fgets (buf, buf_size, f))
+		return 0;
+	
+	s32 size = strlen (buf);
+	if (size > 0 && buf [size - 1] == '\n')
+		buf [--size] = '\0';
+	else if (!feof (f))
+		return -1;
+	
+	if (size > 0 && buf [size - 1] == '\r')
+		buf [--size] = '\0';
+	
+	return 1;
+}
+
+// Reads all still lifes of a binary database file, or counts them if visitor is NULL. For a single file with all still lifes of a search the records of one
+// category are read with rd
+static __not_inline int read_records (const char *filename, FILE *f, const StillDB_FileHeader *fh, StillDBContainer_Reader *rd, StillLifeVisitor visitor,
+		void *context, s64 *item_cnt)
+{
+	StillDB_Codec codec;
+	StillDB_init_codec (&codec, fh->encoding);
+	
+	int result;
+	StillDB_Record rec;
+	s32 part_cnt;
+	
+	while (TRUE)
+	{
+		if (fh->kind == STILLDB_KIND_STREAM)
+			result = StillDB_read_frame (f, &rec, &part_cnt);
+		else if (rd)
+		{
+			result = StillDBContainer_read_record (rd, &rec);
+			part_cnt = rd->ct->category [rd->category_ix].part_cnt;
+		}
+		else
+		{
+			result = StillDB_read_record (f, &codec, &rec);
+			part_cnt = fh->part_cnt;
+		}
+		
+		if (result != 1)
+			break;
+		
+		(*item_cnt)++;
+		if (visitor && !visitor (context, filename, FALSE, *item_cnt, &rec, part_cnt))
+			return FALSE;
+	}
+	
+	if (result < 0)
+	{
+		fprintf (stderr, "Invalid record after %" PRIi64 " records in %s\n", *item_cnt, filename);
+		return FALSE;
+	}
+	
+	return TRUE;
+}
+
+// Returns -1 if the file can't be opened
+static __not_inline s64 get_file_size (const char *filename)
+{
+	FILE *f = fopen (filename, "rb");
+	if (!f)
+		return -1;
+	
+	s64 size = (fseek_s64 (f, 0, SEEK_END) == 0 ? ftell_s64 (f) : -1);
+	fclose (f);
+	return size;
+}
+
+// Hands the still lifes of a batch from a text database file to the visitor
+static __not_inline int visit_text_batch (void *context, const StillDBReader_Batch *batch)
+{
+	TextFileVisit *tv = (TextFileVisit *) context;
+	
+	s32 record_ix;
+	for (record_ix = 0; record_ix < batch->record_cnt; record_ix++)
+		if (!tv->visitor (tv->context, tv->filename, TRUE, batch->line_number [record_ix], &batch->record [record_ix], tv->part_cnt))
+			return FALSE;
+	
+	return TRUE;
+}
+
+// Reads all still lifes of a text or binary database file, or counts them if visitor is NULL. The bit count and kind of the still lifes in a text file are
+// taken from the filename. A text file is decoded by thread_cnt threads, and with more than one the visitor is called from all of them at once
+static __not_inline int read_database (const char *filename, s32 thread_cnt, StillLifeVisitor visitor, void *context, s64 *still_life_cnt)
+{
+	FILE *f = fopen (filename, "rb");
+	if (!f || setvbuf (f, NULL, _IOFBF, FILE_BUFFER_SIZE) != 0)
+	{
+		fprintf (stderr, "Failed to open database file %s\n", filename);
+		if (f)
+			fclose (f);
+		
+		return FALSE;
+	}
+	
+	s64 item_cnt = 0;
+	StillDB_FileHeader fh;
+	if (StillDB_read_file_header (f, &fh))
+	{
+		if (fh.kind != STILLDB_KIND_CONTAINER)
+		{
+			int success = read_records (filename, f, &fh, NULL, visitor, context, &item_cnt);
+			fclose (f);
+			*still_life_cnt += item_cnt;
+			return success;
+		}
+		
+		StillDBContainer ct;
+		if (!StillDBContainer_open (&ct, f))
+		{
+			fprintf (stderr, "%s has an invalid index\n", filename);
+			fclose (f);
+			return FALSE;
+		}
+		
+		int success = TRUE;
+		s32 category_ix;
+		for (category_ix = 0; success && category_ix < ct.category_cnt; category_ix++)
+		{
+			StillDBContainer_Reader rd;
+			StillDBContainer_open_category (&ct, category_ix, &rd);
+			success = read_records (filename, f, &ct.fh, &rd, visitor, context, &item_cnt);
+		}
+		
+		StillDBContainer_close (&ct);
+		*still_life_cnt += item_cnt;
+		return success;
+	}
+	
+	s32 on_cnt;
+	s32 kind;
+	s32 part_cnt;
+	StillDB_get_category_from_filename (filename, &on_cnt, &kind, &part_cnt);
+	if (on_cnt < 0 || fseek (f, 0, SEEK_SET) != 0)
+	{
+		fprintf (stderr, "The bit count and kind of the still lifes in %s is not known from its name, like \"20_bits_strict.txt\"\n", filename);
+		fclose (f);
+		return FALSE;
+	}
+	
+	fclose (f);
+	
+	StillDBReader rd;
+	if (!StillDBReader_open (&rd, filename, on_cnt, kind))
+	{
+		fprintf (stderr, "Failed to read database file %s\n", filename);
+		return FALSE;
+	}
+	
+	TextFileVisit tv;
+	tv.filename = filename;
+	tv.visitor = visitor;
+	tv.context = context;
+	tv.part_cnt = part_cnt;
+	
+	int success = StillDBReader_read (&rd, thread_cnt, (visitor ? visit_text_batch : NULL), &tv);
+	if (rd.invalid_line_number > 0)
+		fprintf (stderr, "Line %" PRIi64 " of %s is not a pattern of at most 64 by 64 cells\n", rd.invalid_line_number, filename);
+	
+	*still_life_cnt += rd.record_cnt;
+	StillDBReader_close (&rd);
+	return success;
+}
+
+static __not_inline int add_to_index (void *context, const char *filename, int is_text, s64 item_number, const StillDB_Record *rec, s32 part_cnt)
+{
+	IndexBuilder *ib = (IndexBuilder *) context;
+	
+	s32 result = StillDBIndex_add (&ib->ix, StillDBIndex_hash_record (&ib->ix, rec), rec->on_cnt, rec->kind, (part_cnt > 2 ? part_cnt : 0));
+	if (result == -2)
+	{
+		// The files were counted before the index was made, so they must have changed since
+		fprintf (stderr, "The index is full, %s has more still lifes than it had when it was counted\n", filename);
+		return FALSE;
+	}
+	
+	if (result == -1 && ib->conflict_cnt++ < MAX_REPORTED_INDEX_CONFLICTS)
+	{
+		fprintf (stderr, "The %d bit %s still life at %s %" PRIi64 " of %s is already in the index as another bit count or kind\n", rec->on_cnt,
+				(rec->kind == STILLDB_KIND_PSEUDO ? "pseudo" : "strict"), (is_text ? "line" : "record"), item_number, filename);
+	}
+	
+	return TRUE;
+}
+
+// The database files are read twice, first to count the still lifes to get the size of the index, and then to add them
+static __not_inline int build_index (const char *index_filename, const char *const *filename, s32 file_cnt)
+{
+	s64 still_life_cnt = 0;
+	
+	s32 file_ix;
+	for (file_ix = 0; file_ix < file_cnt; file_ix++)
+		if (!read_database (filename [file_ix], 1, NULL, NULL, &still_life_cnt))
+			return FALSE;
+	
+	IndexBuilder ib;
+	ib.conflict_cnt = 0;
+	if (!StillDBIndex_create (&ib.ix, index_filename, still_life_cnt))
+	{
+		fprintf (stderr, "Failed to create index file %s\n", index_filename);
+		return FALSE;
+	}
+	
+	double start_time = get_wall_time ();
+	int success = TRUE;
+	still_life_cnt = 0;
+	
+	for (file_ix = 0; success && file_ix < file_cnt; file_ix++)
+		success = read_database (filename [file_ix], 1, add_to_index, &ib, &still_life_cnt);
+	
+	u64 entry_cnt = ib.ix.entry_cnt;
+	u64 slot_cnt = ib.ix.slot_cnt;
+	double index_time = get_wall_time () - start_time;
+	
+	if (!StillDBIndex_close (&ib.ix) && success)
+	{
+		fprintf (stderr, "Write error on index file %s\n", index_filename);
+		success = FALSE;
+	}
+	
+	if (!success)
+		return FALSE;
+	
+	printf ("%" PRIi64 " still lifes in %d files, %" PRIu64 " different ones in %" PRIu64 " slots, indexed in %.3f s\n", still_life_cnt, file_cnt, entry_cnt, slot_cnt,
+			index_time);
+	
+	if (ib.conflict_cnt > 0)
+	{
+		fprintf (stderr, "%" PRIi64 " still lifes were found as more than one bit count or kind\n", ib.conflict_cnt);
+		return FALSE;
+	}
+	
+	return TRUE;
+}
+
+static __not_inline int spill_still_life (void *context, const char *filename, int is_text, s64 item_number, const StillDB_Record *rec, s32 part_cnt)
+{
+	DiffState *ds = (DiffState *) context;
+	u8 entry [DIFF_ENTRY_HEADER_SIZE + STILLDB_MAX_RECORD_SIZE];
+	(void) part_cnt;
+	
+	u64 hash = StillDBIndex_hash_record (&ds->hasher, rec);
+	u32 file_ix = ds->cur_file_ix;
+	u16 record_size = StillDB_encode_record (rec, entry + DIFF_ENTRY_HEADER_SIZE);
+	u16 unused = 0;
+	
+	memcpy (entry, &hash, 8);
+	memcpy (entry + 8, &file_ix, 4);
+	memcpy (entry + 12, &record_size, 2);
+	memcpy (entry + 14, &unused, 2);
+	memcpy (entry + 16, &item_number, 8);
+	
+	ds->file_is_text [file_ix] = is_text;
+	ds->still_life_cnt [file_ix >= (u32) ds->old_file_cnt]++;
+	
+	FILE *f = ds->partition [ds->partition_bit_cnt == 0 ? 0 : hash >> (64 - ds->partition_bit_cnt)];
+	if (fwrite (entry, 1, DIFF_ENTRY_HEADER_SIZE + record_size, f) != (size_t) (DIFF_ENTRY_HEADER_SIZE + record_size))
+	{
+		fprintf (stderr, "Write error on temporary file while reading %s\n", filename);
+		return FALSE;
+	}
+	
+	return TRUE;
+}
+
+// Orders the entries by hash and then bit count and kind, so that each still life is a run of entries, and within that by file and line or record number
+static int compare_diff_entries (const void *arg_1, const void *arg_2)
+{
+	const u8 *entry_1 = *(const u8 *const *) arg_1;
+	const u8 *entry_2 = *(const u8 *const *) arg_2;
+	
+	u64 hash_1;
+	u64 hash_2;
+	memcpy (&hash_1, entry_1, 8);
+	memcpy (&hash_2, entry_2, 8);
+	if (hash_1 != hash_2)
+		return (hash_1 < hash_2 ? -1 : 1);
+	
+	// The first two bytes of a record are the bit count and kind
+	s32 category_diff = memcmp (entry_1 + DIFF_ENTRY_HEADER_SIZE, entry_2 + DIFF_ENTRY_HEADER_SIZE, 2);
+	if (category_diff != 0)
+		return category_diff;
+	
+	u32 file_ix_1;
+	u32 file_ix_2;
+	memcpy (&file_ix_1, entry_1 + 8, 4);
+	memcpy (&file_ix_2, entry_2 + 8, 4);
+	if (file_ix_1 != file_ix_2)
+		return (file_ix_1 < file_ix_2 ? -1 : 1);
+	
+	s64 item_number_1;
+	s64 item_number_2;
+	memcpy (&item_number_1, entry_1 + 16, 8);
+	memcpy (&item_number_2, entry_2 + 16, 8);
+	return (item_number_1 < item_number_2 ? -1 : (item_number_1 > item_number_2 ? 1 : 0));
+}
+
+static __not_inline void print_diff_entry (DiffState *ds, const u8 *entry)
+{
+	u32 file_ix;
+	u16 record_size;
+	s64 item_number;
+	memcpy (&file_ix, entry + 8, 4);
+	memcpy (&record_size, entry + 12, 2);
+	memcpy (&item_number, entry + 16, 8);
+	
+	StillDB_Record rec;
+	StillDB_decode_record (entry + DIFF_ENTRY_HEADER_SIZE, record_size, &rec);
+	
+	printf ("%c %s %s %" PRIi64 ": ", (file_ix < (u32) ds->old_file_cnt ? '<' : '>'), ds->filename [file_ix], (ds->file_is_text [file_ix] ? "line" : "record"),
+			item_number);
+	write_record_as_rle (&rec, ds->gg, stdout);
+}
+
+// Compares the old and new still lifes in one partition that fits in memory
+static __not_inline int compare_partition_in_memory (DiffState *ds, FILE *f, s64 size)
+{
+	u8 *data = malloc (size > 0 ? size : 1);
+	s64 max_entry_cnt = size / DIFF_ENTRY_HEADER_SIZE;
+	u8 **entry = malloc ((max_entry_cnt > 0 ? max_entry_cnt : 1) * sizeof (u8 *));
+	
+	if (!data || !entry || fseek (f, 0, SEEK_SET) != 0 || fread (data, 1, size, f) != (size_t) size)
+	{
+		fprintf (stderr, "Failed to read back a temporary file of %" PRIi64 " bytes\n", size);
+		free (data);
+		free (entry);
+		return FALSE;
+	}
+	
+	s64 entry_cnt = 0;
+	s64 offset = 0;
+	while (offset < size)
+	{
+		u16 record_size;
+		memcpy (&record_size, data + offset + 12, 2);
+		entry [entry_cnt++] = data + offset;
+		offset += DIFF_ENTRY_HEADER_SIZE + record_size;
+	}
+	
+	qsort (entry, entry_cnt, sizeof (u8 *), compare_diff_entries);
+	
+	s64 run_on = 0;
+	while (run_on < entry_cnt)
+	{
+		s64 side_cnt [2] = {0, 0};
+		s64 run_off = run_on;
+		
+		while (run_off < entry_cnt && memcmp (entry [run_on], entry [run_off], 8) == 0 &&
+				memcmp (entry [run_on] + DIFF_ENTRY_HEADER_SIZE, entry [run_off] + DIFF_ENTRY_HEADER_SIZE, 2) == 0)
+		{
+			u32 file_ix;
+			memcpy (&file_ix, entry [run_off] + 8, 4);
+			side_cnt [file_ix >= (u32) ds->old_file_cnt]++;
+			run_off++;
+		}
+		
+		s32 side;
+		for (side = 0; side < 2; side++)
+			if (side_cnt [side] > 1)
+				ds->duplicate_cnt [side] += side_cnt [side] - 1;
+		
+		// The first entry of a run is from the old side if there is any, so a still life only in the new side starts with a new entry
+		if (side_cnt [0] == 0 || side_cnt [1] == 0)
+		{
+			ds->only_cnt [side_cnt [0] == 0]++;
+			print_diff_entry (ds, entry [run_on]);
+		}
+		
+		run_on = run_off;
+	}
+	
+	free (data);
+	free (entry);
+	return TRUE;
+}
+
+// A partition that doesn't fit in memory is split further by the next bits of the hash. If all entries have the same hash nothing can be split, so then it is
+// compared in memory anyway
+static __not_inline int compare_partition (DiffState *ds, FILE *f, s32 used_bit_cnt)
+{
+	if (fseek_s64 (f, 0, SEEK_END) != 0)
+		return FALSE;
+	
+	s64 size = ftell_s64 (f);
+	if (size < 0)
+		return FALSE;
+	
+	s64 needed_size = size + ((size / DIFF_ENTRY_HEADER_SIZE) * sizeof (u8 *));
+	if (needed_size <= ds->memory_limit || used_bit_cnt + DIFF_SPLIT_BITS > 64)
+		return compare_partition_in_memory (ds, f, size);
+	
+	FILE *part [1 << DIFF_SPLIT_BITS];
+	s32 part_ix;
+	for (part_ix = 0; part_ix < (1 << DIFF_SPLIT_BITS); part_ix++)
+		part [part_ix] = NULL;
+	
+	int success = (fseek (f, 0, SEEK_SET) == 0);
+	for (part_ix = 0; success && part_ix < (1 << DIFF_SPLIT_BITS); part_ix++)
+	{
+		part [part_ix] = tmpfile ();
+		success = (part [part_ix] != NULL);
+	}
+	
+	u8 entry [DIFF_ENTRY_HEADER_SIZE + STILLDB_MAX_RECORD_SIZE];
+	s64 offset = 0;
+	while (success && offset < size)
+	{
+		u64 hash;
+		u16 record_size;
+		
+		success = (fread (entry, 1, DIFF_ENTRY_HEADER_SIZE, f) == DIFF_ENTRY_HEADER_SIZE);
+		if (success)
+		{
+			memcpy (&hash, entry, 8);
+			memcpy (&record_size, entry + 12, 2);
+			success = (record_size <= STILLDB_MAX_RECORD_SIZE && fread (entry + DIFF_ENTRY_HEADER_SIZE, 1, record_size, f) == record_size);
+		}
+		
+		if (success)
+		{
+			part_ix = (hash >> (64 - (used_bit_cnt + DIFF_SPLIT_BITS))) & ((1 << DIFF_SPLIT_BITS) - 1);
+			success = (fwrite (entry, 1, DIFF_ENTRY_HEADER_SIZE + record_size, part [part_ix]) == (size_t) (DIFF_ENTRY_HEADER_SIZE + record_size));
+			offset += DIFF_ENTRY_HEADER_SIZE + record_size;
+		}
+	}
+	
+	if (!success)
+		fprintf (stderr, "Failed to split a temporary file of %" PRIi64 " bytes\n", size);
+	
+	for (part_ix = 0; part_ix < (1 << DIFF_SPLIT_BITS); part_ix++)
+		if (part [part_ix])
+		{
+			if (success)
+				success = compare_partition (ds, part [part_ix], used_bit_cnt + DIFF_SPLIT_BITS);
+			
+			fclose (part [part_ix]);
+		}
+	
+	return success;
+}
+
+// Compares two sets of database files as sets of still lifes, regardless of their order, orientation and file format. All still lifes are read once and
+// written to partition files by the top bits of their canonical hash, and then each partition is sorted in memory to find the still lifes that are only on
+// one side. The number of partitions is chosen from the size of the files so that each one normally fits in memory_limit bytes
+static __not_inline int diff_databases (const char *const *filename, s32 old_file_cnt, s32 new_file_cnt, s64 memory_limit)
+{
+	double start_time = get_wall_time ();
+	
+	DiffState ds;
+	memset (&ds, 0, sizeof (DiffState));
+	ds.filename = filename;
+	ds.file_cnt = old_file_cnt + new_file_cnt;
+	ds.old_file_cnt = old_file_cnt;
+	ds.memory_limit = memory_limit;
+	
+	s64 input_size = 0;
+	s32 file_ix;
+	for (file_ix = 0; file_ix < ds.file_cnt; file_ix++)
+	{
+		s64 file_size = get_file_size (filename [file_ix]);
+		if (file_size < 0)
+		{
+			fprintf (stderr, "Failed to open database file %s\n", filename [file_ix]);
+			return FALSE;
+		}
+		
+		input_size += file_size;
+	}
+	
+	while (ds.partition_bit_cnt < DIFF_MAX_PARTITION_BITS && (input_size * DIFF_SPILL_BYTES_PER_INPUT_BYTE) >> ds.partition_bit_cnt > memory_limit)
+		ds.partition_bit_cnt++;
+	
+	ds.partition_cnt = 1 << ds.partition_bit_cnt;
+	ds.partition = calloc (ds.partition_cnt, sizeof (FILE *));
+	ds.file_is_text = calloc (ds.file_cnt, 1);
+	ds.gg = GoLUtils_alloc_std_grid (0, 0, 64, STILLDB_MAX_SIDE);
+	
+	int success = (ds.partition && ds.file_is_text && ds.gg && StillDBIndex_create_hasher (&ds.hasher));
+	if (!success)
+		fprintf (stderr, "Out of memory\n");
+	
+	s32 partition_ix;
+	for (partition_ix = 0; success && partition_ix < ds.partition_cnt; partition_ix++)
+	{
+		ds.partition [partition_ix] = tmpfile ();
+		if (!ds.partition [partition_ix])
+		{
+			fprintf (stderr, "Failed to create temporary file\n");
+			success = FALSE;
+		}
+	}
+	
+	s64 still_life_cnt = 0;
+	for (file_ix = 0; success && file_ix < ds.file_cnt; file_ix++)
+	{
+		ds.cur_file_ix = file_ix;
+		success = read_database (filename [file_ix], 1, spill_still_life, &ds, &still_life_cnt);
+	}
+	
+	for (partition_ix = 0; partition_ix < ds.partition_cnt; partition_ix++)
+		if (ds.partition && ds.partition [partition_ix])
+		{
+			if (success)
+				success = compare_partition (&ds, ds.partition [partition_ix], ds.partition_bit_cnt);
+			
+			fclose (ds.partition [partition_ix]);
+		}
+	
+	if (ds.hasher.pattern)
+		StillDBIndex_close (&ds.hasher);
+	if (ds.gg)
+		GoLUtils_free_std_grid (&ds.gg);
+	
+	free (ds.partition);
+	free (ds.file_is_text);
+	
+	if (fflush (stdout) != 0)
+	{
+		fprintf (stderr, "Write error on output\n");
+		success = FALSE;
+	}
+	
+	if (!success)
+		return FALSE;
+	
+	double diff_time = get_wall_time () - start_time;
+	fprintf (stderr, "%" PRIi64 " still lifes in %d old files and %" PRIi64 " in %d new files, %" PRIi64 " only in the old and %" PRIi64 " only in the new files, compared in %.3f s",
+			ds.still_life_cnt [0], old_file_cnt, ds.still_life_cnt [1], new_file_cnt, ds.only_cnt [0], ds.only_cnt [1], diff_time);
+	
+	if (ds.partition_cnt > 1)
+		fprintf (stderr, " with %d partitions", ds.partition_cnt);
+	
+	fprintf (stderr, "\n");
+	
+	if (ds.duplicate_cnt [0] > 0 || ds.duplicate_cnt [1] > 0)
+		fprintf (stderr, "The old files have %" PRIi64 " and the new files %" PRIi64 " extra copies of still lifes they already have\n", ds.duplicate_cnt [0],
+				ds.duplicate_cnt [1]);
+	
+	return (ds.only_cnt [0] == 0 && ds.only_cnt [1] == 0);
+}
+
+static __not_inline int main_diff (int argc, const char *const *argv)
+{
+	int usage_fail = FALSE;
+	u32 cl_memory_mb = DEFAULT_DIFF_MEMORY_MB;
+	s32 first_file_arg = 2;
+	
+	if (argc > 3 && strcmp (argv [2], "-m") == 0)
+	{
+		if (!str_to_u32 (argv [3], &cl_memory_mb) || cl_memory_mb == 0)
+			usage_fail = TRUE;
+		
+		first_file_arg = 4;
+	}
+	
+	// The files of the two sides are separated by "--", which can be left out if there is only one file on each side
+	const char **filename = malloc ((argc > first_file_arg ? argc - first_file_arg : 1) * sizeof (const char *));
+	if (!filename)
+		return FALSE;
+	
+	s32 file_cnt = 0;
+	s32 old_file_cnt = -1;
+	
+	s32 arg_ix;
+	for (arg_ix = first_file_arg; arg_ix < argc; arg_ix++)
+	{
+		if (strcmp (argv [arg_ix], "--") != 0)
+			filename [file_cnt++] = argv [arg_ix];
+		else if (old_file_cnt < 0)
+			old_file_cnt = file_cnt;
+		else
+			usage_fail = TRUE;
+	}
+	
+	if (old_file_cnt < 0 && file_cnt == 2)
+		old_file_cnt = 1;
+	
+	if (old_file_cnt <= 0 || old_file_cnt >= file_cnt)
+		usage_fail = TRUE;
+	
+	if (usage_fail)
+	{
+		fprintf (stderr, "USAGE: scdb diff [-m <megabytes>] <old database file> <new database file>\n");
+		fprintf (stderr, "       scdb diff [-m <megabytes>] <old database file> [...] -- <new database file> [...]\n");
+		fprintf (stderr, "where the still lifes that are only on one side are listed, using about <megabytes> of memory (default %d)\n", DEFAULT_DIFF_MEMORY_MB);
+		free (filename);
+		return FALSE;
+	}
+	
+	int success = diff_databases (filename, old_file_cnt, file_cnt - old_file_cnt, (s64) cl_memory_mb * 1024 * 1024);
+	free (filename);
+	return success;
+}
+
+// Reads every still life of the database files, to check that they can be read and to see how fast. Text files are decoded by thread_cnt threads
+static __not_inline int count_databases (const char *const *filename, s32 file_cnt, s32 thread_cnt)
+{
+	double start_time = get_wall_time ();
+	s64 total_still_life_cnt = 0;
+	s64 total_size = 0;
+	
+	s32 file_ix;
+	for (file_ix = 0; file_ix < file_cnt; file_ix++)
+	{
+		s64 file_size = get_file_size (filename [file_ix]);
+		s64 still_life_cnt = 0;
+		
+		if (file_size < 0)
+		{
+			fprintf (stderr, "Failed to open database file %s\n", filename [file_ix]);
+			return FALSE;
+		}
+		
+		if (!read_database (filename [file_ix], thread_cnt, NULL, NULL, &still_life_cnt))
+			return FALSE;
+		
+		printf ("%" PRIi64 " still lifes in %s\n", still_life_cnt, filename [file_ix]);
+		total_still_life_cnt += still_life_cnt;
+		total_size += file_size;
+	}
+	
+	double count_time = get_wall_time () - start_time;
+	printf ("%" PRIi64 " still lifes in %d files, read in %.3f s with %d threads, %.1f MB/s\n", total_still_life_cnt, file_cnt, count_time, thread_cnt,
+			(count_time > 0.0 ? (total_size / (1024.0 * 1024.0)) / count_time : 0.0));
+	
+	if (fflush (stdout) != 0)
+	{
+		fprintf (stderr, "Write error on output\n");
+		return FALSE;
+	}
+	
+	return TRUE;
+}
+
+static __not_inline int main_count (int argc, const char *const *argv)
+{
+	u32 cl_thread_cnt = 1;
+	s32 first_file_arg = 2;
+	
+	if (argc > 3 && strcmp (argv [2], "-t") == 0)
+	{
+		if (!str_to_u32 (argv [3], &cl_thread_cnt) || cl_thread_cnt > STILLDB_READER_MAX_THREADS)
+			cl_thread_cnt = 0;
+		
+		first_file_arg = 4;
+	}
+	
+	if (cl_thread_cnt == 0 || argc <= first_file_arg)
+	{
+		fprintf (stderr, "USAGE: scdb count [-t <threads>] <database file> [...]\n");
+		fprintf (stderr, "where every still life in the database files is read, decoding text files with 1 to %d threads (default 1)\n", STILLDB_READER_MAX_THREADS);
+		return FALSE;
+	}
+	
+	return count_databases (argv + first_file_arg, argc - first_file_arg, (s32) cl_thread_cnt);
+}
+
+static __not_inline int lookup_pattern (const StillDBIndex *ix, StillDBIndex *hash_ix, GoLGrid *gg, const char *pattern)
+{
+	s32 on_cnt;
+	s32 kind;
+	s32 part_cnt;
+	
+	if (!parse_pattern_line (pattern, gg))
+	{
+		printf ("%s: not a pattern of at most 64 by 64 cells\n", pattern);
+		return FALSE;
+	}
+	
+	if (!StillDBIndex_lookup (ix, StillDBIndex_hash_grid (hash_ix, gg), &on_cnt, &kind, &part_cnt))
+	{
+		printf ("%s: not found\n", pattern);
+		return FALSE;
+	}
+	
+	printf ("%s: %d bit %s still life", pattern, on_cnt, (kind == STILLDB_KIND_PSEUDO ? "pseudo" : "strict"));
+	if (part_cnt > 0)
+		printf (" in %d parts", part_cnt);
+	
+	printf ("\n");
+	return TRUE;
+}
+
+// Looks up the patterns given on the command line, or if there are none, each line of stdin. Any orientation and position of a still life is found
+static __not_inline int lookup_patterns (const char *index_filename, const char *const *pattern, s32 pattern_cnt)
+{
+	StillDBIndex ix;
+	if (!StillDBIndex_open (&ix, index_filename))
+	{
+		fprintf (stderr, "%s is not an index file made by this version of scdb\n", index_filename);
+		return FALSE;
+	}
+	
+	GoLGrid *gg = GoLUtils_alloc_std_grid (0, 0, 64, STILLDB_MAX_SIDE);
+	if (!gg)
+	{
+		StillDBIndex_close (&ix);
+		return FALSE;
+	}
+	
+	double start_time = get_wall_time ();
+	s64 lookup_cnt = 0;
+	s64 found_cnt = 0;
+	int success = TRUE;
+	
+	s32 pattern_ix;
+	for (pattern_ix = 0; pattern_ix < pattern_cnt; pattern_ix++)
+	{
+		lookup_cnt++;
+		found_cnt += lookup_pattern (&ix, &ix, gg, pattern [pattern_ix]);
+	}
+	
+	if (pattern_cnt == 0)
+	{
+		char line [LIFE_HISTORY_BUFFER_SIZE];
+		s32 result;
+		
+		while ((result = read_line (stdin, line, LIFE_HISTORY_BUFFER_SIZE)) != 0)
+		{
+			if (result < 0)
+			{
+				fprintf (stderr, "Line %" PRIi64 " of the input is too long\n", lookup_cnt + 1);
+				success = FALSE;
+				break;
+			}
+			
+			if (line [0] == '\0')
+				continue;
+			
+			lookup_cnt++;
+			found_cnt += lookup_pattern (&ix, &ix, gg, line);
+		}
+	}
+	
+	double lookup_time = get_wall_time () - start_time;
+	fprintf (stderr, "%" PRIi64 " of %" PRIi64 " patterns found, %.2f us per lookup\n", found_cnt, lookup_cnt, (lookup_cnt > 0 ? (1e6 * lookup_time) / lookup_cnt : 0.0));
+	
+	GoLUtils_free_std_grid (&gg);
+	StillDBIndex_close (&ix);
+	
+	if (fflush (stdout) != 0)
+	{
+		fprintf (stderr, "Write error on output\n");
+		return FALSE;
+	}
+	
+	return (success && found_cnt == lookup_cnt);
+}
+
+static __not_inline int main_do (int argc, const char *const *argv)
+{
+	int usage_fail = FALSE;
+	u32 cl_on_cnt;
+	u32 cl_part_cnt = 0;
+	s32 on_cnt = -1;
+	s32 kind = STILLDB_KIND_STRICT;
+	
+	if (argc >= 4 && strcmp (argv [1], "index") == 0)
+		return build_index (argv [2], argv + 3, argc - 3);
+	
+	if (argc >= 3 && strcmp (argv [1], "lookup") == 0)
+		return lookup_patterns (argv [2], argv + 3, argc - 3);
+	
+	if (argc >= 2 && strcmp (argv [1], "diff") == 0)
+		return main_diff (argc, argv);
+	
+	if (argc >= 2 && strcmp (argv [1], "count") == 0)
+		return main_count (argc, argv);
+	
+	if (argc < 3)
+		usage_fail = TRUE;
+	
+	if (!usage_fail && strcmp (argv [1], "rle") != 0 && strcmp (argv [1], "info") != 0)
+		usage_fail = TRUE;
+	
+	if (!usage_fail && strcmp (argv [1], "info") == 0 && argc != 3)
+		usage_fail = TRUE;
+	
+	if (!usage_fail && strcmp (argv [1], "rle") == 0 && argc != 3)
+	{
+		if (argc < 5 || argc > 6 || !str_to_u32 (argv [3], &cl_on_cnt) || (argc == 6 && !str_to_u32 (argv [5], &cl_part_cnt)))
+			usage_fail = TRUE;
+		else if (strcmp (argv [4], "strict") == 0 && argc == 5)
+			kind = STILLDB_KIND_STRICT;
+		else if (strcmp (argv [4], "pseudo") == 0)
+			kind = STILLDB_KIND_PSEUDO;
+		else
+			usage_fail = TRUE;
+		
+		on_cnt = (s32) cl_on_cnt;
+	}
+	
+	if (usage_fail)
+	{
+		fprintf (stderr, "USAGE: scdb rle <database file> [<on cells> <strict|pseudo> [<parts>]]\n");
+		fprintf (stderr, "       scdb info <database file>\n");
+		fprintf (stderr, "       scdb index <index file> <database file> [<database file> ...]\n");
+		fprintf (stderr, "       scdb lookup <index file> [<pattern> ...]\n");
+		fprintf (stderr, "       scdb diff [-m <megabytes>] <old database file> [...] [--] <new database file> [...]\n");
+		fprintf (stderr, "       scdb count [-t <threads>] <database file> [...]\n");
+		fprintf (stderr, "where \"rle\" writes the still lifes in a binary .sldb file to stdout in the same format as the text database files,\n");
+		fprintf (stderr, "selecting the still lifes with the given number of on cells, kind and number of parts from a single file written with -s\n");
+		fprintf (stderr, "or a stream written with -o, and \"info\" shows the search parameters and the number of still lifes in the file.\n");
+		fprintf (stderr, "<database file> may be \"-\" to read a stream of records from stdin.\n");
+		fprintf (stderr, "\"index\" makes an index of the still lifes in text or binary database files, and \"lookup\" finds the bit count and kind of\n");
+		fprintf (stderr, "each pattern, given as RLE or an apgcode, in an index, reading the patterns from stdin if none are given.\n");
+		fprintf (stderr, "\"diff\" lists the still lifes that are only in the old or only in the new database files, in any order and format\n");
+		fprintf (stderr, "\"count\" reads every still life in the database files and shows how many there are and how fast they were read\n");
+		return FALSE;
+	}
+	
+	return convert_to_rle (argv [2], stdout, (strcmp (argv [1], "info") == 0), on_cnt, kind, (s32) cl_part_cnt);
+}
+
+int main (int argc, const char *const *argv)
+{
+	if (!main_do (argc, argv))
+		return EXIT_FAILURE;
+	
+	return EXIT_SUCCESS;
+}
@@ -1,8 +1,27 @@
+// For dup, dup2 and fdopen, which are used to stream records to stdout, clock_gettime, and fsync, gethostname and fcntl for the campaign ledger
+#ifndef _WIN32
+	#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdlib.h>
 #include <inttypes.h>
 #include <memory.h>
 #include <time.h>
 #include <stdio.h>
+#include <pthread.h>
+#include <errno.h>
+
+#ifdef _WIN32
+	#include <io.h>
+	#include <fcntl.h>
+	#include <direct.h>
+	#include <process.h>
+	#include <sys/locking.h>
+#else
+	#include <unistd.h>
+	#include <fcntl.h>
+	#include <sys/stat.h>
+#endif
 
 #include "lib/lib.c"
 #include "lib/rect.c"
@@ -13,6 +32,12 @@
 #include "lib/gridunsafe.c"
 #include "lib/gridmisc.c"
 #include "lib/golutils.c"
+#include "lib/stilldb.c"
+#include "lib/stilldbcontainer.c"
+#include "lib/stilldbreader.c"
+#include "lib/asyncwriter.c"
+#include "lib/runmanifest.c"
+#include "lib/campaignledger.c"
 
 #ifdef _WIN32
 	#define USE_PERF_TIMER
@@ -31,8 +56,29 @@
 #define MAX_BIT_CNT (MAX_ON_CELLS - 16)
 #define OPEN_CELL_CNT (25 * MAX_ON_CELLS)
 #define MAX_PARTITIONS 20
+#define MAX_INTERACTION_CELLS (8 * MAX_ON_CELLS)
+// More parts than a pattern can have islands, so that any real partitioning compares as having fewer parts
+#define NO_STABLE_PARTITIONING (MAX_PARTITIONS + 1)
+#define ISLAND_SET_CACHE_BITS 12
+#define ISLAND_SET_CACHE_MAX_SIDE 16
+#define ISLAND_SET_CACHE_MIN_ISLANDS 3
 #define REMAINING_CELLS_THRESHOLD_FOR_UNCONNECTABLE_CHECK 5
-#define FILE_BUFFER_SIZE (8192 * 1024)
+#define OUTPUT_MIN_CHUNK_SIZE (4 * 1024)
+#define OUTPUT_MAX_CHUNK_SIZE (1024 * 1024)
+#define DEFAULT_OUTPUT_MEMORY_MB 32
+#define LIFE_HISTORY_BUFFER_SIZE 16384
+#define METADATA_COLUMNS_SIZE 64
+#define LEAF_RING_SIZE 1024
+#define LEAF_RING_SPIN_CNT 1000
+#define MAX_CLASSIFIER_THREADS 64
+#define CANCEL_CHECK_INTERVAL 4096
+#define VERIFY_CHUNK_TEXT_SIZE (256 * 1024)
+#define VERIFY_CHUNK_RECORD_CNT 1024
+#define VERIFY_CHUNKS_PER_THREAD 2
+#define VERIFY_MAX_REPORTED_STILL_LIFES 20
+#define VERIFY_CHUNK_FREE 0
+#define VERIFY_CHUNK_FILLED 1
+#define VERIFY_CHUNK_TAKEN 2
 
 #define TAG_SIZE 9
 #define TAG_CNT_AT_TAG_SIZE_9 3006
@@ -40,56 +86,296 @@
 #define WANTED_SEARCH_SUBSETS 100
 #define MAX_OPS_IN_SUBSET_LOW_ESTIMATE 12000000
 
+#define SHADOW_UNDEF 0x01
+#define SHADOW_ON 0x10
+
+// The transformations of a pattern within its bounding box, as bits in the set of symmetries found by is_canonical
+#define TRANSFORM_IDENTITY 0x01
+#define TRANSFORM_FLIP_X 0x02
+#define TRANSFORM_FLIP_Y 0x04
+#define TRANSFORM_ROTATE_180 0x08
+#define TRANSFORM_FLIP_DIAGONAL 0x10
+#define TRANSFORM_ROTATE_90 0x20
+#define TRANSFORM_ROTATE_270 0x40
+#define TRANSFORM_FLIP_ANTI_DIAGONAL 0x80
+
+#define SYMMETRY_C1 0
+#define SYMMETRY_C2 1
+#define SYMMETRY_C4 2
+#define SYMMETRY_D2_ORTHOGONAL 3
+#define SYMMETRY_D2_DIAGONAL 4
+#define SYMMETRY_D4_ORTHOGONAL 5
+#define SYMMETRY_D4_DIAGONAL 6
+#define SYMMETRY_D8 7
+#define SYMMETRY_CLASS_CNT 8
+
+// A taken define is packed as (cell_ix << 2) | (state << 1) | is_forced, where cell_ix is (y * GRID_WIDTH) + x
+typedef u16 TakenDefine;
+
+// An off-cell that is adjacent to more than one island of a pattern. Bit n of birth_subsets is set if the adjacent islands selected by bit 0 to 3 of n give the cell
+// exactly three on-neighbours. Unused entries of island_ix are set to 31
 typedef struct
 {
-	s32 x;
-	s32 y;
-	int state;
-	int is_forced;
-} TakenDefine;
+	u8 island_ix [4];
+	u16 birth_subsets;
+} InteractionCell;
 
 typedef struct
 {
-	s8 defined_may_be_stabilized_table [9] [9] [2];
-	s8 undefined_may_be_stabilized_table [9] [9];
+	s32 island_cnt;
+	s32 interaction_cell_cnt;
+	InteractionCell interaction_cell [MAX_INTERACTION_CELLS];
+	
+	// The on-cells as (y * GRID_WIDTH) + x and the island of each one
+	s32 on_cell_cnt;
+	u16 on_cell [MAX_ON_CELLS];
+	u8 island_of_on_cell [MAX_ON_CELLS];
+} IslandGraph;
+
+// The cells of a set of islands that fits in ISLAND_SET_CACHE_MAX_SIDE by ISLAND_SET_CACHE_MAX_SIDE cells, moved to the top left corner and turned to the
+// orientation that compares lowest, so the same islands in the same relative position give the same key in any pattern. Bit x of row [y] is the cell (x, y)
+typedef struct
+{
+	u16 row [ISLAND_SET_CACHE_MAX_SIDE];
+} IslandSetKey;
+
+// Remembers the fewest stable parts of island sets that are not stable as a whole. This only depends on the cells of the islands, as all islands of a stable
+// pattern are stable, so the same blocks, beehives and boats in the same positions are found again in other leaves. The table is direct-mapped and kept by
+// each classifier for all of its leaves, and a fewest_parts of 0 marks an unused entry
+typedef struct
+{
+	s64 lookup_cnt;
+	s64 hit_cnt;
+	IslandSetKey key [1 << ISLAND_SET_CACHE_BITS];
+	u8 fewest_parts [1 << ISLAND_SET_CACHE_BITS];
+} IslandSetCache;
+
+// A leaf of the search as handed over to a classifier thread, holding only the populated rows of the on-cells grid
+typedef struct
+{
+	s32 on_cnt;
+	s32 pop_x_on;
+	s32 pop_x_off;
+	s32 pop_y_on;
+	s32 pop_y_off;
+	u64 row [GRID_HEIGHT];
+} LeafRecord;
+
+// A lock-free ring with a single producer (the search) and a single consumer (one classifier thread). Only the search writes head and only the classifier writes
+// tail, and the two are kept in separate cache lines. A side that finds the ring empty or full spins for a while, and then sets its waiting flag and sleeps on
+// the condition variable. The other side only takes the mutex to wake it when it sees that flag, so the mutex is not touched while both are busy
+typedef struct
+{
+	LeafRecord *leaf;
+	int search_done;
+	pthread_mutex_t mutex;
+	pthread_cond_t wake;
+	u8 padding_0 [64];
+	u64 head;
+	int classifier_waiting;
+	u8 padding_1 [64];
+	u64 tail;
+	int search_waiting;
+	u8 padding_2 [64];
+} LeafRing;
+
+// Histograms of the still lifes found for each bit count, the first two by kind (0 for strict and 1 for pseudo still lifes). The bounding box is counted in the
+// canonical orientation, where the width is at least the height
+typedef struct
+{
+	s64 symmetry_cnt [MAX_BIT_CNT + 1] [2] [SYMMETRY_CLASS_CNT];
+	s64 island_cnt [MAX_BIT_CNT + 1] [2] [MAX_PARTITIONS + 1];
+	s64 bounding_box_cnt [MAX_BIT_CNT + 1] [GRID_WIDTH + 1] [GRID_WIDTH + 1];
+} Census;
+
+// A still life found by run_search. The grid is the one the still life was classified in, and is only borrowed for the duration of the solution callback. It
+// is GRID_WIDTH cells wide with one u64 per row, and the population rectangle is set to the bounding box of the still life, which is in canonical orientation
+typedef struct
+{
+	const GoLGrid *on_cells;
+	s32 on_cnt;
+	int is_pseudo;
 	
-	int write_files;
+	// The lowest number of stable parts a pseudo still life can be divided into, or 0 for a strict still life
+	s32 part_cnt;
 	
-	s32 min_wanted_bit_cnt;
-	s32 max_wanted_bit_cnt;
+	// The transformations that leave the still life unchanged, see TRANSFORM_IDENTITY, and the number of islands it is made of
+	u32 symmetries;
+	s32 island_cnt;
 	
-	s32 search_subset;
-	s32 wanted_tag_on;
-	s32 wanted_tag_off;
+	// The classifier thread that found the still life, or 0 without classifier threads
+	s32 classifier_ix;
+} SearchSolution;
+
+// Where the search is when the progress callback is called. The grids are borrowed like the one in SearchSolution
+typedef struct
+{
+	s64 op_cnt;
+	s32 cur_tag_ix;
 	
-	GoLGrid *undef_cells;
+	// The number of still lifes with max_bit_cnt cells found so far, which may lag behind the search when there are classifier threads
+	s64 strict_cnt;
+	s64 pseudo_cnt;
+	
+	const GoLGrid *on_cells;
+	const GoLGrid *undef_cells;
+} SearchProgress;
+
+// The callbacks return FALSE to stop the search. The solution callback is called from all classifier threads at once when there are more than one
+typedef int (*SearchSolutionCallback) (void *context, const SearchSolution *sol);
+typedef int (*SearchProgressCallback) (void *context, const SearchProgress *progress);
+
+// What run_search looks for and who it tells about it. Only the tags of TAG_SIZE cells from first_tag up to but not including end_tag are searched, where
+// end_tag -1 searches to the end of the search space, see tag_size_9_in_subsets. A NULL solution callback only counts the still lifes. The progress callback
+// is called before the first search operation and then every progress_interval operations. The grid visualization and the table of the number of operations
+// at the start of each tag (with TAG_CNT_AT_TAG_SIZE_9 + 1 entries) are optional
+typedef struct
+{
+	s32 min_bit_cnt;
+	s32 max_bit_cnt;
+	s32 first_tag;
+	s32 end_tag;
+	s32 classifier_thread_cnt;
+	int keep_census;
+	
+	SearchSolutionCallback solution_callback;
+	void *solution_context;
+	SearchProgressCallback progress_callback;
+	void *progress_context;
+	s64 progress_interval;
+	
+	GridVisualization *grid_visualization;
+	s64 *op_cnt_at_new_tag;
+} SearchConfig;
+
+// The counts are complete even for a cancelled search, but only cover the part of the search space that was searched. The census is only kept when asked for
+// and is freed by free_search_result
+typedef struct
+{
+	int cancelled;
+	s64 op_cnt;
+	
+	s64 not_stable_cnt;
+	s64 not_canonical_cnt;
+	s64 not_connected_cnt;
+	s64 strict_sol_cnt [MAX_BIT_CNT + 1];
+	s64 pseudo_sol_cnt [MAX_BIT_CNT + 1];
+	s64 pseudo_degree_cnt [MAX_BIT_CNT + 1] [MAX_PARTITIONS + 1];
+	s64 island_set_cache_lookup_cnt;
+	s64 island_set_cache_hit_cnt;
+	Census *census;
+} SearchResult;
+
+// Everything needed to classify a leaf of the search. Without classifier threads there is a single classifier that looks directly at the grid of the search,
+// otherwise each thread has its own classifier with a copy of the leaf
+typedef struct
+{
 	GoLGrid *on_cells;
 	s32 on_cnt;
 	
-	u8 undef_shadow [GRID_WIDTH] [GRID_HEIGHT];
-	u8 on_shadow [GRID_WIDTH] [GRID_HEIGHT];
+	s64 not_stable_cnt;
+	s64 not_canonical_cnt;
+	s64 not_connected_cnt;
+	s64 strict_sol_cnt [MAX_BIT_CNT + 1];
+	s64 pseudo_sol_cnt [MAX_BIT_CNT + 1];
+	s64 pseudo_degree_cnt [MAX_BIT_CNT + 1] [MAX_PARTITIONS + 1];
 	
-	s32 taken_define_cnt;
-	TakenDefine taken_define [OPEN_CELL_CNT];
+	// The symmetries of the current leaf, set by verify_possible_solution, and the histograms, which are only kept when asked for
+	u32 symmetries;
+	Census *census;
 	
+	IslandGraph island_graph;
+	IslandSetCache *island_set_cache;
+	LeafRing ring;
+} Classifier;
+
+typedef struct
+{
+	// The members used for every search operation are kept together at the start, so that the whole working state of the search fits in the L1 cache
+	s32 on_cnt;
+	s32 taken_define_cnt;
 	int new_on_cells_defined;
 	int new_tag_cells_defined;
 	
 	s64 op_cnt;
 	s32 cur_tag_ix;
 	
-	FILE *strict_file [MAX_BIT_CNT + 1];
-	FILE *pseudo_file [MAX_BIT_CNT + 1];
+	s32 min_wanted_bit_cnt;
+	s32 max_wanted_bit_cnt;
 	
-	s64 not_stable_cnt;
-	s64 not_canonical_cnt;
-	s64 not_connected_cnt;
-	s64 strict_sol_cnt [MAX_BIT_CNT + 1];
-	s64 pseudo_sol_cnt [MAX_BIT_CNT + 1];
+	GoLGrid *undef_cells;
+	GoLGrid *on_cells;
+	
+	s8 defined_may_be_stabilized_table [9] [9] [2];
+	s8 undefined_may_be_stabilized_table [9] [9];
+	
+	// Each entry is either 0 (defined off-cell), SHADOW_UNDEF or SHADOW_ON, stored row by row. Summing the eight neighbours of a cell gives the number of
+	// undefined neighbours in the low nibble and the number of on-neighbours in the high nibble
+	u8 shadow [GRID_HEIGHT * GRID_WIDTH];
+	
+	TakenDefine taken_define [OPEN_CELL_CNT];
+	
+	s32 wanted_tag_on;
+	s32 wanted_tag_off;
+	
+	// The search as given to run_search. cancelled is set when a callback asks to stop the search, which is then left at the next check in the search loop
+	const SearchConfig *cfg;
+	int cancelled;
+	
+	// With classifier_thread_cnt set to 0 the leaves are classified in the search loop by classifier [0]
+	s32 classifier_thread_cnt;
+	s32 next_classifier_ix;
+	Classifier *classifier;
 	
 	GridVisualization *gv;
 } SearchState;
 
+// The files and streams that the command line search writes the still lifes to, from the solution callback of run_search
+typedef struct
+{
+	s32 min_wanted_bit_cnt;
+	s32 max_wanted_bit_cnt;
+	s32 search_subset;
+	
+	int write_files;
+	int write_degree_files;
+	int write_binary_files;
+	int write_single_file;
+	int write_delta_coded_files;
+	int write_apgcodes;
+	int keep_census;
+	int report_complex_pseudo_still_lifes;
+	s64 output_memory_limit;
+	
+	// Stream indices in writer, or -1 for files that are not open
+	s32 strict_stream [MAX_BIT_CNT + 1];
+	s32 pseudo_stream [MAX_BIT_CNT + 1];
+	s32 degree_stream [MAX_BIT_CNT + 1] [MAX_PARTITIONS + 1];
+	
+	// The stream of framed records of all still lifes selected with -o, owned by writer once record_stream_ix is set
+	FILE *record_stream;
+	const char *record_stream_name;
+	s32 record_stream_ix;
+	
+	// Gets the size and checksum of each output when the files are closed, and the counts at the end of the search
+	RunManifest *manifest;
+	
+	AsyncWriter writer;
+	StillDBContainer container;
+	StillDB_Codec *codec;
+	
+	// Taken around the output of each still life when more than one classifier thread writes
+	int lock_output;
+	pthread_mutex_t output_mutex;
+} OutputState;
+
+typedef struct
+{
+	SearchState *st;
+	Classifier *cl;
+	pthread_t thread;
+} ClassifierThread;
+
 #if SELECTED_SEARCH_SUBSETS == 16
 	static s32 tag_size_9_in_subsets [SELECTED_SEARCH_SUBSETS + 1] = {0, 177, 364, 549, 716, 876, 1068, 1235, 1396, 1596, 1783, 2017, 2207, 2364, 2550, 2815, 3006};
 #elif SELECTED_SEARCH_SUBSETS == 100
@@ -126,14 +412,15 @@ static __not_inline void visualize_cur (SearchState *st)
 		}
 }
 
+// The scratch grids here and in the other functions used to classify leaves are thread local, as they are used both by the search and by classifier threads
 static __not_inline int get_connected_part (const GoLGrid *src, GoLGrid *dst)
 {
-	static int static_init = FALSE;
-	static GoLGrid *all_bleed_3_or_more;
-	static GoLGrid *cur_included;
-	static GoLGrid *bleed_8;
-	static GoLGrid *connecting_cells;
-	static GoLGrid *new_included_mask;
+	static __thread int static_init = FALSE;
+	static __thread GoLGrid *all_bleed_3_or_more;
+	static __thread GoLGrid *cur_included;
+	static __thread GoLGrid *bleed_8;
+	static __thread GoLGrid *connecting_cells;
+	static __thread GoLGrid *new_included_mask;
 	
 	if (!static_init)
 	{
@@ -219,44 +506,62 @@ static __not_inline int is_connectable (SearchState *st)
 	return !(GoLGrid_are_disjoint_64_wide (connection_cell_area, possible_connection_cells));
 }
 
-static __force_inline void add_preliminary_define (SearchState *st, s32 cell_x, s32 cell_y, int state, int is_forced)
+static __force_inline TakenDefine make_taken_define (s32 cell_ix, int state, int is_forced)
 {
-	TakenDefine *td = &st->taken_define [st->taken_define_cnt];
-	st->taken_define_cnt++;
-	
-	td->x = cell_x;
-	td->y = cell_y;
-	td->state = state;
-	td->is_forced = is_forced;
-	
-	st->undef_shadow [cell_x] [cell_y] = 0;
+	return (TakenDefine) ((cell_ix << 2) | (state << 1) | is_forced);
+}
+
+static __force_inline s32 taken_define_cell_ix (TakenDefine td)
+{
+	return td >> 2;
+}
+
+static __force_inline int taken_define_state (TakenDefine td)
+{
+	return (td >> 1) & 1;
+}
+
+static __force_inline int taken_define_is_forced (TakenDefine td)
+{
+	return td & 1;
+}
+
+static __force_inline s32 shadow_neighbour_sum (const SearchState *st, s32 cell_ix)
+{
+	const u8 *upper = &st->shadow [cell_ix - GRID_WIDTH];
+	const u8 *mid = &st->shadow [cell_ix];
+	const u8 *lower = &st->shadow [cell_ix + GRID_WIDTH];
 	
-	if (state)
-		st->on_shadow [cell_x] [cell_y] = 1;
+	return upper [-1] + upper [0] + upper [1] + mid [-1] + mid [1] + lower [-1] + lower [0] + lower [1];
 }
 
-static __force_inline int verify_cell_stability_and_take_forced (SearchState *st, s32 cell_x, s32 cell_y)
+static __force_inline void add_preliminary_define (SearchState *st, s32 cell_ix, int state, int is_forced)
 {
-	s32 on_cnt = 0;
-	s32 undef_cnt = 0;
-	s32 y;
-	s32 x;
+	st->taken_define [st->taken_define_cnt] = make_taken_define (cell_ix, state, is_forced);
+	st->taken_define_cnt++;
 	
-	for (y = cell_y - 1; y <= cell_y + 1; y++)
-		for (x = cell_x - 1; x <= cell_x + 1; x++)
-			if (y != cell_y || x != cell_x)
-			{
-				on_cnt += st->on_shadow [x] [y];
-				undef_cnt += st->undef_shadow [x] [y];
-			}
+	st->shadow [cell_ix] = (state ? SHADOW_ON : 0);
+}
+
+static __force_inline void add_preliminary_define_to_undef_neighbour (SearchState *st, s32 cell_ix, int state)
+{
+	if (st->shadow [cell_ix] == SHADOW_UNDEF)
+		add_preliminary_define (st, cell_ix, state, TRUE);
+}
+
+static __force_inline int verify_cell_stability_and_take_forced (SearchState *st, s32 cell_ix)
+{
+	s32 neighbour_sum = shadow_neighbour_sum (st, cell_ix);
+	s32 on_cnt = neighbour_sum >> 4;
+	s32 undef_cnt = neighbour_sum & 0x0f;
 	
 	// We can sometimes define an undefined center cell to a particular value, or we can define the unknown neighbours of a defined center cell to a particular common value, but we can never do both in B3/S23
-	if (st->undef_shadow [cell_x] [cell_y])
+	if (st->shadow [cell_ix] == SHADOW_UNDEF)
 	{
 		int stability = st->undefined_may_be_stabilized_table [undef_cnt] [on_cnt];
 		if (stability == 2)
 		{
-			add_preliminary_define (st, cell_x, cell_y, stability - 2, TRUE);
+			add_preliminary_define (st, cell_ix, stability - 2, TRUE);
 			return TRUE;
 		}
 		else
@@ -264,14 +569,17 @@ static __force_inline int verify_cell_stability_and_take_forced (SearchState *st
 	}
 	else
 	{
-		int stability = st->defined_may_be_stabilized_table [undef_cnt] [on_cnt] [st->on_shadow [cell_x] [cell_y]];
+		int stability = st->defined_may_be_stabilized_table [undef_cnt] [on_cnt] [st->shadow [cell_ix] >> 4];
 		if (stability > 1)
 		{
-			for (y = cell_y - 1; y <= cell_y + 1; y++)
-				for (x = cell_x - 1; x <= cell_x + 1; x++)
-					if (y != cell_y || x != cell_x)
-						if (st->undef_shadow [x] [y])
-							add_preliminary_define (st, x, y, stability - 2, TRUE);
+			add_preliminary_define_to_undef_neighbour (st, cell_ix - GRID_WIDTH - 1, stability - 2);
+			add_preliminary_define_to_undef_neighbour (st, cell_ix - GRID_WIDTH, stability - 2);
+			add_preliminary_define_to_undef_neighbour (st, cell_ix - GRID_WIDTH + 1, stability - 2);
+			add_preliminary_define_to_undef_neighbour (st, cell_ix - 1, stability - 2);
+			add_preliminary_define_to_undef_neighbour (st, cell_ix + 1, stability - 2);
+			add_preliminary_define_to_undef_neighbour (st, cell_ix + GRID_WIDTH - 1, stability - 2);
+			add_preliminary_define_to_undef_neighbour (st, cell_ix + GRID_WIDTH, stability - 2);
+			add_preliminary_define_to_undef_neighbour (st, cell_ix + GRID_WIDTH + 1, stability - 2);
 			
 			return TRUE;
 		}
@@ -285,20 +593,18 @@ static __force_inline int verify_suggested_define_and_take_forced (SearchState *
 	s32 taken_define_ix = st->taken_define_cnt - 1;
 	while (TRUE)
 	{
-		TakenDefine *td = &st->taken_define [taken_define_ix];
+		s32 cell_ix = taken_define_cell_ix (st->taken_define [taken_define_ix]);
 		
 		// Test for consequences of the newly added cell first
-		if (!(verify_cell_stability_and_take_forced (st, td->x, td->y)))
+		if (!(verify_cell_stability_and_take_forced (st, cell_ix)))
 			return FALSE;
 		
-		// Then test for consequences for the neighbours of the newly added cell
-		s32 y;
-		s32 x;
-		for (y = td->y - 1; y <= td->y + 1; y++)
-			for (x = td->x - 1; x <= td->x + 1; x++)
-				if (y != td->y || x != td->x)
-					if (!(verify_cell_stability_and_take_forced (st, x, y)))
-						return FALSE;
+		// Then test for consequences for the neighbours of the newly added cell, in the same order as they are laid out in memory
+		if (!(verify_cell_stability_and_take_forced (st, cell_ix - GRID_WIDTH - 1)) || !(verify_cell_stability_and_take_forced (st, cell_ix - GRID_WIDTH)) ||
+				!(verify_cell_stability_and_take_forced (st, cell_ix - GRID_WIDTH + 1)) || !(verify_cell_stability_and_take_forced (st, cell_ix - 1)) ||
+				!(verify_cell_stability_and_take_forced (st, cell_ix + 1)) || !(verify_cell_stability_and_take_forced (st, cell_ix + GRID_WIDTH - 1)) ||
+				!(verify_cell_stability_and_take_forced (st, cell_ix + GRID_WIDTH)) || !(verify_cell_stability_and_take_forced (st, cell_ix + GRID_WIDTH + 1)))
+			return FALSE;
 		
 		if (taken_define_ix >= st->taken_define_cnt - 1)
 			break;
@@ -314,12 +620,7 @@ static __force_inline void undo_preliminary_defines (SearchState *st, s32 prev_t
 	while (st->taken_define_cnt > prev_taken_define_cnt)
 	{
 		st->taken_define_cnt--;
-		TakenDefine *td = &st->taken_define [st->taken_define_cnt];
-		
-		st->undef_shadow [td->x] [td->y] = 1;
-		
-		if (td->state)
-			st->on_shadow [td->x] [td->y] = 0;
+		st->shadow [taken_define_cell_ix (st->taken_define [st->taken_define_cnt])] = SHADOW_UNDEF;
 	}
 }
 
@@ -328,13 +629,15 @@ static __force_inline void finalize_preliminary_defines (SearchState *st, s32 pr
 	s32 taken_define_ix = prev_taken_define_cnt;
 	while (taken_define_ix < st->taken_define_cnt)
 	{
-		TakenDefine *td = &st->taken_define [taken_define_ix];
+		TakenDefine td = st->taken_define [taken_define_ix];
+		s32 x = taken_define_cell_ix (td) % GRID_WIDTH;
+		s32 y = taken_define_cell_ix (td) / GRID_WIDTH;
 		
-		GoLGrid_set_cell_off_64_wide_zero_org_unchanged_bb_unchecked (st->undef_cells, td->x, td->y);
+		GoLGrid_set_cell_off_64_wide_zero_org_unchanged_bb_unchecked (st->undef_cells, x, y);
 		
-		if (td->state == 1)
+		if (taken_define_state (td))
 		{
-			GoLGrid_set_cell_on_64_wide_zero_org_unchecked (st->on_cells, td->x, td->y);
+			GoLGrid_set_cell_on_64_wide_zero_org_unchecked (st->on_cells, x, y);
 			st->new_on_cells_defined = TRUE;
 			st->on_cnt++;
 			if (st->on_cnt <= TAG_SIZE)
@@ -345,11 +648,11 @@ static __force_inline void finalize_preliminary_defines (SearchState *st, s32 pr
 	}
 }
 
-static __not_inline int try_define_cell (SearchState *st, s32 cell_x, s32 cell_y, int state)
+static __not_inline int try_define_cell (SearchState *st, s32 cell_ix, int state)
 {
 	s32 cur_taken_define_cnt = st->taken_define_cnt;
 	
-	add_preliminary_define (st, cell_x, cell_y, state, FALSE);
+	add_preliminary_define (st, cell_ix, state, FALSE);
 	int could_be_stabilized = verify_suggested_define_and_take_forced (st);
 	
 	if (!could_be_stabilized)
@@ -360,22 +663,23 @@ static __not_inline int try_define_cell (SearchState *st, s32 cell_x, s32 cell_y
 	return could_be_stabilized;
 }
 
-static __force_inline const TakenDefine *undo_taken_define (SearchState *st)
+static __force_inline TakenDefine undo_taken_define (SearchState *st)
 {
 	st->taken_define_cnt--;
-	TakenDefine *td = &st->taken_define [st->taken_define_cnt];
+	TakenDefine td = st->taken_define [st->taken_define_cnt];
+	s32 x = taken_define_cell_ix (td) % GRID_WIDTH;
+	s32 y = taken_define_cell_ix (td) / GRID_WIDTH;
 	
-	GoLGrid_set_cell_on_64_wide_zero_org_unchanged_bb_unchecked (st->undef_cells, td->x, td->y);
-	st->undef_shadow [td->x] [td->y] = 1;
+	GoLGrid_set_cell_on_64_wide_zero_org_unchanged_bb_unchecked (st->undef_cells, x, y);
+	st->shadow [taken_define_cell_ix (td)] = SHADOW_UNDEF;
 	
-	if (td->state)
+	if (taken_define_state (td))
 	{
-		GoLGrid_set_cell_off_64_wide_zero_org_unchecked (st->on_cells, td->x, td->y);
-		st->on_shadow [td->x] [td->y] = 0;
+		GoLGrid_set_cell_off_64_wide_zero_org_unchecked (st->on_cells, x, y);
 		st->on_cnt--;
 	}
 	
-	return &st->taken_define [st->taken_define_cnt];
+	return td;
 }
 
 static __force_inline s32 distance_from_start_cell (s32 x, s32 y)
@@ -500,78 +804,146 @@ static __not_inline int find_cell_to_define (SearchState *st, s32 *cell_to_defin
 	return FALSE;
 }
 
-static __not_inline int compare_cell_lists (const ObjCellList *list_1, const ObjCellList *list_2)
+// Returns 1 if the rows of org are lexicographically above the rows of other, 0 if they are equal and -1 if they are below, where other is read with a step of
+// +1 or -1 between rows. Rows are aligned so that the leftmost column is the most significant bit, so this ordering is the same as comparing the sorted cell
+// lists with the first differing cell deciding
+static __force_inline s32 compare_rows (const u64 *org, const u64 *other, s32 other_step, s32 row_cnt)
 {
-	if (list_1->obj_rect.width != list_2->obj_rect.width || list_1->obj_rect.height != list_2->obj_rect.height || list_1->cell_cnt != list_2->cell_cnt)
-		return ffsc (__func__);
-	
-	s32 cell_ix;
-	for (cell_ix = 0; cell_ix < list_1->cell_cnt; cell_ix++)
+	s32 row_ix;
+	for (row_ix = 0; row_ix < row_cnt; row_ix++)
 	{
-		s32 x1 = list_1->cell [cell_ix].x;
-		s32 y1 = list_1->cell [cell_ix].y;
-		s32 x2 = list_2->cell [cell_ix].x;
-		s32 y2 = list_2->cell [cell_ix].y;
-		
-		if (y1 > y2 || (y1 == y2 && x1 > x2))
-			return 1;
-		if (y1 < y2 || (y1 == y2 && x1 < x2))
-			return -1;
+		u64 other_row = other [row_ix * other_step];
+		if (org [row_ix] != other_row)
+			return (org [row_ix] > other_row ? 1 : -1);
 	}
 	
 	return 0;
 }
 
-static __not_inline int is_canonical (const GoLGrid *gg)
+// Returns TRUE if none of the horizontal and vertical flips of the rows in trans is lexicographically below the rows of org. In that case bit 0 to 3 of
+// equal_mask are set for trans, its horizontal flip, its vertical flip and both flips, if they are equal to org
+static __force_inline int is_below_flips (const u64 *org, const u64 *trans, const u64 *trans_flipped, s32 row_cnt, u32 *equal_mask)
 {
-	static ObjCellList org;
-	static ObjCellList_Cell org_cell [MAX_ON_CELLS];
-	static ObjCellList trans;
-	static ObjCellList_Cell trans_cell [MAX_ON_CELLS];
+	s32 order_0 = compare_rows (org, trans, 1, row_cnt);
+	if (order_0 > 0)
+		return FALSE;
 	
-	ObjCellList_make_empty (&org, org_cell, MAX_ON_CELLS);
-	ObjCellList_make_empty (&trans, trans_cell, MAX_ON_CELLS);
+	s32 order_1 = compare_rows (org, trans_flipped, 1, row_cnt);
+	if (order_1 > 0)
+		return FALSE;
+	
+	s32 order_2 = compare_rows (org, trans + (row_cnt - 1), -1, row_cnt);
+	if (order_2 > 0)
+		return FALSE;
 	
-	GoLGrid_to_obj_cell_list (gg, &org);
-	if (org.obj_rect.width < org.obj_rect.height)
+	s32 order_3 = compare_rows (org, trans_flipped + (row_cnt - 1), -1, row_cnt);
+	if (order_3 > 0)
 		return FALSE;
 	
-	ObjCellList_copy (&org, &trans);
+	*equal_mask = (order_0 == 0 ? 1 : 0) | (order_1 == 0 ? 2 : 0) | (order_2 == 0 ? 4 : 0) | (order_3 == 0 ? 8 : 0);
+	return TRUE;
+}
+
+// The pattern is shifted to the origin and compared with its flips one row at a time, which gives the same canonical orientation as comparing sorted cell lists.
+// As all orientations are compared anyway, the ones that leave a canonical pattern unchanged are returned in symmetries, see TRANSFORM_IDENTITY
+static __not_inline int is_canonical (const GoLGrid *gg, u32 *symmetries)
+{
+	static __thread u64 org [64];
+	static __thread u64 org_flipped [64];
+	static __thread u64 trans [64];
+	static __thread u64 trans_flipped [64];
+	
+	s32 width = gg->pop_x_off - gg->pop_x_on;
+	s32 height = gg->pop_y_off - gg->pop_y_on;
+	if (width < height)
+		return FALSE;
 	
-	if (org.obj_rect.width == org.obj_rect.height)
+	s32 row_ix;
+	for (row_ix = 0; row_ix < height; row_ix++)
 	{
-		ObjCellList_flip_horizontally (&trans);
-		if (compare_cell_lists (&org, &trans) < 0)
-			return FALSE;
-		ObjCellList_flip_vertically (&trans);
-		if (compare_cell_lists (&org, &trans) < 0)
-			return FALSE;
-		ObjCellList_flip_horizontally (&trans);
-		if (compare_cell_lists (&org, &trans) < 0)
-			return FALSE;
-		
-		ObjCellList_flip_diagonally (&trans);
-		if (compare_cell_lists (&org, &trans) < 0)
-			return FALSE;
+		org [row_ix] = gg->grid [gg->pop_y_on + row_ix] << gg->pop_x_on;
+		org_flipped [row_ix] = bit_reverse_u64 (org [row_ix]) << (64 - width);
 	}
 	
-	ObjCellList_flip_horizontally (&trans);
-	if (compare_cell_lists (&org, &trans) < 0)
-		return FALSE;
-	ObjCellList_flip_vertically (&trans);
-	if (compare_cell_lists (&org, &trans) < 0)
+	// The untransformed pattern itself is also compared here, but it can never be below itself
+	u32 equal_mask;
+	if (!is_below_flips (org, org, org_flipped, height, &equal_mask))
 		return FALSE;
-	ObjCellList_flip_horizontally (&trans);
-	if (compare_cell_lists (&org, &trans) < 0)
+	
+	*symmetries = equal_mask;
+	if (width != height)
+		return TRUE;
+	
+	s32 block_cnt = (width + 15) >> 4;
+	for (row_ix = 0; row_ix < (block_cnt << 4); row_ix++)
+	{
+		if (row_ix >= height)
+			org [row_ix] = 0;
+		trans [row_ix] = 0;
+	}
+	
+	s32 y_block_ix;
+	s32 x_block_ix;
+	for (y_block_ix = 0; y_block_ix < block_cnt; y_block_ix++)
+		for (x_block_ix = 0; x_block_ix < block_cnt; x_block_ix++)
+		{
+			u64 word_0;
+			u64 word_1;
+			u64 word_2;
+			u64 word_3;
+			
+			GoLGrid_int_fetch_16_by_16_block (org + (y_block_ix << 4), x_block_ix, &word_0, &word_1, &word_2, &word_3);
+			GoLGrid_int_flip_diagonally_16_by_16_block (&word_0, &word_1, &word_2, &word_3);
+			GoLGrid_int_write_16_by_16_block (word_0, word_1, word_2, word_3, trans + (x_block_ix << 4), y_block_ix);
+		}
+	
+	for (row_ix = 0; row_ix < height; row_ix++)
+		trans_flipped [row_ix] = bit_reverse_u64 (trans [row_ix]) << (64 - width);
+	
+	if (!is_below_flips (org, trans, trans_flipped, height, &equal_mask))
 		return FALSE;
 	
+	*symmetries |= equal_mask << 4;
 	return TRUE;
 }
 
+static const char *symmetry_class_name [SYMMETRY_CLASS_CNT] = {"C1", "C2", "C4", "D2+", "D2x", "D4+", "D4x", "D8"};
+
+// Sorts a pattern into one of the eight symmetry classes from the set of transformations that leave it unchanged
+static __not_inline s32 get_symmetry_class (u32 symmetries)
+{
+	s32 symmetry_cnt = bit_count_u64 (symmetries);
+	
+	if (symmetry_cnt == 8)
+		return SYMMETRY_D8;
+	
+	if (symmetry_cnt == 4)
+	{
+		if (symmetries & (TRANSFORM_ROTATE_90 | TRANSFORM_ROTATE_270))
+			return SYMMETRY_C4;
+		else if (symmetries & TRANSFORM_FLIP_X)
+			return SYMMETRY_D4_ORTHOGONAL;
+		else
+			return SYMMETRY_D4_DIAGONAL;
+	}
+	
+	if (symmetry_cnt == 2)
+	{
+		if (symmetries & TRANSFORM_ROTATE_180)
+			return SYMMETRY_C2;
+		else if (symmetries & (TRANSFORM_FLIP_X | TRANSFORM_FLIP_Y))
+			return SYMMETRY_D2_ORTHOGONAL;
+		else
+			return SYMMETRY_D2_DIAGONAL;
+	}
+	
+	return SYMMETRY_C1;
+}
+
 static __not_inline int is_connected (const GoLGrid *gg)
 {
-	static int static_init = FALSE;
-	static GoLGrid *connected;
+	static __thread int static_init = FALSE;
+	static __thread GoLGrid *connected;
 	
 	if (!static_init)
 	{
@@ -582,10 +954,10 @@ static __not_inline int is_connected (const GoLGrid *gg)
 	return get_connected_part (gg, connected);
 }
 
-static __not_inline int verify_possible_solution (SearchState *st)
+static __not_inline int verify_possible_solution (Classifier *cl)
 {
-	static int static_init = FALSE;
-	static GoLGrid *evolved;
+	static __thread int static_init = FALSE;
+	static __thread GoLGrid *evolved;
 	
 	if (!static_init)
 	{
@@ -593,155 +965,381 @@ static __not_inline int verify_possible_solution (SearchState *st)
 		evolved = alloc_grid ();
 	}
 	
-	GoLGrid_evolve_64_wide (st->on_cells, evolved);
-	if (!GoLGrid_is_equal_64_wide (st->on_cells, evolved))
+	GoLGrid_evolve_64_wide (cl->on_cells, evolved);
+	if (!GoLGrid_is_equal_64_wide (cl->on_cells, evolved))
 	{
-		st->not_stable_cnt++;
+		cl->not_stable_cnt++;
 		return FALSE;
 	}
 	
-	if (!is_canonical (st->on_cells))
+	if (!is_canonical (cl->on_cells, &cl->symmetries))
 	{
-		st->not_canonical_cnt++;
+		cl->not_canonical_cnt++;
 		return FALSE;
 	}
 	
-	if (!is_connected (st->on_cells))
+	if (!is_connected (cl->on_cells))
 	{
-		st->not_connected_cnt++;
+		cl->not_connected_cnt++;
 		return FALSE;
 	}
 	
 	return TRUE;
 }
 
-static __not_inline s32 partition_into_islands (const GoLGrid *gg, ObjCellList *list)
+static __force_inline s32 find_island_root (s32 *parent, s32 label)
 {
-	static int static_init = FALSE;
-	static GoLGrid *remaining;
-	static GoLGrid *cur_part;
-	static GoLGrid *bleed_8;
-	static GoLGrid *new_part;
-	
-	if (!static_init)
+	while (parent [label] != label)
 	{
-		static_init = TRUE;
-		remaining = alloc_grid ();
-		cur_part = alloc_grid ();
-		bleed_8 = alloc_grid ();
-		new_part = alloc_grid ();
+		parent [label] = parent [parent [label]];
+		label = parent [label];
 	}
 	
-	GoLGrid_copy_64_wide (gg, remaining);
+	return label;
+}
+
+static __force_inline void join_islands (s32 *parent, s32 label_1, s32 label_2)
+{
+	s32 root_1 = find_island_root (parent, label_1);
+	s32 root_2 = find_island_root (parent, label_2);
 	
-	s32 part_cnt = 0;
-	while (TRUE)
+	if (root_1 < root_2)
+		parent [root_2] = root_1;
+	else
+		parent [root_1] = root_2;
+}
+
+// Builds the interaction graph of a stable pattern. Islands are never adjacent, so every on-cell and every off-cell next to a single island keeps its state in any
+// subset of islands that includes or excludes that island. Only off-cells next to two or more islands can then make a subset of islands unstable, namely by
+// getting exactly three on-neighbours in that subset. Such cells are recorded together with the subsets of their adjacent islands that cause a birth
+// Islands are numbered in the order of their first on-cell, row by row and from left to right within each row
+static __not_inline void make_island_graph (const GoLGrid *gg, IslandGraph *ig)
+{
+	static const s32 neighbour_offset [8] = {-GRID_WIDTH - 1, -GRID_WIDTH, -GRID_WIDTH + 1, -1, 1, GRID_WIDTH - 1, GRID_WIDTH, GRID_WIDTH + 1};
+	
+	// These are indexed by (y * GRID_WIDTH) + x and are returned to all zeros before this function returns. In adjacent_island, 0 means no adjacent island,
+	// (island_ix + 1) means a single adjacent island and 0xff means more than one
+	static __thread u8 island_of_cell [GRID_HEIGHT * GRID_WIDTH];
+	static __thread u8 adjacent_island [GRID_HEIGHT * GRID_WIDTH];
+	static __thread u8 neighbour_cnt [GRID_HEIGHT * GRID_WIDTH];
+	
+	u16 on_cell [MAX_ON_CELLS];
+	s32 parent [MAX_ON_CELLS + 1];
+	u16 shared_cell [MAX_INTERACTION_CELLS];
+	
+	ig->island_cnt = 0;
+	ig->interaction_cell_cnt = 0;
+	
+	s32 on_cell_cnt = 0;
+	s32 row_ix;
+	for (row_ix = gg->pop_y_on; row_ix < gg->pop_y_off; row_ix++)
 	{
-		if (GoLGrid_is_empty (remaining))
-			break;
-		
-		s32 x;
-		s32 y;
-		if (!GoLGrid_find_next_on_cell_64_wide (remaining, TRUE, &x, &y))
-			break;
-		
-		GoLGrid_clear_64_wide (cur_part);
-		GoLGrid_set_cell_on_64_wide_zero_org_unchecked (cur_part, x, y);
-		
-		while (TRUE)
+		u64 grid_word = gg->grid [row_ix];
+		while (grid_word != 0)
 		{
-			GoLGrid_bleed_8_64_wide (cur_part, bleed_8);
-			GoLGrid_and_64_wide (remaining, bleed_8, new_part);
+			s32 first_bit = most_significant_bit_u64 (grid_word);
+			grid_word &= ~(((u64) 1) << first_bit);
 			
-			if (GoLGrid_is_equal_64_wide (new_part, cur_part))
-				break;
+			if (on_cell_cnt >= MAX_ON_CELLS)
+			{
+				fprintf (stderr, "More than %d on-cells in pattern\n", MAX_ON_CELLS);
+				exit (EXIT_FAILURE);
+			}
 			
-			GoLGrid_copy_64_wide (new_part, cur_part);
+			on_cell [on_cell_cnt++] = (row_ix * GRID_WIDTH) + (63 - first_bit);
 		}
+	}
+	
+	// Label the on-cells with the union-find method, looking at the four neighbours that come before each cell
+	s32 on_cell_ix;
+	for (on_cell_ix = 0; on_cell_ix < on_cell_cnt; on_cell_ix++)
+	{
+		s32 cell_ix = on_cell [on_cell_ix];
+		s32 label = on_cell_ix + 1;
+		parent [label] = label;
+		island_of_cell [cell_ix] = label;
 		
-		GoLGrid_to_obj_cell_list (cur_part, &list [part_cnt]);
-		GoLGrid_subtract_64_wide (remaining, cur_part);
-		part_cnt++;
+		s32 neighbour_ix;
+		for (neighbour_ix = 0; neighbour_ix < 4; neighbour_ix++)
+			if (island_of_cell [cell_ix + neighbour_offset [neighbour_ix]])
+				join_islands (parent, label, island_of_cell [cell_ix + neighbour_offset [neighbour_ix]]);
 	}
 	
-	return part_cnt;
-}
-
-static __not_inline int is_stable_subset (const ObjCellList *list, u64 partition_mask)
-{
-	static int static_init = FALSE;
-	static GoLGrid *subset;
-	static GoLGrid *evolved;
+	// Each root is the lowest label of its island, so the islands are numbered in the order of their first on-cell
+	s32 island_of_root [MAX_ON_CELLS + 1];
+	for (on_cell_ix = 0; on_cell_ix < on_cell_cnt; on_cell_ix++)
+		island_of_root [on_cell_ix + 1] = -1;
 	
-	if (!static_init)
+	for (on_cell_ix = 0; on_cell_ix < on_cell_cnt; on_cell_ix++)
 	{
-		static_init = TRUE;
-		subset = alloc_grid ();
-		evolved = alloc_grid ();
+		s32 root = find_island_root (parent, on_cell_ix + 1);
+		if (island_of_root [root] < 0)
+		{
+			if (ig->island_cnt >= MAX_PARTITIONS)
+			{
+				fprintf (stderr, "More than %d islands in pattern\n", MAX_PARTITIONS);
+				exit (EXIT_FAILURE);
+			}
+			
+			island_of_root [root] = ig->island_cnt;
+			ig->island_cnt++;
+		}
 	}
 	
-	GoLGrid_clear_noinline (subset);
-	while (partition_mask)
+	ig->on_cell_cnt = on_cell_cnt;
+	for (on_cell_ix = 0; on_cell_ix < on_cell_cnt; on_cell_ix++)
 	{
-		s32 list_ix = least_significant_bit_u64 (partition_mask);
-		GoLGrid_or_obj_cell_list_noinline (subset, &list [list_ix], 0, 0);
-		partition_mask = partition_mask ^ (((u64) 1) << list_ix);
+		ig->on_cell [on_cell_ix] = on_cell [on_cell_ix];
+		ig->island_of_on_cell [on_cell_ix] = island_of_root [find_island_root (parent, on_cell_ix + 1)];
+		island_of_cell [on_cell [on_cell_ix]] = 1 + ig->island_of_on_cell [on_cell_ix];
 	}
 	
-	GoLGrid_evolve_noinline (subset, evolved);
-	return GoLGrid_is_equal_noinline (subset, evolved);
-}
-
-static __not_inline int has_stable_partitioning (const ObjCellList *list, s32 list_cnt, int allow_more_than_two_parts, int is_already_a_partition)
-{
-	if (is_already_a_partition)
+	s32 shared_cell_cnt = 0;
+	for (on_cell_ix = 0; on_cell_ix < on_cell_cnt; on_cell_ix++)
 	{
-		if (is_stable_subset (list, (((u64) 1) << list_cnt) - (u64) 1))
-			return TRUE;
-		else if (!allow_more_than_two_parts)
-			return FALSE;
+		s32 cell_ix = on_cell [on_cell_ix];
+		u8 island = island_of_cell [cell_ix];
+		
+		s32 neighbour_ix;
+		for (neighbour_ix = 0; neighbour_ix < 8; neighbour_ix++)
+		{
+			s32 neighbour_cell_ix = cell_ix + neighbour_offset [neighbour_ix];
+			neighbour_cnt [neighbour_cell_ix]++;
+			
+			if (adjacent_island [neighbour_cell_ix] == 0)
+				adjacent_island [neighbour_cell_ix] = island;
+			else if (adjacent_island [neighbour_cell_ix] != island && adjacent_island [neighbour_cell_ix] != 0xff)
+			{
+				adjacent_island [neighbour_cell_ix] = 0xff;
+				shared_cell [shared_cell_cnt++] = neighbour_cell_ix;
+			}
+		}
 	}
 	
-	s32 subset_cnt = 1 << list_cnt;
-	s32 subset_ix;
-	
-	// We test all possible subsets of the partitions where partition 0 is included, except for the one where all partitions are included
-	for (subset_ix = 1; subset_ix < subset_cnt - 2; subset_ix += 2)
-		if (is_stable_subset (list, subset_ix))
+	// A shared cell can only get exactly three on-neighbours in some subset of islands if it has at least four in the whole pattern, which is stable
+	s32 shared_cell_ix;
+	for (shared_cell_ix = 0; shared_cell_ix < shared_cell_cnt; shared_cell_ix++)
+	{
+		s32 cell_ix = shared_cell [shared_cell_ix];
+		if (neighbour_cnt [cell_ix] < 4)
+			continue;
+		
+		InteractionCell *ic = &ig->interaction_cell [ig->interaction_cell_cnt];
+		s32 island_neighbour_cnt [4] = {0, 0, 0, 0};
+		s32 adjacent_cnt = 0;
+		
+		// Unused entries refer to an island that is never part of a subset
+		s32 adjacent_ix;
+		for (adjacent_ix = 0; adjacent_ix < 4; adjacent_ix++)
+			ic->island_ix [adjacent_ix] = 31;
+		
+		s32 neighbour_ix;
+		for (neighbour_ix = 0; neighbour_ix < 8; neighbour_ix++)
 		{
-			// We have found a stable subset, now recursively check if the part of the pattern not included in that subset is stable, either as a whole or any partitioning of it
+			s32 island = island_of_cell [cell_ix + neighbour_offset [neighbour_ix]];
+			if (island == 0)
+				continue;
 			
-			ObjCellList obj [MAX_PARTITIONS];
-			ObjCellList_Cell obj_cell [MAX_PARTITIONS] [MAX_ON_CELLS];
+			for (adjacent_ix = 0; adjacent_ix < adjacent_cnt; adjacent_ix++)
+				if (ic->island_ix [adjacent_ix] == island - 1)
+					break;
 			
-			s32 remains_cnt = 0;
-			s32 remains_ix;
-			for (remains_ix = 0; remains_ix < list_cnt; remains_ix++)
-				if (((1 << remains_ix) & subset_ix) == 0)
-				{
-					ObjCellList_make_empty (&obj [remains_cnt], obj_cell [remains_cnt], MAX_ON_CELLS);
-					ObjCellList_copy (&list [remains_ix], &obj [remains_cnt]);
-					remains_cnt++;
-				}
+			// Neighbours from different islands can't be adjacent, so there are at most four different islands around a cell
+			if (adjacent_ix == adjacent_cnt)
+			{
+				ic->island_ix [adjacent_ix] = island - 1;
+				adjacent_cnt++;
+			}
+			
+			island_neighbour_cnt [adjacent_ix]++;
+		}
+		
+		ic->birth_subsets = 0;
+		u32 local_subset;
+		for (local_subset = 0; local_subset < 16; local_subset++)
+		{
+			s32 subset_neighbour_cnt = 0;
+			for (adjacent_ix = 0; adjacent_ix < 4; adjacent_ix++)
+				if ((local_subset >> adjacent_ix) & 1)
+					subset_neighbour_cnt += island_neighbour_cnt [adjacent_ix];
 			
-			if (has_stable_partitioning (obj, remains_cnt, allow_more_than_two_parts, TRUE))
-				return TRUE;
+			if (subset_neighbour_cnt == 3)
+				ic->birth_subsets |= (((u16) 1) << local_subset);
 		}
+		
+		if (ic->birth_subsets != 0)
+			ig->interaction_cell_cnt++;
+	}
 	
-	return FALSE;	
+	for (on_cell_ix = 0; on_cell_ix < on_cell_cnt; on_cell_ix++)
+	{
+		s32 cell_ix = on_cell [on_cell_ix];
+		island_of_cell [cell_ix] = 0;
+		
+		s32 neighbour_ix;
+		for (neighbour_ix = 0; neighbour_ix < 8; neighbour_ix++)
+		{
+			adjacent_island [cell_ix + neighbour_offset [neighbour_ix]] = 0;
+			neighbour_cnt [cell_ix + neighbour_offset [neighbour_ix]] = 0;
+		}
+	}
+}
+
+static __force_inline int is_stable_subset (const IslandGraph *ig, u32 subset)
+{
+	s32 interaction_cell_ix;
+	for (interaction_cell_ix = 0; interaction_cell_ix < ig->interaction_cell_cnt; interaction_cell_ix++)
+	{
+		const InteractionCell *ic = &ig->interaction_cell [interaction_cell_ix];
+		u32 local_subset = ((subset >> ic->island_ix [0]) & 1) | (((subset >> ic->island_ix [1]) & 1) << 1) | (((subset >> ic->island_ix [2]) & 1) << 2) | (((subset >> ic->island_ix [3]) & 1) << 3);
+		
+		if ((ic->birth_subsets >> local_subset) & 1)
+			return FALSE;
+	}
+	
+	return TRUE;
+}
+
+// Makes the key of an island set for the island set cache. Returns FALSE if the island set doesn't fit in a key
+static __not_inline int make_island_set_key (const IslandGraph *ig, u32 island_set, IslandSetKey *key)
+{
+	s32 cell_x [MAX_ON_CELLS];
+	s32 cell_y [MAX_ON_CELLS];
+	s32 cell_cnt = 0;
+	s32 min_x = GRID_WIDTH;
+	s32 min_y = GRID_HEIGHT;
+	s32 max_x = -1;
+	s32 max_y = -1;
+	
+	s32 on_cell_ix;
+	for (on_cell_ix = 0; on_cell_ix < ig->on_cell_cnt; on_cell_ix++)
+		if ((island_set >> ig->island_of_on_cell [on_cell_ix]) & 1)
+		{
+			s32 x = ig->on_cell [on_cell_ix] % GRID_WIDTH;
+			s32 y = ig->on_cell [on_cell_ix] / GRID_WIDTH;
+			cell_x [cell_cnt] = x;
+			cell_y [cell_cnt] = y;
+			cell_cnt++;
+			
+			if (x < min_x)
+				min_x = x;
+			if (x > max_x)
+				max_x = x;
+			if (y < min_y)
+				min_y = y;
+			if (y > max_y)
+				max_y = y;
+		}
+	
+	s32 width = 1 + max_x - min_x;
+	s32 height = 1 + max_y - min_y;
+	if (width > ISLAND_SET_CACHE_MAX_SIDE || height > ISLAND_SET_CACHE_MAX_SIDE)
+		return FALSE;
+	
+	// Bit 0 of the orientation mirrors x, bit 1 mirrors y and bit 2 then swaps x and y
+	s32 orientation;
+	for (orientation = 0; orientation < 8; orientation++)
+	{
+		IslandSetKey oriented;
+		memset (&oriented, 0, sizeof (IslandSetKey));
+		
+		s32 cell_ix;
+		for (cell_ix = 0; cell_ix < cell_cnt; cell_ix++)
+		{
+			s32 x = ((orientation & 1) ? max_x - cell_x [cell_ix] : cell_x [cell_ix] - min_x);
+			s32 y = ((orientation & 2) ? max_y - cell_y [cell_ix] : cell_y [cell_ix] - min_y);
+			if (orientation & 4)
+				oriented.row [x] |= (u16) (1 << y);
+			else
+				oriented.row [y] |= (u16) (1 << x);
+		}
+		
+		if (orientation == 0 || memcmp (&oriented, key, sizeof (IslandSetKey)) < 0)
+			*key = oriented;
+	}
+	
+	return TRUE;
 }
 
-static __not_inline int is_pseudo_still (SearchState *st, int allow_more_than_two_parts)
+static __force_inline u32 get_island_set_cache_entry_ix (const IslandSetKey *key)
 {
-	ObjCellList obj [MAX_PARTITIONS];
-	ObjCellList_Cell obj_cell [MAX_PARTITIONS] [MAX_ON_CELLS];
+	u64 word [sizeof (IslandSetKey) / sizeof (u64)];
+	memcpy (word, key, sizeof (IslandSetKey));
 	
-	s32 obj_ix;
-	for (obj_ix = 0; obj_ix < MAX_PARTITIONS; obj_ix++)
-		ObjCellList_make_empty (&obj [obj_ix], obj_cell [obj_ix], MAX_ON_CELLS);
+	u64 hash = 0;
+	s32 word_ix;
+	for (word_ix = 0; word_ix < (s32) (sizeof (IslandSetKey) / sizeof (u64)); word_ix++)
+		hash = (hash ^ word [word_ix]) * 0x9e3779b97f4a7c15u;
 	
-	s32 part_cnt = partition_into_islands (st->on_cells, obj);
-	return has_stable_partitioning (obj, part_cnt, allow_more_than_two_parts, FALSE);
+	return (u32) (hash >> (64 - ISLAND_SET_CACHE_BITS));
+}
+
+static __not_inline s32 fewest_stable_parts (const IslandGraph *ig, IslandSetCache *cache, u32 island_set);
+
+// Returns the lowest number of stable parts, at least two, that an island set can be divided into, or NO_STABLE_PARTITIONING
+static __not_inline s32 fewest_stable_parts_of_partitioning (const IslandGraph *ig, IslandSetCache *cache, u32 island_set)
+{
+	u32 first_island = island_set & (~island_set + 1);
+	u32 other_islands = island_set ^ first_island;
+	
+	s32 fewest_parts = NO_STABLE_PARTITIONING;
+	
+	// We test all possible subsets of the island set where the first island is included, except for the one where all islands are included. Two stable parts
+	// is the best possible result, so the search ends as soon as it is found
+	u32 other_subset = 0;
+	while (other_subset != other_islands && fewest_parts > 2)
+	{
+		u32 subset = first_island | other_subset;
+		
+		// If we have found a stable subset, recursively check how few stable parts the rest of the pattern can be divided into, one meaning that it is stable as a whole
+		if (is_stable_subset (ig, subset))
+		{
+			s32 remaining_parts = fewest_stable_parts (ig, cache, island_set ^ subset);
+			if (remaining_parts != NO_STABLE_PARTITIONING && 1 + remaining_parts < fewest_parts)
+				fewest_parts = 1 + remaining_parts;
+		}
+		
+		other_subset = (other_subset - other_islands) & other_islands;
+	}
+	
+	return fewest_parts;
+}
+
+// Returns the lowest number of stable parts that an island set can be divided into, one if it is stable, or NO_STABLE_PARTITIONING
+// Returns the lowest number of stable parts that an island set can be divided into, one if it is stable, or NO_STABLE_PARTITIONING. The cache may be NULL
+static __not_inline s32 fewest_stable_parts (const IslandGraph *ig, IslandSetCache *cache, u32 island_set)
+{
+	if (is_stable_subset (ig, island_set))
+		return 1;
+	
+	// A smaller island set is divided faster than its key is made
+	IslandSetKey key;
+	if (!cache || bit_count_u64 (island_set) < ISLAND_SET_CACHE_MIN_ISLANDS || !make_island_set_key (ig, island_set, &key))
+		return fewest_stable_parts_of_partitioning (ig, cache, island_set);
+	
+	u32 entry_ix = get_island_set_cache_entry_ix (&key);
+	cache->lookup_cnt++;
+	if (cache->fewest_parts [entry_ix] != 0 && memcmp (&cache->key [entry_ix], &key, sizeof (IslandSetKey)) == 0)
+	{
+		cache->hit_cnt++;
+		return cache->fewest_parts [entry_ix];
+	}
+	
+	s32 fewest_parts = fewest_stable_parts_of_partitioning (ig, cache, island_set);
+	
+	// The entry may have been taken by another island set during the recursion, which is then replaced
+	cache->key [entry_ix] = key;
+	cache->fewest_parts [entry_ix] = (u8) fewest_parts;
+	
+	return fewest_parts;
+}
+
+// The pattern must be stable. Returns the lowest number of stable parts the pattern can be divided into, which is at least two for a pseudo still life, or
+// NO_STABLE_PARTITIONING for a strict still life
+static __not_inline s32 get_pseudo_still_degree (Classifier *cl)
+{
+	make_island_graph (cl->on_cells, &cl->island_graph);
+	return fewest_stable_parts_of_partitioning (&cl->island_graph, cl->island_set_cache, (((u32) 1) << cl->island_graph.island_cnt) - 1);
 }
 
 // This inefficient evolve function is only used to build the stability tables
@@ -797,7 +1395,7 @@ static __not_inline void make_stability_tables (SearchState *st)
 					else
 						table_entry = 0;
 				}
-				
+	
 	 			st->defined_may_be_stabilized_table [unknown_cnt] [on_cnt] [cell_state] = table_entry;
 			}
 	
@@ -824,339 +1422,2301 @@ static __not_inline void make_stability_tables (SearchState *st)
 				else
 					table_entry = 1;
 			}
-			
+	
 	 		st->undefined_may_be_stabilized_table [unknown_cnt] [on_cnt] = table_entry;
 		}
 }
 
-static __not_inline int open_files (SearchState *st)
+static __not_inline void make_filename (const OutputState *os, s32 bit_cnt, const char *kind, char *filename)
 {
-	s32 bit_ix;
-	for (bit_ix = st->min_wanted_bit_cnt; bit_ix <= st->max_wanted_bit_cnt; bit_ix++)
+	const char *extension = (os->write_binary_files ? "sldb" : "txt");
+	
+	if (os->search_subset < 0)
+		sprintf (filename, "%02d_bits_%s.%s", bit_cnt, kind, extension);
+	else
+		sprintf (filename, "%02d_bits_%s_subset_%04d_of_%04d.%s", bit_cnt, kind, os->search_subset, SELECTED_SEARCH_SUBSETS, extension);
+}
+
+static __not_inline void make_file_header (const OutputState *os, s32 bit_cnt, s32 kind, s32 part_cnt, StillDB_FileHeader *fh)
+{
+	fh->on_cnt = bit_cnt;
+	fh->kind = kind;
+	fh->part_cnt = part_cnt;
+	fh->min_on_cnt = os->min_wanted_bit_cnt;
+	fh->max_on_cnt = os->max_wanted_bit_cnt;
+	fh->subset_cnt = (os->search_subset < 0 ? 0 : SELECTED_SEARCH_SUBSETS);
+	fh->subset = os->search_subset;
+	fh->encoding = (os->write_delta_coded_files ? STILLDB_ENCODING_DELTA : STILLDB_ENCODING_PLAIN);
+}
+
+// part_cnt is only used for pseudo still lifes that need a specific number of parts
+static __not_inline void make_kind_name (int is_pseudo, s32 part_cnt, char *kind)
+{
+	if (part_cnt > 0)
+		sprintf (kind, "pseudo_%d_parts", part_cnt);
+	else
+		strcpy (kind, (is_pseudo ? "pseudo" : "strict"));
+}
+
+// The name of a file for the whole search, like the single file written with -s
+static __not_inline void make_run_filename (const OutputState *os, const char *extension, char *filename)
+{
+	if (os->search_subset < 0)
+		sprintf (filename, "%02d_to_%02d_bits.%s", os->min_wanted_bit_cnt, os->max_wanted_bit_cnt, extension);
+	else
+		sprintf (filename, "%02d_to_%02d_bits_subset_%04d_of_%04d.%s", os->min_wanted_bit_cnt, os->max_wanted_bit_cnt, os->search_subset, SELECTED_SEARCH_SUBSETS,
+				extension);
+}
+
+// Opens a database file. part_cnt is only used for files of pseudo still lifes that need a specific number of parts
+static __not_inline FILE *open_output_file (const OutputState *os, s32 bit_cnt, int is_pseudo, s32 part_cnt)
+{
+	char kind [32];
+	char filename [64];
+	
+	make_kind_name (is_pseudo, part_cnt, kind);
+	make_filename (os, bit_cnt, kind, filename);
+	
+	return fopen (filename, (os->write_binary_files ? "wb" : "w"));
+}
+
+// Opens the single file that holds all still lifes of the search when the -s option is used
+static __not_inline int open_container (OutputState *os)
+{
+	char filename [64];
+	make_run_filename (os, "sldb", filename);
+	
+	FILE *f = fopen (filename, "wb");
+	if (!f)
+		return FALSE;
+	
+	StillDB_FileHeader fh;
+	make_file_header (os, 0, STILLDB_KIND_CONTAINER, 0, &fh);
+	
+	s32 bit_cnt_cnt = 1 + os->max_wanted_bit_cnt - os->min_wanted_bit_cnt;
+	if (!StillDBContainer_create (&os->container, f, &fh, bit_cnt_cnt * (MAX_PARTITIONS + 3)))
 	{
-		st->strict_file [bit_ix] = NULL;
-		st->pseudo_file [bit_ix] = NULL;
+		fclose (f);
+		return FALSE;
 	}
 	
-	char filename [64];
-	for (bit_ix = st->min_wanted_bit_cnt; bit_ix <= st->max_wanted_bit_cnt; bit_ix++)
+	return TRUE;
+}
+
+// Called in the writer thread
+static int write_container_block (void *context, s32 category_ix, const u8 *data, s32 size)
+{
+	return StillDBContainer_write_block ((StillDBContainer *) context, category_ix, data, size);
+}
+
+// Opens a database file, or a category in the single file, and hands it over to the writer thread. Returns the stream index, or -1 on failure
+static __not_inline s32 open_output_stream (OutputState *os, s32 bit_cnt, int is_pseudo, s32 part_cnt)
+{
+	s32 stream_ix;
+	
+	if (os->write_single_file)
 	{
-		if (st->search_subset < 0)
-			sprintf (filename, "%02d_bits_strict.txt", bit_ix);
-		else
-			sprintf (filename, "%02d_bits_strict_subset_%04d_of_%04d.txt", bit_ix, st->search_subset, SELECTED_SEARCH_SUBSETS);
+		s32 category_ix = StillDBContainer_add_category (&os->container, bit_cnt, (is_pseudo ? STILLDB_KIND_PSEUDO : STILLDB_KIND_STRICT), part_cnt);
+		if (category_ix < 0)
+			return -1;
 		
-		st->strict_file [bit_ix] = fopen (filename, "w");
-		if (!st->strict_file [bit_ix])
-			return FALSE;
-		if (setvbuf (st->strict_file [bit_ix], NULL, _IOFBF, FILE_BUFFER_SIZE))
-			return FALSE;
+		stream_ix = AsyncWriter_add_custom_stream (&os->writer, write_container_block, &os->container, category_ix);
+	}
+	else
+	{
+		FILE *f = open_output_file (os, bit_cnt, is_pseudo, part_cnt);
+		if (!f)
+			return -1;
+		
+		stream_ix = AsyncWriter_add_stream (&os->writer, f);
+		if (stream_ix < 0)
+			fclose (f);
+		
+		// The file header goes through the writer like the records, so that it is included in the checksum of the file
+		if (stream_ix >= 0 && os->write_binary_files)
+		{
+			u8 header [STILLDB_FILE_HEADER_SIZE];
+			StillDB_FileHeader fh;
+			make_file_header (os, bit_cnt, (is_pseudo ? STILLDB_KIND_PSEUDO : STILLDB_KIND_STRICT), part_cnt, &fh);
+			if (!StillDB_encode_file_header (&fh, header))
+				return -1;
 			
-		if (st->search_subset < 0)
-			sprintf (filename, "%02d_bits_pseudo.txt", bit_ix);
-		else
-			sprintf (filename, "%02d_bits_pseudo_subset_%04d_of_%04d.txt", bit_ix, st->search_subset, SELECTED_SEARCH_SUBSETS);
+			AsyncWriter_write (&os->writer, stream_ix, header, STILLDB_FILE_HEADER_SIZE);
+		}
+	}
+	
+	// Each file, or each category of the single file, has its own sequence of delta coded records
+	if (stream_ix >= 0 && os->write_binary_files)
+		StillDB_init_codec (&os->codec [stream_ix], (os->write_delta_coded_files ? STILLDB_ENCODING_DELTA : STILLDB_ENCODING_PLAIN));
+	
+	return stream_ix;
+}
+
+// The stream of framed records is flushed by the writer thread whenever it has nothing else to do, so that a reader at the other end of a pipe gets the
+// still lifes soon after they are found. If the reader is slow the writer blocks on the pipe, and once the output buffers are full the search waits too
+static __not_inline int start_record_stream (OutputState *os)
+{
+	u8 header [STILLDB_FILE_HEADER_SIZE];
+	StillDB_FileHeader fh;
+	make_file_header (os, 0, STILLDB_KIND_STREAM, 0, &fh);
+	fh.encoding = STILLDB_ENCODING_PLAIN;
+	
+	if (!StillDB_encode_file_header (&fh, header))
+		return FALSE;
+	
+	os->record_stream_ix = AsyncWriter_add_low_latency_stream (&os->writer, os->record_stream);
+	if (os->record_stream_ix < 0)
+		return FALSE;
+	
+	os->record_stream = NULL;
+	AsyncWriter_write (&os->writer, os->record_stream_ix, header, STILLDB_FILE_HEADER_SIZE);
+	return TRUE;
+}
+
+// The files are written by a separate writer thread, so that the search never waits for the disk unless the writer falls far behind. All files share
+// os->output_memory_limit bytes of buffers, where each file starts with a small buffer that only grows if the file gets a lot of output
+static __not_inline int open_files (OutputState *os)
+{
+	s32 bit_ix;
+	for (bit_ix = os->min_wanted_bit_cnt; bit_ix <= os->max_wanted_bit_cnt; bit_ix++)
+	{
+		os->strict_stream [bit_ix] = -1;
+		os->pseudo_stream [bit_ix] = -1;
 		
-		st->pseudo_file [bit_ix] = fopen (filename, "w");
-		if (!st->pseudo_file [bit_ix])
+		s32 degree;
+		for (degree = 0; degree <= MAX_PARTITIONS; degree++)
+			os->degree_stream [bit_ix] [degree] = -1;
+	}
+	
+	s32 bit_cnt_cnt = 1 + os->max_wanted_bit_cnt - os->min_wanted_bit_cnt;
+	s32 max_stream_cnt = 1 + bit_cnt_cnt * (MAX_PARTITIONS + 3);
+	
+	os->record_stream_ix = -1;
+	os->codec = NULL;
+	if (!AsyncWriter_create (&os->writer, max_stream_cnt, OUTPUT_MIN_CHUNK_SIZE, OUTPUT_MAX_CHUNK_SIZE, os->output_memory_limit))
+		return FALSE;
+	
+	os->codec = (os->write_binary_files ? malloc (max_stream_cnt * sizeof (StillDB_Codec)) : NULL);
+	if (os->write_binary_files && !os->codec)
+		return FALSE;
+	
+	memset (&os->container, 0, sizeof (StillDBContainer));
+	if (os->write_single_file && !open_container (os))
+		return FALSE;
+	
+	if (os->record_stream && !start_record_stream (os))
+		return FALSE;
+	
+	if (!os->write_files)
+		return TRUE;
+	
+	for (bit_ix = os->min_wanted_bit_cnt; bit_ix <= os->max_wanted_bit_cnt; bit_ix++)
+	{
+		os->strict_stream [bit_ix] = open_output_stream (os, bit_ix, FALSE, 0);
+		if (os->strict_stream [bit_ix] < 0)
 			return FALSE;
-		if (setvbuf (st->pseudo_file [bit_ix], NULL, _IOFBF, FILE_BUFFER_SIZE))
+		
+		os->pseudo_stream [bit_ix] = open_output_stream (os, bit_ix, TRUE, 0);
+		if (os->pseudo_stream [bit_ix] < 0)
 			return FALSE;
 	}
 	
 	return TRUE;
 }
 
-static __not_inline void write_result (SearchState *st, int is_pseudo)
+// Adds the symmetry class, the bounding box and the number of islands of the still life to the end of a line of text, after the RLE or apgcode. Returns the
+// new size of the line
+static __not_inline s32 add_metadata_columns (const SearchSolution *sol, char *buf, s32 size)
 {
-	Rect bb;
-	GoLGrid_get_bounding_box (st->on_cells, &bb);
-	GoLGrid_print_life_history_full ((is_pseudo ? st->pseudo_file [st->on_cnt] : st->strict_file [st->on_cnt]), &bb, st->on_cells, NULL, NULL, NULL, FALSE, 1024);
+	const GoLGrid *gg = sol->on_cells;
+	return (size - 1) + sprintf (buf + (size - 1), " %s %dx%d %d\n", symmetry_class_name [get_symmetry_class (sol->symmetries)], gg->pop_x_off - gg->pop_x_on,
+			gg->pop_y_off - gg->pop_y_on, sol->island_cnt);
 }
 
-static __not_inline void close_files (SearchState *st)
+static __not_inline void write_pattern (OutputState *os, s32 stream_ix, const SearchSolution *sol, int is_pseudo)
 {
-	s32 bit_ix;
-	for (bit_ix = st->min_wanted_bit_cnt; bit_ix <= st->max_wanted_bit_cnt; bit_ix++)
+	s32 size;
+	
+	if (os->write_binary_files)
+	{
+		u8 buf [STILLDB_MAX_CODED_RECORD_SIZE];
+		StillDB_Record rec;
+		StillDB_record_from_grid (sol->on_cells, sol->on_cnt, (is_pseudo ? STILLDB_KIND_PSEUDO : STILLDB_KIND_STRICT), &rec);
+		
+		size = StillDB_encode_next (&os->codec [stream_ix], &rec, buf);
+		if (size > 0)
+			AsyncWriter_write (&os->writer, stream_ix, buf, size);
+	}
+	else
+	{
+		char buf [LIFE_HISTORY_BUFFER_SIZE + METADATA_COLUMNS_SIZE];
+		if (os->write_apgcodes)
+			size = GoLGrid_print_still_life_apgcode_to_buffer_64_wide (sol->on_cells, buf, LIFE_HISTORY_BUFFER_SIZE);
+		else
+		{
+			Rect bb;
+			GoLGrid_get_bounding_box (sol->on_cells, &bb);
+			size = GoLGrid_print_life_history_to_buffer_64_wide (sol->on_cells, &bb, FALSE, 1024, buf, LIFE_HISTORY_BUFFER_SIZE);
+		}
+		
+		if (size > 0 && os->keep_census)
+			size = add_metadata_columns (sol, buf, size);
+		
+		if (size > 0)
+			AsyncWriter_write (&os->writer, stream_ix, buf, size);
+	}
+	
+	// A still life of at most MAX_BIT_CNT cells always fits, so this would be a bug
+	if (size <= 0)
 	{
-		if (st->strict_file [bit_ix])
-			fclose (st->strict_file [bit_ix]);
-		if (st->pseudo_file [bit_ix])
-			fclose (st->pseudo_file [bit_ix]);
+		fprintf (stderr, "Failed to encode a %d bit still life for output\n", sol->on_cnt);
+		exit (EXIT_FAILURE);
 	}
 }
 
-static __not_inline void add_open_cells (SearchState *st)
+static __not_inline void write_result (OutputState *os, const SearchSolution *sol)
 {
-	s32 y;
-	s32 x;
-	for (y = 0; y < GRID_HEIGHT; y++)
-		for (x = 0; x < GRID_WIDTH; x++)
-			if (y >= GRID_BORDER && y < GRID_HEIGHT - GRID_BORDER && x >= GRID_BORDER && x < GRID_WIDTH - GRID_BORDER && (x > SEED_ON_CELL_X || y <= SEED_ON_CELL_Y))
-			{
-				GoLGrid_set_cell_on (st->undef_cells, x, y);
-				st->undef_shadow [x] [y] = 1;
-			}
+	write_pattern (os, (sol->is_pseudo ? os->pseudo_stream [sol->on_cnt] : os->strict_stream [sol->on_cnt]), sol, sol->is_pseudo);
 }
 
-static __not_inline s32 try_subset_division (s64 *op_cnt_at_new_tag, s64 max_ops_in_subset, s32 *first_tag_in_subset)
+// Pseudo still lifes that need more than two stable parts are rare, so their files are only created when the first one is found
+static __not_inline void write_degree_result (OutputState *os, const SearchSolution *sol)
 {
-	s32 subset_ix = 0;
-	first_tag_in_subset [subset_ix] = 0;
-	
-	s32 tag_ix;
-	for (tag_ix = 0; tag_ix <= TAG_CNT_AT_TAG_SIZE_9; tag_ix++)
+	s32 *degree_stream = &os->degree_stream [sol->on_cnt] [sol->part_cnt];
+	if (*degree_stream < 0)
 	{
-		s64 next_subset_op_cnt = op_cnt_at_new_tag [tag_ix] - op_cnt_at_new_tag [first_tag_in_subset [subset_ix]];
-		if (next_subset_op_cnt > max_ops_in_subset)
+		*degree_stream = open_output_stream (os, sol->on_cnt, TRUE, sol->part_cnt);
+		if (*degree_stream < 0)
 		{
-			subset_ix++;
-			first_tag_in_subset [subset_ix] = tag_ix - 1;
+			fprintf (stderr, "Failed to open output file for %d bit pseudo still lifes in %d parts\n", sol->on_cnt, sol->part_cnt);
+			exit (EXIT_FAILURE);
 		}
 	}
 	
-	subset_ix++;
-	first_tag_in_subset [subset_ix] = TAG_CNT_AT_TAG_SIZE_9;
-	
-	return subset_ix;
+	write_pattern (os, *degree_stream, sol, TRUE);
 }
 
-static __not_inline void print_search_subset_division_table (s64 *op_cnt_at_new_tag)
+static __not_inline void write_stream_record (OutputState *os, const SearchSolution *sol)
 {
-	s32 first_tag_in_subset [4 * WANTED_SEARCH_SUBSETS];
-	s64 max_ops_in_subset = MAX_OPS_IN_SUBSET_LOW_ESTIMATE;
+	u8 buf [STILLDB_MAX_FRAME_SIZE];
+	StillDB_Record rec;
+	StillDB_record_from_grid (sol->on_cells, sol->on_cnt, (sol->is_pseudo ? STILLDB_KIND_PSEUDO : STILLDB_KIND_STRICT), &rec);
 	
-	s32 subset_cnt;
-	while (TRUE)
+	s32 size = StillDB_encode_frame (&rec, sol->part_cnt, buf);
+	if (size <= 0)
 	{
-		subset_cnt = try_subset_division (op_cnt_at_new_tag, max_ops_in_subset, first_tag_in_subset);
-		if (subset_cnt <= WANTED_SEARCH_SUBSETS)
-			break;
-		
-		max_ops_in_subset += (MAX_OPS_IN_SUBSET_LOW_ESTIMATE / 10000);
+		fprintf (stderr, "Failed to encode a %d bit still life for output\n", sol->on_cnt);
+		exit (EXIT_FAILURE);
 	}
 	
-	printf ("\n");
-	s32 subset_ix;
-	for (subset_ix = 0; subset_ix <= 100; subset_ix++)
-		printf ("%d, ", first_tag_in_subset [subset_ix]);
-	
-	printf ("\n\n");
-	printf ("subsets = %d, max ops in subset = %" PRIu64 ", total ops = %" PRIu64 ", ops in last subset = %" PRIu64 "\n", subset_cnt, max_ops_in_subset, op_cnt_at_new_tag [first_tag_in_subset [subset_cnt]],
-			op_cnt_at_new_tag [first_tag_in_subset [subset_cnt]] - op_cnt_at_new_tag [first_tag_in_subset [subset_cnt - 1]]);
+	AsyncWriter_write (&os->writer, os->record_stream_ix, buf, size);
 }
 
-static __not_inline int do_search (s32 min_wanted_bit_cnt, s32 max_wanted_bit_cnt, s32 search_subset, int write_files, int report_complex_pseudo_still_lifes, int build_subset_division_table, GridVisualization *grid_visualization)
+// Adds the size and checksum of one output to the manifest, named by its file, or by the single file and the category
+static __not_inline int add_manifest_output (OutputState *os, s32 stream_ix, s32 bit_cnt, int is_pseudo, s32 part_cnt)
 {
-	// This is used to prepare tables for dividing the search space into equal subsets when this mode is selected
-	s64 op_cnt_at_new_tag [TAG_CNT_AT_TAG_SIZE_9 + 1];
-	
-	SearchState st;
-	
-	make_stability_tables (&st);
-	
-	st.write_files = write_files;
-	
-	st.min_wanted_bit_cnt = min_wanted_bit_cnt;
-	st.max_wanted_bit_cnt = max_wanted_bit_cnt;
+	char kind [32];
+	char name [128];
+	u64 size;
+	u32 checksum;
 	
-	st.search_subset = search_subset;
+	if (stream_ix < 0)
+		return TRUE;
 	
-	if (st.search_subset < 0)
+	make_kind_name (is_pseudo, part_cnt, kind);
+	if (os->write_single_file)
 	{
-		st.wanted_tag_on = 0;
-		st.wanted_tag_off = -1;
+		make_run_filename (os, "sldb", name);
+		sprintf (name + strlen (name), ":%02d_bits_%s", bit_cnt, kind);
 	}
 	else
+		make_filename (os, bit_cnt, kind, name);
+	
+	return (AsyncWriter_get_checksum (&os->writer, stream_ix, &size, &checksum) && RunManifest_add_output (os->manifest, name, size, checksum));
+}
+
+// Must be called after the writer thread has written everything
+static __not_inline int add_manifest_outputs (OutputState *os)
+{
+	int success = TRUE;
+	
+	s32 bit_ix;
+	for (bit_ix = os->min_wanted_bit_cnt; bit_ix <= os->max_wanted_bit_cnt; bit_ix++)
 	{
-		st.wanted_tag_on = tag_size_9_in_subsets [st.search_subset];
-		st.wanted_tag_off = tag_size_9_in_subsets [st.search_subset + 1];
+		success &= add_manifest_output (os, os->strict_stream [bit_ix], bit_ix, FALSE, 0);
+		success &= add_manifest_output (os, os->pseudo_stream [bit_ix], bit_ix, TRUE, 0);
+		
+		s32 degree;
+		for (degree = 0; degree <= MAX_PARTITIONS; degree++)
+			success &= add_manifest_output (os, os->degree_stream [bit_ix] [degree], bit_ix, TRUE, degree);
 	}
 	
-	st.undef_cells = alloc_grid ();
-	st.on_cells = alloc_grid ();
-	st.on_cnt = 0;
+	if (os->record_stream_ix >= 0)
+	{
+		u64 size;
+		u32 checksum;
+		success &= (AsyncWriter_get_checksum (&os->writer, os->record_stream_ix, &size, &checksum) && RunManifest_add_output (os->manifest, os->record_stream_name, size,
+				checksum));
+	}
 	
-	st.taken_define_cnt = 0;
+	return success;
+}
+
+// Waits for the writer thread to write all remaining output and closes the files. The index of the single file needs the final counts, so this must be called
+// after all leaves are classified. res is NULL if the search didn't start or failed, and then neither the index of the single file nor the frame that ends the
+// record stream is written, so the output can't be taken for that of a complete search
+static __not_inline int close_files (OutputState *os, const SearchResult *res)
+{
+	free (os->codec);
+	os->codec = NULL;
 	
-	st.new_on_cells_defined = TRUE;
-	st.new_tag_cells_defined = TRUE;
-	st.cur_tag_ix = -1;
-	st.op_cnt = 0;
+	if (os->record_stream)
+	{
+		fclose (os->record_stream);
+		os->record_stream = NULL;
+	}
 	
-	st.not_stable_cnt = 0;
-	st.not_canonical_cnt = 0;
-	st.not_connected_cnt = 0;
+	if (!os->writer.stream)
+		return TRUE;
 	
-	s32 on_cnt;
-	for (on_cnt = 0; on_cnt <= MAX_BIT_CNT; on_cnt++)
+	// A reader of the record stream can tell a complete search from one that was interrupted by the frame that ends the stream
+	if (res && os->record_stream_ix >= 0)
 	{
-		st.strict_sol_cnt [on_cnt] = 0;
- 		st.pseudo_sol_cnt [on_cnt] = 0;
+		u8 end_frame [2] = {0, 0};
+		AsyncWriter_write (&os->writer, os->record_stream_ix, end_frame, sizeof (end_frame));
 	}
 	
-	st.gv = grid_visualization;
+	int success = AsyncWriter_finish (&os->writer);
+	if (!add_manifest_outputs (os))
+		success = FALSE;
+	
+	if (!AsyncWriter_close (&os->writer))
+		success = FALSE;
 	
-	if (st.write_files)
-		if (!open_files (&st))
+	if (os->write_single_file && os->container.file && !res)
+		StillDBContainer_close (&os->container);
+	else if (os->write_single_file && os->container.file)
+	{
+		s32 category_ix;
+		for (category_ix = 0; category_ix < os->container.category_cnt; category_ix++)
 		{
-			close_files (&st);
-			fprintf (stderr, "Failed to open output files\n");
-			return FALSE;
+			const StillDBContainer_Category *cat = &os->container.category [category_ix];
+			
+			s64 record_cnt;
+			if (cat->kind == STILLDB_KIND_STRICT)
+				record_cnt = res->strict_sol_cnt [cat->on_cnt];
+			else if (cat->part_cnt == 0)
+				record_cnt = res->pseudo_sol_cnt [cat->on_cnt];
+			else
+				record_cnt = res->pseudo_degree_cnt [cat->on_cnt] [cat->part_cnt];
+			
+			StillDBContainer_set_record_cnt (&os->container, category_ix, record_cnt);
 		}
+		
+		if (!StillDBContainer_finish (&os->container))
+			success = FALSE;
+	}
 	
-	add_open_cells (&st);
-	try_define_cell (&st, SEED_ON_CELL_X, SEED_ON_CELL_Y, 1);
+	return success;
+}
+
+// The solution callback of the command line search, which writes each still life to the files and streams that are open
+static int write_solution (void *context, const SearchSolution *sol)
+{
+	OutputState *os = (OutputState *) context;
 	
-	fprintf (stderr, "\nCells open to define and the (%d, %d) cell that should always be on:\n\n", SEED_ON_CELL_X, SEED_ON_CELL_Y);
-	GoLGrid_print_life_history_full (stderr, NULL, st.on_cells, st.undef_cells, NULL, NULL, TRUE, 68);
-	fprintf (stderr, "\n");
+	int report_complex = (sol->part_cnt > 2 && os->report_complex_pseudo_still_lifes && !os->write_degree_files);
+	if (!os->write_files && os->record_stream_ix < 0 && !report_complex)
+		return TRUE;
 	
-	s32 vis_cnt = 0;
-	s32 upd_cnt = 0;
-	while (TRUE)
+	if (os->lock_output)
+		pthread_mutex_lock (&os->output_mutex);
+	
+	if (report_complex)
 	{
-		if (vis_cnt == 0)
-		{
-			vis_cnt = 500000;
-			visualize_cur (&st);
-			GridVisualization_update (st.gv);
+		printf ("Pseudo still life not partitionable in two parts:\n");
+		GoLGrid_print (sol->on_cells);
+	}
+	
+	if (os->write_files)
+	{
+		write_result (os, sol);
+		if (os->write_degree_files && sol->part_cnt > 2)
+			write_degree_result (os, sol);
+	}
+	
+	if (os->record_stream_ix >= 0)
+		write_stream_record (os, sol);
+	
+	if (os->lock_output)
+		pthread_mutex_unlock (&os->output_mutex);
+	
+	return TRUE;
+}
+
+// The progress callback of the command line search. The first call comes before the search has defined anything but the seed cell
+static int print_progress (void *context, const SearchProgress *progress)
+{
+	const OutputState *os = (const OutputState *) context;
+	
+	if (progress->op_cnt == 0)
+	{
+		fprintf (stderr, "\nCells open to define and the (%d, %d) cell that should always be on:\n\n", SEED_ON_CELL_X, SEED_ON_CELL_Y);
+		GoLGrid_print_life_history_full (stderr, NULL, progress->on_cells, progress->undef_cells, NULL, NULL, TRUE, 68);
+		fprintf (stderr, "\n");
+	}
+	
+	fprintf (stderr, "%" PRIu64 " strict and %" PRIu64 " pseudo %d bit still lifes so far\n", progress->strict_cnt, progress->pseudo_cnt, os->max_wanted_bit_cnt);
+	return TRUE;
+}
+
+static __not_inline int init_classifier (Classifier *cl, GoLGrid *on_cells, int use_ring, int keep_census)
+{
+	memset (cl, 0, sizeof (Classifier));
+	
+	cl->on_cells = (on_cells ? on_cells : alloc_grid ());
+	if (!cl->on_cells)
+		return FALSE;
+	
+	if (keep_census)
+	{
+		cl->census = calloc (1, sizeof (Census));
+		if (!cl->census)
+			return FALSE;
+	}
+	
+	cl->island_set_cache = calloc (1, sizeof (IslandSetCache));
+	if (!cl->island_set_cache)
+		return FALSE;
+	
+	if (use_ring)
+	{
+		cl->ring.leaf = malloc (LEAF_RING_SIZE * sizeof (LeafRecord));
+		if (!cl->ring.leaf)
+			return FALSE;
+		
+		pthread_mutex_init (&cl->ring.mutex, NULL);
+		pthread_cond_init (&cl->ring.wake, NULL);
+	}
+	
+	return TRUE;
+}
+
+// owns_grid is set for the classifiers of classifier threads, which have their own grid
+static __not_inline void free_classifier (Classifier *cl, int owns_grid)
+{
+	if (owns_grid && cl->on_cells)
+		GoLUtils_free_std_grid (&cl->on_cells);
+	
+	free (cl->census);
+	free (cl->island_set_cache);
+	
+	if (cl->ring.leaf)
+	{
+		pthread_cond_destroy (&cl->ring.wake);
+		pthread_mutex_destroy (&cl->ring.mutex);
+		free (cl->ring.leaf);
+	}
+}
+
+// Everything counted here is already known from classifying the still life, so keeping the census costs no extra work on the grid
+static __not_inline void add_to_census (Classifier *cl, int is_pseudo)
+{
+	const GoLGrid *gg = cl->on_cells;
+	Census *cs = cl->census;
+	
+	cs->symmetry_cnt [cl->on_cnt] [is_pseudo] [get_symmetry_class (cl->symmetries)]++;
+	cs->island_cnt [cl->on_cnt] [is_pseudo] [cl->island_graph.island_cnt]++;
+	cs->bounding_box_cnt [cl->on_cnt] [gg->pop_x_off - gg->pop_x_on] [gg->pop_y_off - gg->pop_y_on]++;
+}
+
+static __not_inline void classify_leaf (SearchState *st, Classifier *cl)
+{
+	if (!verify_possible_solution (cl))
+		return;
+	
+	s32 pseudo_degree = get_pseudo_still_degree (cl);
+	int is_pseudo = (pseudo_degree != NO_STABLE_PARTITIONING);
+	
+	// The solution counts are also read by the search thread to report progress
+	if (is_pseudo)
+	{
+		__atomic_fetch_add (&cl->pseudo_sol_cnt [cl->on_cnt], 1, __ATOMIC_RELAXED);
+		cl->pseudo_degree_cnt [cl->on_cnt] [pseudo_degree]++;
+	}
+	else
+		__atomic_fetch_add (&cl->strict_sol_cnt [cl->on_cnt], 1, __ATOMIC_RELAXED);
+	
+	if (cl->census)
+		add_to_census (cl, is_pseudo);
+	
+	SearchSolutionCallback callback = st->cfg->solution_callback;
+	if (!callback || __atomic_load_n (&st->cancelled, __ATOMIC_RELAXED))
+		return;
+	
+	SearchSolution sol;
+	sol.on_cells = cl->on_cells;
+	sol.on_cnt = cl->on_cnt;
+	sol.is_pseudo = is_pseudo;
+	sol.part_cnt = (is_pseudo ? pseudo_degree : 0);
+	sol.symmetries = cl->symmetries;
+	sol.island_cnt = cl->island_graph.island_cnt;
+	sol.classifier_ix = (s32) (cl - st->classifier);
+	
+	if (!callback (st->cfg->solution_context, &sol))
+		__atomic_store_n (&st->cancelled, TRUE, __ATOMIC_RELAXED);
+}
+
+// Hands the current leaf of the search over to the classifier threads in turn. If all rings are full the search waits for the classifiers to catch up, first
+// by spinning and then by sleeping until the next ring is half empty. A classifier that sleeps on an empty ring is woken when a quarter of it is filled, so
+// neither side is woken for every leaf
+static __not_inline void push_leaf (SearchState *st)
+{
+	const GoLGrid *gg = st->on_cells;
+	s32 full_ring_cnt = 0;
+	s32 spin_cnt = 0;
+	
+	while (TRUE)
+	{
+		LeafRing *ring = &st->classifier [st->next_classifier_ix].ring;
+		if (++st->next_classifier_ix >= st->classifier_thread_cnt)
+			st->next_classifier_ix = 0;
+		
+		if (ring->head - __atomic_load_n (&ring->tail, __ATOMIC_ACQUIRE) < LEAF_RING_SIZE)
+		{
+			LeafRecord *leaf = &ring->leaf [ring->head & (LEAF_RING_SIZE - 1)];
+			leaf->on_cnt = st->on_cnt;
+			leaf->pop_x_on = gg->pop_x_on;
+			leaf->pop_x_off = gg->pop_x_off;
+			leaf->pop_y_on = gg->pop_y_on;
+			leaf->pop_y_off = gg->pop_y_off;
+			memcpy (leaf->row + gg->pop_y_on, gg->grid + gg->pop_y_on, (gg->pop_y_off - gg->pop_y_on) * sizeof (u64));
+			
+			// The classifier sets its flag before it looks at head for the last time, so with sequentially consistent operations on both sides either
+			// it sees the new leaf or the search sees the flag
+			__atomic_store_n (&ring->head, ring->head + 1, __ATOMIC_SEQ_CST);
+			if (__atomic_load_n (&ring->classifier_waiting, __ATOMIC_SEQ_CST) && ring->head - __atomic_load_n (&ring->tail, __ATOMIC_RELAXED) >= LEAF_RING_SIZE / 4)
+			{
+				pthread_mutex_lock (&ring->mutex);
+				pthread_cond_signal (&ring->wake);
+				pthread_mutex_unlock (&ring->mutex);
+			}
+			
+			return;
+		}
+		
+		if (++full_ring_cnt < st->classifier_thread_cnt)
+			continue;
+		
+		full_ring_cnt = 0;
+		if (++spin_cnt < LEAF_RING_SPIN_CNT)
+			continue;
+		
+		spin_cnt = 0;
+		ring = &st->classifier [st->next_classifier_ix].ring;
+		
+		pthread_mutex_lock (&ring->mutex);
+		__atomic_store_n (&ring->search_waiting, TRUE, __ATOMIC_SEQ_CST);
+		while (ring->head - __atomic_load_n (&ring->tail, __ATOMIC_SEQ_CST) > LEAF_RING_SIZE / 2)
+			pthread_cond_wait (&ring->wake, &ring->mutex);
+		
+		__atomic_store_n (&ring->search_waiting, FALSE, __ATOMIC_RELAXED);
+		pthread_mutex_unlock (&ring->mutex);
+	}
+}
+
+static __force_inline void load_leaf (Classifier *cl, const LeafRecord *leaf)
+{
+	GoLGrid *gg = cl->on_cells;
+	GoLGrid_clear_64_wide (gg);
+	
+	memcpy (gg->grid + leaf->pop_y_on, leaf->row + leaf->pop_y_on, (leaf->pop_y_off - leaf->pop_y_on) * sizeof (u64));
+	gg->pop_x_on = leaf->pop_x_on;
+	gg->pop_x_off = leaf->pop_x_off;
+	gg->pop_y_on = leaf->pop_y_on;
+	gg->pop_y_off = leaf->pop_y_off;
+	
+	cl->on_cnt = leaf->on_cnt;
+}
+
+static __not_inline void *run_classifier_thread (void *arg)
+{
+	ClassifierThread *ct = (ClassifierThread *) arg;
+	LeafRing *ring = &ct->cl->ring;
+	s32 spin_cnt = 0;
+	
+	while (TRUE)
+	{
+		if (__atomic_load_n (&ring->head, __ATOMIC_ACQUIRE) == ring->tail)
+		{
+			// The search sets search_done after its last leaf, so the ring has to be checked once more after seeing it
+			if (__atomic_load_n (&ring->search_done, __ATOMIC_ACQUIRE) && __atomic_load_n (&ring->head, __ATOMIC_ACQUIRE) == ring->tail)
+				return NULL;
+			
+			if (++spin_cnt < LEAF_RING_SPIN_CNT)
+				continue;
+			
+			spin_cnt = 0;
+			
+			pthread_mutex_lock (&ring->mutex);
+			__atomic_store_n (&ring->classifier_waiting, TRUE, __ATOMIC_SEQ_CST);
+			while (__atomic_load_n (&ring->head, __ATOMIC_SEQ_CST) - ring->tail < LEAF_RING_SIZE / 4 && !__atomic_load_n (&ring->search_done, __ATOMIC_SEQ_CST))
+				pthread_cond_wait (&ring->wake, &ring->mutex);
+			
+			__atomic_store_n (&ring->classifier_waiting, FALSE, __ATOMIC_RELAXED);
+			pthread_mutex_unlock (&ring->mutex);
+			continue;
+		}
+		
+		load_leaf (ct->cl, &ring->leaf [ring->tail & (LEAF_RING_SIZE - 1)]);
+		
+		// The same as for head in push_leaf, the search only sleeps after setting its flag and looking at tail
+		__atomic_store_n (&ring->tail, ring->tail + 1, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n (&ring->search_waiting, __ATOMIC_SEQ_CST) && __atomic_load_n (&ring->head, __ATOMIC_RELAXED) - ring->tail <= LEAF_RING_SIZE / 2)
+		{
+			pthread_mutex_lock (&ring->mutex);
+			pthread_cond_signal (&ring->wake);
+			pthread_mutex_unlock (&ring->mutex);
+		}
+		
+		classify_leaf (ct->st, ct->cl);
+	}
+}
+
+static __not_inline s64 get_sol_cnt_so_far (const SearchState *st, s32 on_cnt, int is_pseudo)
+{
+	s32 classifier_cnt = (st->classifier_thread_cnt > 0 ? st->classifier_thread_cnt : 1);
+	s64 sol_cnt = 0;
+	
+	s32 classifier_ix;
+	for (classifier_ix = 0; classifier_ix < classifier_cnt; classifier_ix++)
+	{
+		const Classifier *cl = &st->classifier [classifier_ix];
+		sol_cnt += __atomic_load_n ((is_pseudo ? &cl->pseudo_sol_cnt [on_cnt] : &cl->strict_sol_cnt [on_cnt]), __ATOMIC_RELAXED);
+	}
+	
+	return sol_cnt;
+}
+
+static __not_inline int report_progress (const SearchState *st)
+{
+	SearchProgress progress;
+	progress.op_cnt = st->op_cnt;
+	progress.cur_tag_ix = st->cur_tag_ix;
+	progress.strict_cnt = get_sol_cnt_so_far (st, st->max_wanted_bit_cnt, FALSE);
+	progress.pseudo_cnt = get_sol_cnt_so_far (st, st->max_wanted_bit_cnt, TRUE);
+	progress.on_cells = st->on_cells;
+	progress.undef_cells = st->undef_cells;
+	
+	return st->cfg->progress_callback (st->cfg->progress_context, &progress);
+}
+
+static __not_inline void add_classifier_counts (SearchResult *res, const Classifier *cl)
+{
+	res->not_stable_cnt += cl->not_stable_cnt;
+	res->not_canonical_cnt += cl->not_canonical_cnt;
+	res->not_connected_cnt += cl->not_connected_cnt;
+	res->island_set_cache_lookup_cnt += cl->island_set_cache->lookup_cnt;
+	res->island_set_cache_hit_cnt += cl->island_set_cache->hit_cnt;
+	
+	s32 on_cnt;
+	for (on_cnt = 0; on_cnt <= MAX_BIT_CNT; on_cnt++)
+	{
+		res->strict_sol_cnt [on_cnt] += cl->strict_sol_cnt [on_cnt];
+		res->pseudo_sol_cnt [on_cnt] += cl->pseudo_sol_cnt [on_cnt];
+		
+		s32 degree;
+		for (degree = 0; degree <= MAX_PARTITIONS; degree++)
+			res->pseudo_degree_cnt [on_cnt] [degree] += cl->pseudo_degree_cnt [on_cnt] [degree];
+	}
+	
+	if (!res->census || !cl->census)
+		return;
+	
+	s64 *sum = (s64 *) res->census;
+	const s64 *term = (const s64 *) cl->census;
+	
+	u64 cnt_ix;
+	for (cnt_ix = 0; cnt_ix < sizeof (Census) / sizeof (s64); cnt_ix++)
+		sum [cnt_ix] += term [cnt_ix];
+}
+
+static __not_inline void print_census_histogram (const char *title, const s64 *cnt, s32 cnt_cnt, const char *const *name)
+{
+	printf ("%s:", title);
+	
+	s32 printed_cnt = 0;
+	s32 cnt_ix;
+	for (cnt_ix = 0; cnt_ix < cnt_cnt; cnt_ix++)
+		if (cnt [cnt_ix] > 0)
+		{
+			if (name)
+				printf ("%s %s %" PRIu64, (printed_cnt > 0 ? "," : ""), name [cnt_ix], cnt [cnt_ix]);
+			else
+				printf ("%s %d %" PRIu64, (printed_cnt > 0 ? "," : ""), cnt_ix, cnt [cnt_ix]);
+			
+			printed_cnt++;
+		}
+	
+	printf ("\n");
+}
+
+static __not_inline void print_census (const Census *cs, s32 on_cnt)
+{
+	print_census_histogram ("  Strict by symmetry", cs->symmetry_cnt [on_cnt] [0], SYMMETRY_CLASS_CNT, symmetry_class_name);
+	print_census_histogram ("  Pseudo by symmetry", cs->symmetry_cnt [on_cnt] [1], SYMMETRY_CLASS_CNT, symmetry_class_name);
+	print_census_histogram ("  Strict by islands", cs->island_cnt [on_cnt] [0], MAX_PARTITIONS + 1, NULL);
+	print_census_histogram ("  Pseudo by islands", cs->island_cnt [on_cnt] [1], MAX_PARTITIONS + 1, NULL);
+	
+	printf ("  By bounding box:");
+	
+	s32 box_cnt = 0;
+	s32 width;
+	s32 height;
+	for (width = 0; width <= GRID_WIDTH; width++)
+		for (height = 0; height <= width; height++)
+			if (cs->bounding_box_cnt [on_cnt] [width] [height] > 0)
+			{
+				if (box_cnt > 0)
+					printf ((box_cnt % 8) == 0 ? ",\n                  " : ",");
+				
+				printf (" %dx%d %" PRIu64, width, height, cs->bounding_box_cnt [on_cnt] [width] [height]);
+				box_cnt++;
+			}
+	
+	printf ("\n");
+}
+
+static __not_inline void add_open_cells (SearchState *st)
+{
+	memset (st->shadow, 0, sizeof (st->shadow));
+	
+	s32 y;
+	s32 x;
+	for (y = 0; y < GRID_HEIGHT; y++)
+		for (x = 0; x < GRID_WIDTH; x++)
+			if (y >= GRID_BORDER && y < GRID_HEIGHT - GRID_BORDER && x >= GRID_BORDER && x < GRID_WIDTH - GRID_BORDER && (x > SEED_ON_CELL_X || y <= SEED_ON_CELL_Y))
+			{
+				GoLGrid_set_cell_on (st->undef_cells, x, y);
+				st->shadow [(y * GRID_WIDTH) + x] = SHADOW_UNDEF;
+			}
+}
+
+static __not_inline s32 try_subset_division (s64 *op_cnt_at_new_tag, s64 max_ops_in_subset, s32 *first_tag_in_subset)
+{
+	s32 subset_ix = 0;
+	first_tag_in_subset [subset_ix] = 0;
+	
+	s32 tag_ix;
+	for (tag_ix = 0; tag_ix <= TAG_CNT_AT_TAG_SIZE_9; tag_ix++)
+	{
+		s64 next_subset_op_cnt = op_cnt_at_new_tag [tag_ix] - op_cnt_at_new_tag [first_tag_in_subset [subset_ix]];
+		if (next_subset_op_cnt > max_ops_in_subset)
+		{
+			subset_ix++;
+			first_tag_in_subset [subset_ix] = tag_ix - 1;
+		}
+	}
+	
+	subset_ix++;
+	first_tag_in_subset [subset_ix] = TAG_CNT_AT_TAG_SIZE_9;
+	
+	return subset_ix;
+}
+
+static __not_inline void print_search_subset_division_table (s64 *op_cnt_at_new_tag)
+{
+	s32 first_tag_in_subset [4 * WANTED_SEARCH_SUBSETS];
+	s64 max_ops_in_subset = MAX_OPS_IN_SUBSET_LOW_ESTIMATE;
+	
+	s32 subset_cnt;
+	while (TRUE)
+	{
+		subset_cnt = try_subset_division (op_cnt_at_new_tag, max_ops_in_subset, first_tag_in_subset);
+		if (subset_cnt <= WANTED_SEARCH_SUBSETS)
+			break;
+		
+		max_ops_in_subset += (MAX_OPS_IN_SUBSET_LOW_ESTIMATE / 10000);
+	}
+	
+	printf ("\n");
+	s32 subset_ix;
+	for (subset_ix = 0; subset_ix <= 100; subset_ix++)
+		printf ("%d, ", first_tag_in_subset [subset_ix]);
+	
+	printf ("\n\n");
+	printf ("subsets = %d, max ops in subset = %" PRIu64 ", total ops = %" PRIu64 ", ops in last subset = %" PRIu64 "\n", subset_cnt, max_ops_in_subset, op_cnt_at_new_tag [first_tag_in_subset [subset_cnt]],
+			op_cnt_at_new_tag [first_tag_in_subset [subset_cnt]] - op_cnt_at_new_tag [first_tag_in_subset [subset_cnt - 1]]);
+}
+
+// The manifest is written next to the output files at the end of every search, so that the results of the subsets of a search can be checked and added up
+// with "pp manifest" without reading the output of the search or the database files
+static __not_inline int write_manifest (OutputState *os, const SearchConfig *cfg, const SearchResult *res)
+{
+	RunManifest *rm = os->manifest;
+	
+	rm->min_on_cnt = os->min_wanted_bit_cnt;
+	rm->max_on_cnt = os->max_wanted_bit_cnt;
+	rm->subset = os->search_subset;
+	rm->subset_cnt = (os->search_subset < 0 ? 0 : SELECTED_SEARCH_SUBSETS);
+	rm->first_tag = cfg->first_tag;
+	rm->end_tag = cfg->end_tag;
+	
+	// The options that change what is written, in the order of the usage text. The counts are the same with any options
+	rm->options [0] = '\0';
+	if (os->write_degree_files)
+		strcat (rm->options, " -d");
+	if (os->write_binary_files && !os->write_single_file && !os->write_delta_coded_files)
+		strcat (rm->options, " -b");
+	if (os->write_single_file)
+		strcat (rm->options, " -s");
+	if (os->write_delta_coded_files)
+		strcat (rm->options, " -z");
+	if (os->write_apgcodes)
+		strcat (rm->options, " -a");
+	if (os->keep_census && os->write_files)
+		strcat (rm->options, " -i");
+	if (os->record_stream_ix >= 0)
+		strcat (rm->options, " -o");
+	
+	if (rm->options [0] == '\0')
+		strcpy (rm->options, "-");
+	else
+		memmove (rm->options, rm->options + 1, strlen (rm->options));
+	
+	rm->op_cnt = res->op_cnt;
+	rm->not_stable_cnt = res->not_stable_cnt;
+	rm->not_canonical_cnt = res->not_canonical_cnt;
+	rm->not_connected_cnt = res->not_connected_cnt;
+	
+	s32 on_cnt;
+	for (on_cnt = os->min_wanted_bit_cnt; on_cnt <= os->max_wanted_bit_cnt; on_cnt++)
+	{
+		rm->strict_cnt [on_cnt] = res->strict_sol_cnt [on_cnt];
+		rm->pseudo_cnt [on_cnt] = res->pseudo_sol_cnt [on_cnt];
+		
+		s32 degree;
+		for (degree = 3; degree <= MAX_PARTITIONS; degree++)
+			rm->pseudo_part_cnt [on_cnt] [degree] = res->pseudo_degree_cnt [on_cnt] [degree];
+	}
+	
+	char filename [64];
+	make_run_filename (os, "manifest", filename);
+	
+	FILE *f = fopen (filename, "w");
+	if (!f)
+	{
+		fprintf (stderr, "Failed to open manifest file %s\n", filename);
+		return FALSE;
+	}
+	
+	int success = RunManifest_write (rm, f);
+	if (fclose (f) != 0)
+		success = FALSE;
+	
+	if (!success)
+		fprintf (stderr, "Write error on manifest file %s\n", filename);
+	
+	return success;
+}
+
+static __not_inline void free_search_state (SearchState *st)
+{
+	if (st->classifier)
+	{
+		s32 classifier_cnt = (st->classifier_thread_cnt > 0 ? st->classifier_thread_cnt : 1);
+		
+		s32 classifier_ix;
+		for (classifier_ix = 0; classifier_ix < classifier_cnt; classifier_ix++)
+			free_classifier (&st->classifier [classifier_ix], (st->classifier_thread_cnt > 0));
+		
+		free (st->classifier);
+		st->classifier = NULL;
+	}
+	
+	if (st->undef_cells)
+		GoLUtils_free_std_grid (&st->undef_cells);
+	if (st->on_cells)
+		GoLUtils_free_std_grid (&st->on_cells);
+}
+
+// Lets the first thread_cnt classifier threads finish the leaves in their rings and waits for them
+static __not_inline void stop_classifier_threads (SearchState *st, ClassifierThread *classifier_thread, s32 thread_cnt)
+{
+	s32 classifier_ix;
+	for (classifier_ix = 0; classifier_ix < thread_cnt; classifier_ix++)
+	{
+		LeafRing *ring = &st->classifier [classifier_ix].ring;
+		__atomic_store_n (&ring->search_done, TRUE, __ATOMIC_SEQ_CST);
+		
+		pthread_mutex_lock (&ring->mutex);
+		pthread_cond_signal (&ring->wake);
+		pthread_mutex_unlock (&ring->mutex);
+	}
+	
+	for (classifier_ix = 0; classifier_ix < thread_cnt; classifier_ix++)
+		pthread_join (classifier_thread [classifier_ix].thread, NULL);
+}
+
+// Frees what run_search allocated for the result
+static __not_inline void free_search_result (SearchResult *res)
+{
+	free (res->census);
+	res->census = NULL;
+}
+
+// Searches the part of the search space selected by cfg and counts the still lifes found in res, handing each one to the solution callback. Nothing is
+// written to files here, so this can be used by other programs that include this file with STILLCOUNT_NO_MAIN defined. Everything allocated for the search
+// is freed before returning, except the census in res. Returns FALSE if out of memory or a classifier thread could not be started, and otherwise TRUE, also if a callback stopped the search
+static __not_inline int run_search (const SearchConfig *cfg, SearchResult *res)
+{
+	memset (res, 0, sizeof (SearchResult));
+	
+	SearchState st;
+	make_stability_tables (&st);
+	
+	st.min_wanted_bit_cnt = cfg->min_bit_cnt;
+	st.max_wanted_bit_cnt = cfg->max_bit_cnt;
+	st.wanted_tag_on = cfg->first_tag;
+	st.wanted_tag_off = cfg->end_tag;
+	
+	st.cfg = cfg;
+	st.cancelled = FALSE;
+	
+	st.undef_cells = alloc_grid ();
+	st.on_cells = alloc_grid ();
+	st.on_cnt = 0;
+	
+	st.taken_define_cnt = 0;
+	
+	st.new_on_cells_defined = TRUE;
+	st.new_tag_cells_defined = TRUE;
+	st.cur_tag_ix = -1;
+	st.op_cnt = 0;
+	
+	st.gv = cfg->grid_visualization;
+	
+	st.classifier_thread_cnt = cfg->classifier_thread_cnt;
+	st.next_classifier_ix = 0;
+	
+	s32 classifier_cnt = (st.classifier_thread_cnt > 0 ? st.classifier_thread_cnt : 1);
+	st.classifier = calloc (classifier_cnt, sizeof (Classifier));
+	ClassifierThread *classifier_thread = malloc (classifier_cnt * sizeof (ClassifierThread));
+	res->census = (cfg->keep_census ? calloc (1, sizeof (Census)) : NULL);
+	
+	int success = (st.undef_cells && st.on_cells && st.classifier && classifier_thread && (!cfg->keep_census || res->census));
+	
+	s32 classifier_ix;
+	for (classifier_ix = 0; success && classifier_ix < classifier_cnt; classifier_ix++)
+		success = init_classifier (&st.classifier [classifier_ix], (st.classifier_thread_cnt > 0 ? NULL : st.on_cells), (st.classifier_thread_cnt > 0),
+				cfg->keep_census);
+	
+	if (!success)
+	{
+		fprintf (stderr, "Out of memory allocating classifiers\n");
+		
+		free_search_state (&st);
+		free (classifier_thread);
+		free_search_result (res);
+		return FALSE;
+	}
+	
+	s32 started_cnt;
+	for (started_cnt = 0; started_cnt < st.classifier_thread_cnt; started_cnt++)
+	{
+		classifier_thread [started_cnt].st = &st;
+		classifier_thread [started_cnt].cl = &st.classifier [started_cnt];
+		
+		if (pthread_create (&classifier_thread [started_cnt].thread, NULL, run_classifier_thread, &classifier_thread [started_cnt]) != 0)
+			break;
+	}
+	
+	if (started_cnt < st.classifier_thread_cnt)
+	{
+		fprintf (stderr, "Failed to start classifier thread\n");
+		
+		stop_classifier_threads (&st, classifier_thread, started_cnt);
+		free_search_state (&st);
+		free (classifier_thread);
+		free_search_result (res);
+		return FALSE;
+	}
+	
+	add_open_cells (&st);
+	try_define_cell (&st, (SEED_ON_CELL_Y * GRID_WIDTH) + SEED_ON_CELL_X, 1);
+	
+	s32 vis_cnt = 0;
+	s64 upd_cnt = 0;
+	while (TRUE)
+	{
+		// A callback that asks to stop the search is noticed within CANCEL_CHECK_INTERVAL search operations, a few milliseconds
+		if ((st.op_cnt & (CANCEL_CHECK_INTERVAL - 1)) == 0 && __atomic_load_n (&st.cancelled, __ATOMIC_RELAXED))
+			break;
+		
+		if (vis_cnt == 0)
+		{
+			vis_cnt = 500000;
+			if (st.gv)
+			{
+				visualize_cur (&st);
+				GridVisualization_update (st.gv);
+			}
+		}
+		
+		if (upd_cnt == 0)
+		{
+			upd_cnt = cfg->progress_interval;
+			if (cfg->progress_callback && !report_progress (&st))
+			{
+				__atomic_store_n (&st.cancelled, TRUE, __ATOMIC_RELAXED);
+				break;
+			}
+		}
+		
+		vis_cnt--;
+		upd_cnt--;
+		
+		st.op_cnt++;
+		
+		if (st.new_on_cells_defined)
+		{
+			if (st.on_cnt >= st.min_wanted_bit_cnt && st.on_cnt <= st.max_wanted_bit_cnt)
+			{
+				if (st.classifier_thread_cnt > 0)
+					push_leaf (&st);
+				else
+				{
+					st.classifier [0].on_cnt = st.on_cnt;
+					classify_leaf (&st, &st.classifier [0]);
+				}
+			}
+			
+			if (st.new_tag_cells_defined && st.on_cnt >= TAG_SIZE)
+			{
+				st.cur_tag_ix++;
+				if (cfg->op_cnt_at_new_tag)
+					cfg->op_cnt_at_new_tag [st.cur_tag_ix] = st.op_cnt;
+				
+				st.new_tag_cells_defined = FALSE;
+			}
+			
+			st.new_on_cells_defined = FALSE;
+		}
+		
+		if (st.wanted_tag_off != -1 && st.cur_tag_ix >= st.wanted_tag_off)
+			break;
+		
+		if (st.on_cnt < TAG_SIZE || st.cur_tag_ix >= st.wanted_tag_on)
+			if (st.on_cnt < st.max_wanted_bit_cnt)
+			{
+				s32 cell_to_define_x;
+				s32 cell_to_define_y;
+				
+				int found = find_cell_to_define (&st, &cell_to_define_x, &cell_to_define_y);
+				if (found)
+				{
+					s32 cell_to_define_ix = (cell_to_define_y * GRID_WIDTH) + cell_to_define_x;
+					
+					if (try_define_cell (&st, cell_to_define_ix, 1))
+						continue;
+					
+					if (try_define_cell (&st, cell_to_define_ix, 0))
+						continue;
+				}
+			}
+		
+		while (TRUE)
+		{
+			TakenDefine undone_td = undo_taken_define (&st);
+			
+			if (st.taken_define_cnt == 0)
+				break;
+			
+			if (!taken_define_is_forced (undone_td) && taken_define_state (undone_td) == 1)
+				if (try_define_cell (&st, taken_define_cell_ix (undone_td), 0))
+					break;
+		}
+		
+		if (st.taken_define_cnt == 0)
+			break;
+	}
+	
+	stop_classifier_threads (&st, classifier_thread, st.classifier_thread_cnt);
+	
+	res->cancelled = st.cancelled;
+	res->op_cnt = st.op_cnt;
+	for (classifier_ix = 0; classifier_ix < classifier_cnt; classifier_ix++)
+		add_classifier_counts (res, &st.classifier [classifier_ix]);
+	
+	free_search_state (&st);
+	free (classifier_thread);
+	return TRUE;
+}
+
+static __not_inline void free_manifest (OutputState *os)
+{
+	RunManifest_free (os->manifest);
+	free (os->manifest);
+	os->manifest = NULL;
+}
+
+// Makes sure that the output files and the manifest of a search are on disk, before the search is marked as done in a campaign ledger. The outputs are
+// taken from the manifest, which must still be in memory
+static __not_inline int sync_output_files (const OutputState *os)
+{
+	const RunManifest *rm = os->manifest;
+	char filename [RUNMANIFEST_MAX_NAME_SIZE];
+	char prev_filename [RUNMANIFEST_MAX_NAME_SIZE];
+	prev_filename [0] = '\0';
+	
+	s32 output_ix;
+	for (output_ix = 0; output_ix < rm->output_cnt; output_ix++)
+	{
+		// The categories of the single file written with -s are named <file>:<category>
+		strcpy (filename, rm->output [output_ix].name);
+		char *colon = strchr (filename, ':');
+		if (colon)
+			*colon = '\0';
+		
+		if ((os->record_stream_name && strcmp (filename, os->record_stream_name) == 0) || strcmp (filename, prev_filename) == 0)
+			continue;
+		
+		if (!CampaignLedger_sync_file (filename))
+		{
+			fprintf (stderr, "Failed to sync output file %s to disk\n", filename);
+			return FALSE;
 		}
 		
-		if (upd_cnt == 0)
+		strcpy (prev_filename, filename);
+	}
+	
+	make_run_filename (os, "manifest", filename);
+	if (!CampaignLedger_sync_file (filename) || !CampaignLedger_sync_dir ("."))
+	{
+		fprintf (stderr, "Failed to sync manifest file %s to disk\n", filename);
+		return FALSE;
+	}
+	
+	return TRUE;
+}
+
+static __not_inline int do_search (s32 min_wanted_bit_cnt, s32 max_wanted_bit_cnt, s32 search_subset, int write_files, int write_degree_files, int write_binary_files, int write_single_file, int write_delta_coded_files, int write_apgcodes, int keep_census, int report_complex_pseudo_still_lifes, s32 classifier_thread_cnt,
+		int build_subset_division_table,
+		s64 output_memory_limit, FILE *record_stream, const char *record_stream_name, int sync_files, GridVisualization *grid_visualization)
+{
+	// This is used to prepare tables for dividing the search space into equal subsets when this mode is selected
+	s64 op_cnt_at_new_tag [TAG_CNT_AT_TAG_SIZE_9 + 1];
+	
+	OutputState os;
+	SearchConfig cfg;
+	SearchResult res;
+	double start_time = get_wall_time ();
+	
+	os.min_wanted_bit_cnt = min_wanted_bit_cnt;
+	os.max_wanted_bit_cnt = max_wanted_bit_cnt;
+	os.search_subset = search_subset;
+	
+	os.write_files = write_files;
+	os.write_degree_files = write_degree_files;
+	os.write_binary_files = write_binary_files;
+	os.write_single_file = write_single_file;
+	os.write_delta_coded_files = write_delta_coded_files;
+	os.write_apgcodes = write_apgcodes;
+	os.keep_census = keep_census;
+	os.report_complex_pseudo_still_lifes = report_complex_pseudo_still_lifes;
+	os.output_memory_limit = output_memory_limit;
+	os.record_stream = record_stream;
+	os.record_stream_name = record_stream_name;
+	os.record_stream_ix = -1;
+	os.lock_output = (classifier_thread_cnt > 1);
+	
+	os.manifest = malloc (sizeof (RunManifest));
+	if (!os.manifest)
+	{
+		fprintf (stderr, "Out of memory allocating manifest\n");
+		return FALSE;
+	}
+	
+	RunManifest_init (os.manifest);
+	
+	cfg.min_bit_cnt = min_wanted_bit_cnt;
+	cfg.max_bit_cnt = max_wanted_bit_cnt;
+	
+	if (search_subset < 0)
+	{
+		cfg.first_tag = 0;
+		cfg.end_tag = -1;
+	}
+	else
+	{
+		cfg.first_tag = tag_size_9_in_subsets [search_subset];
+		cfg.end_tag = tag_size_9_in_subsets [search_subset + 1];
+	}
+	
+	cfg.classifier_thread_cnt = classifier_thread_cnt;
+	cfg.keep_census = keep_census;
+	
+	// When nothing is written or reported the still lifes are only counted
+	cfg.solution_callback = ((write_files || record_stream || report_complex_pseudo_still_lifes) ? write_solution : NULL);
+	cfg.solution_context = &os;
+	cfg.progress_callback = print_progress;
+	cfg.progress_context = &os;
+	cfg.progress_interval = 50000000;
+	
+	cfg.grid_visualization = grid_visualization;
+	cfg.op_cnt_at_new_tag = (build_subset_division_table ? op_cnt_at_new_tag : NULL);
+	
+	memset (&res, 0, sizeof (SearchResult));
+	
+	if (os.write_files || os.record_stream)
+		if (!open_files (&os))
+		{
+			close_files (&os, NULL);
+			fprintf (stderr, "Failed to open output files\n");
+			free_manifest (&os);
+			return FALSE;
+		}
+	
+	pthread_mutex_init (&os.output_mutex, NULL);
+	
+	// No manifest is written for a failed search, but the writer thread must still be stopped and the files closed
+	if (!run_search (&cfg, &res))
+	{
+		if (os.write_files || os.record_stream)
+			close_files (&os, NULL);
+		
+		free_manifest (&os);
+		pthread_mutex_destroy (&os.output_mutex);
+		return FALSE;
+	}
+	
+	if ((os.write_files || os.record_stream_ix >= 0) && !close_files (&os, &res))
+	{
+		fprintf (stderr, "Write error on output files\n");
+		free_manifest (&os);
+		free_search_result (&res);
+		pthread_mutex_destroy (&os.output_mutex);
+		return FALSE;
+	}
+	
+	if (build_subset_division_table)
+	{
+		op_cnt_at_new_tag [TAG_CNT_AT_TAG_SIZE_9] = res.op_cnt;
+		print_search_subset_division_table (op_cnt_at_new_tag);
+	}
+	
+	printf ("Not stable = %" PRIu64 ", not canonical = %" PRIu64 ", not connected = %" PRIu64 "\n", res.not_stable_cnt, res.not_canonical_cnt, res.not_connected_cnt);
+	printf ("Island set cache: %" PRIu64 " lookups, %" PRIu64 " hits (%.1f%%)\n", res.island_set_cache_lookup_cnt, res.island_set_cache_hit_cnt,
+			(res.island_set_cache_lookup_cnt > 0 ? (100.0 * res.island_set_cache_hit_cnt) / res.island_set_cache_lookup_cnt : 0.0));
+	
+	double search_time = get_wall_time () - start_time;
+	printf ("Search operations = %" PRIu64 " in %.1f s (%.0f ops/s)\n", res.op_cnt, search_time, (search_time > 0.0 ? res.op_cnt / search_time : 0.0));
+	
+	s32 on_cnt;
+	for (on_cnt = min_wanted_bit_cnt; on_cnt <= max_wanted_bit_cnt; on_cnt++)
+	{
+		printf ("\nNumber of on-cells: %10d\n", on_cnt);
+		if (search_subset < 0)
+			printf ("Result for full search space:\n");
+		else
+			printf ("Result for subset %d in (0..%d) of search space:\n", search_subset, SELECTED_SEARCH_SUBSETS - 1);
+		
+		printf ("Strict still lifes: %10" PRIu64 "\n", res.strict_sol_cnt [on_cnt]);
+		printf ("Pseudo still lifes: %10" PRIu64 "\n", res.pseudo_sol_cnt [on_cnt]);
+		
+		s32 degree;
+		for (degree = 2; degree <= MAX_PARTITIONS; degree++)
+			if (res.pseudo_degree_cnt [on_cnt] [degree] > 0)
+				printf ("  in %2d stable parts: %10" PRIu64 "\n", degree, res.pseudo_degree_cnt [on_cnt] [degree]);
+		
+		if (res.census)
+			print_census (res.census, on_cnt);
+	}
+	
+	int success = write_manifest (&os, &cfg, &res);
+	if (success && sync_files)
+		success = sync_output_files (&os);
+	
+	free_manifest (&os);
+	free_search_result (&res);
+	pthread_mutex_destroy (&os.output_mutex);
+	
+	return success;
+}
+
+// A part of a database handed to the verification threads, either whole lines of a text file or records of a binary file. The bit count and kind of the
+// still lifes in a text chunk come from the filename and are -1 if it doesn't tell, while each record holds its own. The number of parts is only set for
+// pseudo still lifes that need a specific number of parts. The still lifes in the files written with -d are also in the other files, so they are counted
+// separately
+typedef struct
+{
+	int state;
+	int is_text;
+	int is_degree_file;
+	const char *filename;
+	s64 first_item_number;
+	
+	s32 on_cnt;
+	s32 kind;
+	s32 part_cnt;
+	char *text;
+	s64 text_size;
+	
+	StillDB_Record *record;
+	s32 *record_part_cnt;
+	s32 record_cnt;
+} VerifyChunk;
+
+// The chunks are filled by the reading thread and taken by the verification threads in the same order
+typedef struct
+{
+	pthread_mutex_t mutex;
+	pthread_cond_t chunk_filled;
+	pthread_cond_t chunk_freed;
+	
+	VerifyChunk *chunk;
+	s32 chunk_cnt;
+	s32 next_fill_ix;
+	s32 next_take_ix;
+	int reading_done;
+	
+	char *carry;
+	s64 reported_cnt;
+} VerifyState;
+
+typedef struct
+{
+	VerifyState *vs;
+	Classifier cl;
+	GoLGrid *parsed;
+	GoLGrid *evolved;
+	
+	s64 pattern_cnt;
+	s64 unreadable_cnt;
+	s64 wrong_category_cnt;
+	pthread_t thread;
+} VerifyThread;
+
+// Places a still life, given as rows with the leftmost column in the most significant bit, in the grid of the classifier exactly where the search would have
+// found it, with the lowest on-cell of the leftmost column on the cell that is always on. Returns FALSE if the rows don't hold a still life of at most
+// MAX_BIT_CNT cells that fits in the grid
+static __not_inline int place_still_life (Classifier *cl, const u64 *row, s32 width, s32 height)
+{
+	GoLGrid *gg = cl->on_cells;
+	GoLGrid_clear_64_wide (gg);
+	
+	if (width <= 0 || width > GRID_WIDTH - (2 * GRID_BORDER) || height <= 0 || height > GRID_HEIGHT - (2 * GRID_BORDER) || row [0] == 0 || row [height - 1] == 0)
+		return FALSE;
+	
+	u64 or_of_rows = 0;
+	s32 on_cnt = 0;
+	s32 seed_row_ix = -1;
+	
+	s32 row_ix;
+	for (row_ix = 0; row_ix < height; row_ix++)
+	{
+		or_of_rows |= row [row_ix];
+		on_cnt += bit_count_u64 (row [row_ix]);
+		if (row [row_ix] & (((u64) 1) << 63))
+			seed_row_ix = row_ix;
+	}
+	
+	s32 top_y = SEED_ON_CELL_Y - seed_row_ix;
+	if (seed_row_ix < 0 || least_significant_bit_u64 (or_of_rows) != 64 - width || on_cnt > MAX_BIT_CNT || top_y < GRID_BORDER || top_y + height > GRID_HEIGHT - GRID_BORDER)
+		return FALSE;
+	
+	for (row_ix = 0; row_ix < height; row_ix++)
+		gg->grid [top_y + row_ix] = row [row_ix] >> SEED_ON_CELL_X;
+	
+	gg->pop_x_on = SEED_ON_CELL_X;
+	gg->pop_x_off = SEED_ON_CELL_X + width;
+	gg->pop_y_on = top_y;
+	gg->pop_y_off = top_y + height;
+	
+	cl->on_cnt = on_cnt;
+	return TRUE;
+}
+
+// Reruns the checks of the search on the still life in the grid of the classifier, and also checks that it is what the database says it is. on_cnt and kind
+// are -1 if the database doesn't say, and part_cnt is 0 if it doesn't say. apgcode is the code the still life was read from, which is checked instead of the orientation if not NULL. Returns NULL
+// if the still life is valid, otherwise what is wrong with it
+static __not_inline const char *verify_still_life (VerifyThread *vt, s32 on_cnt, s32 kind, s32 part_cnt, int is_degree_file, const char *apgcode, s32 apgcode_size)
+{
+	Classifier *cl = &vt->cl;
+	
+	GoLGrid_evolve_64_wide (cl->on_cells, vt->evolved);
+	if (!GoLGrid_is_equal_64_wide (cl->on_cells, vt->evolved))
+	{
+		cl->not_stable_cnt++;
+		return "not stable";
+	}
+	
+	if (apgcode)
+	{
+		char buf [LIFE_HISTORY_BUFFER_SIZE];
+		s32 size = GoLGrid_print_still_life_apgcode_to_buffer_64_wide (cl->on_cells, buf, LIFE_HISTORY_BUFFER_SIZE);
+		if (size != apgcode_size + 1 || memcmp (buf, apgcode, apgcode_size) != 0)
+		{
+			cl->not_canonical_cnt++;
+			return "not the canonical apgcode";
+		}
+	}
+	else if (!is_canonical (cl->on_cells, &cl->symmetries))
+	{
+		cl->not_canonical_cnt++;
+		return "not in canonical orientation";
+	}
+	
+	if (!is_connected (cl->on_cells))
+	{
+		cl->not_connected_cnt++;
+		return "not connected";
+	}
+	
+	if (on_cnt >= 0 && cl->on_cnt != on_cnt)
+	{
+		vt->wrong_category_cnt++;
+		return "wrong number of on-cells";
+	}
+	
+	s32 pseudo_degree = get_pseudo_still_degree (cl);
+	int is_pseudo = (pseudo_degree != NO_STABLE_PARTITIONING);
+	
+	if (kind >= 0 && is_pseudo != (kind == STILLDB_KIND_PSEUDO))
+	{
+		vt->wrong_category_cnt++;
+		return (is_pseudo ? "a pseudo still life among strict still lifes" : "a strict still life among pseudo still lifes");
+	}
+	
+	if (part_cnt > 0 && pseudo_degree != part_cnt)
+	{
+		vt->wrong_category_cnt++;
+		return "wrong number of stable parts";
+	}
+	
+	if (is_degree_file)
+		cl->pseudo_degree_cnt [cl->on_cnt] [pseudo_degree]++;
+	else if (is_pseudo)
+		cl->pseudo_sol_cnt [cl->on_cnt]++;
+	else
+		cl->strict_sol_cnt [cl->on_cnt]++;
+	
+	return NULL;
+}
+
+// Only the first few invalid still lifes are listed, as a broken database file could have millions of them. text is the line the still life was read from,
+// or NULL to print the still life in the grid of the classifier
+static __not_inline void report_invalid_still_life (VerifyThread *vt, const VerifyChunk *ch, s64 item_number, const char *reason, const char *text)
+{
+	VerifyState *vs = vt->vs;
+	
+	char buf [LIFE_HISTORY_BUFFER_SIZE];
+	s32 size = 0;
+	if (!text && vt->cl.on_cells->pop_x_off > vt->cl.on_cells->pop_x_on)
+	{
+		Rect bb;
+		GoLGrid_get_bounding_box (vt->cl.on_cells, &bb);
+		size = GoLGrid_print_life_history_to_buffer_64_wide (vt->cl.on_cells, &bb, FALSE, 1024, buf, LIFE_HISTORY_BUFFER_SIZE);
+	}
+	
+	pthread_mutex_lock (&vs->mutex);
+	
+	if (vs->reported_cnt++ < VERIFY_MAX_REPORTED_STILL_LIFES)
+		printf ("%s, %s %" PRIi64 ": %s: %.*s\n", ch->filename, (ch->is_text ? "line" : "record"), item_number, reason, (text ? (int) strlen (text) : (size > 0 ? size - 1 : 0)),
+				(text ? text : buf));
+	
+	pthread_mutex_unlock (&vs->mutex);
+}
+
+// The line is either LifeHistory RLE or an apgcode, and may be followed by the columns added with -i
+static __not_inline void verify_text_line (VerifyThread *vt, const VerifyChunk *ch, s64 line_number, const char *line)
+{
+	s32 apgcode_size = 0;
+	if (line [0] == 'x' && line [1] == 's')
+		apgcode_size = strcspn (line, " \t");
+	
+	StillDB_Record rec;
+	const char *reason = NULL;
+	
+	vt->pattern_cnt++;
+	
+	if (!StillDBReader_decode_line (line, line + strlen (line), 0, STILLDB_KIND_STRICT, vt->parsed, &rec))
+		reason = "not a pattern of at most 64 by 64 cells";
+	else if (!place_still_life (&vt->cl, rec.row, rec.width, rec.height))
+		reason = "not a pattern the search could find";
+	
+	if (reason)
+		vt->unreadable_cnt++;
+	else
+		reason = verify_still_life (vt, ch->on_cnt, ch->kind, ch->part_cnt, ch->is_degree_file, (apgcode_size > 0 ? line : NULL), apgcode_size);
+	
+	if (reason)
+		report_invalid_still_life (vt, ch, line_number, reason, line);
+}
+
+static __not_inline void verify_chunk (VerifyThread *vt, VerifyChunk *ch)
+{
+	if (ch->is_text)
+	{
+		char *line = ch->text;
+		char *text_end = ch->text + ch->text_size;
+		s64 line_number = ch->first_item_number;
+		
+		// The reading thread makes sure that the chunk ends with a newline
+		while (line < text_end)
+		{
+			char *line_end = memchr (line, '\n', text_end - line);
+			*line_end = '\0';
+			if (line_end > line && line_end [-1] == '\r')
+				line_end [-1] = '\0';
+			
+			if (line [0] != '\0')
+				verify_text_line (vt, ch, line_number, line);
+			
+			line = line_end + 1;
+			line_number++;
+		}
+		
+		return;
+	}
+	
+	s32 record_ix;
+	for (record_ix = 0; record_ix < ch->record_cnt; record_ix++)
+	{
+		const StillDB_Record *rec = &ch->record [record_ix];
+		const char *reason;
+		
+		vt->pattern_cnt++;
+		if (place_still_life (&vt->cl, rec->row, rec->width, rec->height))
+			reason = verify_still_life (vt, rec->on_cnt, rec->kind, ch->record_part_cnt [record_ix], ch->is_degree_file, NULL, 0);
+		else
+		{
+			vt->unreadable_cnt++;
+			reason = "not a pattern the search could find";
+		}
+		
+		if (reason)
+			report_invalid_still_life (vt, ch, ch->first_item_number + record_ix, reason, NULL);
+	}
+}
+
+static __not_inline void *run_verify_thread (void *arg)
+{
+	VerifyThread *vt = (VerifyThread *) arg;
+	VerifyState *vs = vt->vs;
+	
+	pthread_mutex_lock (&vs->mutex);
+	
+	while (TRUE)
+	{
+		VerifyChunk *ch = &vs->chunk [vs->next_take_ix];
+		if (ch->state == VERIFY_CHUNK_FILLED)
+		{
+			ch->state = VERIFY_CHUNK_TAKEN;
+			vs->next_take_ix = (vs->next_take_ix + 1) % vs->chunk_cnt;
+			pthread_mutex_unlock (&vs->mutex);
+			
+			verify_chunk (vt, ch);
+			
+			pthread_mutex_lock (&vs->mutex);
+			ch->state = VERIFY_CHUNK_FREE;
+			pthread_cond_signal (&vs->chunk_freed);
+		}
+		else if (vs->reading_done)
+			break;
+		else
+			pthread_cond_wait (&vs->chunk_filled, &vs->mutex);
+	}
+	
+	pthread_mutex_unlock (&vs->mutex);
+	return NULL;
+}
+
+// Waits until the next chunk in turn is free and makes it empty
+static __not_inline VerifyChunk *get_free_verify_chunk (VerifyState *vs, const char *filename, s64 first_item_number)
+{
+	pthread_mutex_lock (&vs->mutex);
+	
+	VerifyChunk *ch = &vs->chunk [vs->next_fill_ix];
+	while (ch->state != VERIFY_CHUNK_FREE)
+		pthread_cond_wait (&vs->chunk_freed, &vs->mutex);
+	
+	pthread_mutex_unlock (&vs->mutex);
+	
+	ch->filename = filename;
+	ch->first_item_number = first_item_number;
+	ch->text_size = 0;
+	ch->record_cnt = 0;
+	return ch;
+}
+
+// An empty chunk is left free, so that it is handed out again by the next call to get_free_verify_chunk
+static __not_inline void queue_verify_chunk (VerifyState *vs, VerifyChunk *ch)
+{
+	if (ch->text_size == 0 && ch->record_cnt == 0)
+		return;
+	
+	pthread_mutex_lock (&vs->mutex);
+	ch->state = VERIFY_CHUNK_FILLED;
+	vs->next_fill_ix = (vs->next_fill_ix + 1) % vs->chunk_cnt;
+	pthread_cond_signal (&vs->chunk_filled);
+	pthread_mutex_unlock (&vs->mutex);
+}
+
+// Hands a text database file to the verification threads in chunks of whole lines
+static __not_inline int read_text_for_verification (VerifyState *vs, const char *filename, FILE *f)
+{
+	s32 on_cnt;
+	s32 kind;
+	s32 part_cnt;
+	StillDB_get_category_from_filename (filename, &on_cnt, &kind, &part_cnt);
+	
+	s64 carry_size = 0;
+	s64 line_number = 1;
+	
+	while (TRUE)
+	{
+		VerifyChunk *ch = get_free_verify_chunk (vs, filename, line_number);
+		ch->is_text = TRUE;
+		ch->is_degree_file = (part_cnt > 0);
+		ch->on_cnt = on_cnt;
+		ch->kind = kind;
+		ch->part_cnt = part_cnt;
+		
+		memcpy (ch->text, vs->carry, carry_size);
+		s64 size = carry_size + fread (ch->text + carry_size, 1, VERIFY_CHUNK_TEXT_SIZE - carry_size, f);
+		if (ferror (f))
+		{
+			fprintf (stderr, "Read error on %s\n", filename);
+			return FALSE;
+		}
+		
+		int at_end = (size < VERIFY_CHUNK_TEXT_SIZE);
+		
+		// A last line without a newline gets one, and otherwise the text after the last newline is kept for the next chunk. There is room for the added newline
+		// as the chunk buffers are one byte larger than VERIFY_CHUNK_TEXT_SIZE
+		s64 text_size = size;
+		if (at_end && size > 0 && ch->text [size - 1] != '\n')
+			ch->text [text_size++] = '\n';
+		else if (!at_end)
+		{
+			while (text_size > 0 && ch->text [text_size - 1] != '\n')
+				text_size--;
+			
+			if (text_size == 0)
+			{
+				fprintf (stderr, "Line %" PRIi64 " of %s is longer than %d bytes\n", line_number, filename, VERIFY_CHUNK_TEXT_SIZE);
+				return FALSE;
+			}
+		}
+		
+		carry_size = (text_size < size ? size - text_size : 0);
+		memcpy (vs->carry, ch->text + text_size, carry_size);
+		
+		s64 byte_ix;
+		for (byte_ix = 0; byte_ix < text_size; byte_ix++)
+			line_number += (ch->text [byte_ix] == '\n');
+		
+		ch->text_size = text_size;
+		queue_verify_chunk (vs, ch);
+		
+		if (at_end)
+			return TRUE;
+	}
+}
+
+// Hands the records of a binary database file to the verification threads. For a single file with all still lifes of a search the records of one category
+// are read with rd, and record_cnt counts the records over all categories
+static __not_inline int read_records_for_verification (VerifyState *vs, const char *filename, FILE *f, const StillDB_FileHeader *fh, StillDBContainer_Reader *rd,
+		s64 *record_cnt)
+{
+	StillDB_Codec codec;
+	StillDB_init_codec (&codec, fh->encoding);
+	
+	int result = 1;
+	while (result == 1)
+	{
+		VerifyChunk *ch = get_free_verify_chunk (vs, filename, *record_cnt + 1);
+		ch->is_text = FALSE;
+		ch->is_degree_file = (fh->kind != STILLDB_KIND_STREAM && (rd ? rd->ct->category [rd->category_ix].part_cnt : fh->part_cnt) > 0);
+		
+		while (ch->record_cnt < VERIFY_CHUNK_RECORD_CNT)
+		{
+			StillDB_Record *rec = &ch->record [ch->record_cnt];
+			s32 *part_cnt = &ch->record_part_cnt [ch->record_cnt];
+			
+			if (fh->kind == STILLDB_KIND_STREAM)
+				result = StillDB_read_frame (f, rec, part_cnt);
+			else if (rd)
+			{
+				result = StillDBContainer_read_record (rd, rec);
+				*part_cnt = rd->ct->category [rd->category_ix].part_cnt;
+			}
+			else
+			{
+				result = StillDB_read_record (f, &codec, rec);
+				*part_cnt = fh->part_cnt;
+			}
+			
+			if (result != 1)
+				break;
+			
+			ch->record_cnt++;
+		}
+		
+		*record_cnt += ch->record_cnt;
+		queue_verify_chunk (vs, ch);
+	}
+	
+	if (result < 0)
+		fprintf (stderr, "%s ends in the middle of a record or has an invalid record after %" PRIi64 " records\n", filename, *record_cnt);
+	
+	return (result == 0);
+}
+
+// Text files are told apart from binary files by the file header
+static __not_inline int read_database_for_verification (VerifyState *vs, const char *filename)
+{
+	FILE *f = fopen (filename, "rb");
+	if (!f)
+	{
+		fprintf (stderr, "Failed to open database file %s\n", filename);
+		return FALSE;
+	}
+	
+	StillDB_FileHeader fh;
+	s64 record_cnt = 0;
+	int success;
+	
+	if (!StillDB_read_file_header (f, &fh))
+		success = (fseek (f, 0, SEEK_SET) == 0 && read_text_for_verification (vs, filename, f));
+	else if (fh.kind != STILLDB_KIND_CONTAINER)
+		success = read_records_for_verification (vs, filename, f, &fh, NULL, &record_cnt);
+	else
+	{
+		StillDBContainer ct;
+		if (!StillDBContainer_open (&ct, f))
 		{
-			upd_cnt = 50000000;
-			fprintf (stderr, "%" PRIu64 " strict and %" PRIu64 " pseudo %d bit still lifes so far\n", st.strict_sol_cnt [st.max_wanted_bit_cnt], st.pseudo_sol_cnt [st.max_wanted_bit_cnt], st.max_wanted_bit_cnt);
+			fprintf (stderr, "%s has an invalid index\n", filename);
+			fclose (f);
+			return FALSE;
 		}
 		
-		vis_cnt--;
-		upd_cnt--;
-		
-		st.op_cnt++;
-		
-		if (st.new_on_cells_defined)
+		success = TRUE;
+		s32 category_ix;
+		for (category_ix = 0; success && category_ix < ct.category_cnt; category_ix++)
 		{
-			if (st.on_cnt >= st.min_wanted_bit_cnt && st.on_cnt <= st.max_wanted_bit_cnt)
-				if (verify_possible_solution (&st))
-				{
-					if (is_pseudo_still (&st, TRUE))
-					{
-						if (report_complex_pseudo_still_lifes)
-							if (!is_pseudo_still (&st, FALSE))
-							{
-								printf ("Pseudo still life not partitionable in two parts:\n");
-								GoLGrid_print (st.on_cells);
-							}
-						
-						st.pseudo_sol_cnt [st.on_cnt]++;
-						if (st.write_files)
-							write_result (&st, TRUE);
-					}
-					else
-					{
-						st.strict_sol_cnt [st.on_cnt]++;
-						if (st.write_files)
-							write_result (&st, FALSE);
-					}
-				}
+			const StillDBContainer_Category *cat = &ct.category [category_ix];
+			StillDBContainer_Reader rd;
+			StillDBContainer_open_category (&ct, category_ix, &rd);
 			
-			if (st.new_tag_cells_defined && st.on_cnt >= TAG_SIZE)
+			s64 prev_record_cnt = record_cnt;
+			success = read_records_for_verification (vs, filename, f, &ct.fh, &rd, &record_cnt);
+			
+			if (success && record_cnt - prev_record_cnt != cat->record_cnt)
 			{
-				st.cur_tag_ix++;
-				if (build_subset_division_table)
-					op_cnt_at_new_tag [st.cur_tag_ix] = st.op_cnt;
-				
-				st.new_tag_cells_defined = FALSE;
+				fprintf (stderr, "The index of %s lists %" PRIi64 " records of %d bit %s still lifes, but the file holds %" PRIi64 "\n", filename, cat->record_cnt,
+						cat->on_cnt, (cat->kind == STILLDB_KIND_PSEUDO ? "pseudo" : "strict"), record_cnt - prev_record_cnt);
+				success = FALSE;
 			}
-			
-			st.new_on_cells_defined = FALSE;
 		}
 		
-		if (st.wanted_tag_off != -1 && st.cur_tag_ix >= st.wanted_tag_off)
-			break;
+		// This also closes the file
+		StillDBContainer_close (&ct);
+		return success;
+	}
+	
+	fclose (f);
+	return success;
+}
+
+// The summary is the output of the search that wrote the database files. Returns TRUE if it lists the same number of still lifes of each bit count and kind as
+// were verified
+static __not_inline int compare_with_run_summary (const char *summary_filename, const s64 *strict_cnt, const s64 *pseudo_cnt)
+{
+	FILE *f = fopen (summary_filename, "r");
+	if (!f)
+	{
+		fprintf (stderr, "Failed to open summary file %s\n", summary_filename);
+		return FALSE;
+	}
+	
+	int success = TRUE;
+	s32 compared_cnt = 0;
+	int on_cnt = -1;
+	char line [256];
+	
+	while (fgets (line, sizeof (line), f))
+	{
+		int value;
+		s64 summary_cnt;
+		int is_pseudo;
 		
-		if (st.on_cnt < TAG_SIZE || st.cur_tag_ix >= st.wanted_tag_on)
-			if (st.on_cnt < st.max_wanted_bit_cnt)
-			{
-				s32 cell_to_define_x;
-				s32 cell_to_define_y;
-				
-				int found = find_cell_to_define (&st, &cell_to_define_x, &cell_to_define_y);
-				if (found)
-				{
-					if (try_define_cell (&st, cell_to_define_x, cell_to_define_y, 1))
-						continue;
-					
-					if (try_define_cell (&st, cell_to_define_x, cell_to_define_y, 0))
-						continue;
-				}
-			}
+		if (sscanf (line, "Number of on-cells: %d", &value) == 1)
+		{
+			on_cnt = (value >= 0 && value <= MAX_BIT_CNT ? value : -1);
+			continue;
+		}
 		
-		while (TRUE)
+		if (on_cnt >= 0 && sscanf (line, "Strict still lifes: %" SCNi64, &summary_cnt) == 1)
+			is_pseudo = FALSE;
+		else if (on_cnt >= 0 && sscanf (line, "Pseudo still lifes: %" SCNi64, &summary_cnt) == 1)
+			is_pseudo = TRUE;
+		else
+			continue;
+		
+		s64 verified_cnt = (is_pseudo ? pseudo_cnt [on_cnt] : strict_cnt [on_cnt]);
+		if (verified_cnt != summary_cnt)
 		{
-			const TakenDefine *undone_td = undo_taken_define (&st);
-			
-			if (st.taken_define_cnt == 0)
-				break;
-			
-			if (!(undone_td->is_forced) && undone_td->state == 1)
-				if (try_define_cell (&st, undone_td->x, undone_td->y, 0))
-					break;
+			printf ("%s lists %" PRIi64 " %d bit %s still lifes, but %" PRIi64 " were verified\n", summary_filename, summary_cnt, on_cnt, (is_pseudo ? "pseudo" : "strict"),
+					verified_cnt);
+			success = FALSE;
 		}
 		
-		if (st.taken_define_cnt == 0)
-			break;
+		compared_cnt++;
 	}
 	
-	if (st.write_files)
-		close_files (&st);
+	fclose (f);
 	
-	if (build_subset_division_table)
+	if (compared_cnt == 0)
 	{
-		op_cnt_at_new_tag [TAG_CNT_AT_TAG_SIZE_9] = st.op_cnt;
-		print_search_subset_division_table (op_cnt_at_new_tag);
+		fprintf (stderr, "%s has no still life counts\n", summary_filename);
+		return FALSE;
+	}
+	
+	return success;
+}
+
+// Rechecks every still life in the database files with thread_cnt threads, while the calling thread reads the files
+// Frees what verify_databases allocated, also when it failed part of the way through
+static __not_inline void free_verification (VerifyState *vs, VerifyThread *vt, s32 thread_cnt)
+{
+	s32 chunk_ix;
+	for (chunk_ix = 0; vs->chunk && chunk_ix < vs->chunk_cnt; chunk_ix++)
+	{
+		free (vs->chunk [chunk_ix].text);
+		free (vs->chunk [chunk_ix].record);
+		free (vs->chunk [chunk_ix].record_part_cnt);
+	}
+	
+	s32 thread_ix;
+	for (thread_ix = 0; vt && thread_ix < thread_cnt; thread_ix++)
+	{
+		if (vt [thread_ix].parsed)
+			GoLUtils_free_std_grid (&vt [thread_ix].parsed);
+		if (vt [thread_ix].evolved)
+			GoLUtils_free_std_grid (&vt [thread_ix].evolved);
+		
+		free_classifier (&vt [thread_ix].cl, TRUE);
+	}
+	
+	free (vs->chunk);
+	free (vs->carry);
+	free (vt);
+	
+	pthread_cond_destroy (&vs->chunk_freed);
+	pthread_cond_destroy (&vs->chunk_filled);
+	pthread_mutex_destroy (&vs->mutex);
+}
+
+static __not_inline int verify_databases (const char *const *filename, s32 file_cnt, s32 thread_cnt, const char *summary_filename)
+{
+	VerifyState vs;
+	memset (&vs, 0, sizeof (VerifyState));
+	pthread_mutex_init (&vs.mutex, NULL);
+	pthread_cond_init (&vs.chunk_filled, NULL);
+	pthread_cond_init (&vs.chunk_freed, NULL);
+	
+	vs.chunk_cnt = (VERIFY_CHUNKS_PER_THREAD * thread_cnt) + 1;
+	vs.chunk = calloc (vs.chunk_cnt, sizeof (VerifyChunk));
+	vs.carry = malloc (VERIFY_CHUNK_TEXT_SIZE);
+	VerifyThread *vt = calloc (thread_cnt, sizeof (VerifyThread));
+	int allocated = (vs.chunk && vs.carry && vt);
+	
+	s32 chunk_ix;
+	for (chunk_ix = 0; allocated && chunk_ix < vs.chunk_cnt; chunk_ix++)
+	{
+		VerifyChunk *ch = &vs.chunk [chunk_ix];
+		ch->text = malloc (VERIFY_CHUNK_TEXT_SIZE + 1);
+		ch->record = malloc (VERIFY_CHUNK_RECORD_CNT * sizeof (StillDB_Record));
+		ch->record_part_cnt = malloc (VERIFY_CHUNK_RECORD_CNT * sizeof (s32));
+		allocated = (ch->text && ch->record && ch->record_part_cnt);
+	}
+	
+	s32 thread_ix;
+	for (thread_ix = 0; allocated && thread_ix < thread_cnt; thread_ix++)
+	{
+		vt [thread_ix].vs = &vs;
+		vt [thread_ix].parsed = alloc_grid ();
+		vt [thread_ix].evolved = alloc_grid ();
+		allocated = (init_classifier (&vt [thread_ix].cl, NULL, FALSE, FALSE) && vt [thread_ix].parsed && vt [thread_ix].evolved);
+	}
+	
+	if (!allocated)
+	{
+		fprintf (stderr, "Out of memory allocating verification buffers\n");
+		free_verification (&vs, vt, thread_cnt);
+		return FALSE;
+	}
+	
+	double start_time = get_wall_time ();
+	
+	s32 started_cnt;
+	for (started_cnt = 0; started_cnt < thread_cnt; started_cnt++)
+		if (pthread_create (&vt [started_cnt].thread, NULL, run_verify_thread, &vt [started_cnt]) != 0)
+			break;
+	
+	int success = (started_cnt == thread_cnt);
+	if (!success)
+		fprintf (stderr, "Failed to start verification thread\n");
+	
+	s32 file_ix;
+	for (file_ix = 0; started_cnt == thread_cnt && file_ix < file_cnt; file_ix++)
+		if (!read_database_for_verification (&vs, filename [file_ix]))
+			success = FALSE;
+	
+	pthread_mutex_lock (&vs.mutex);
+	vs.reading_done = TRUE;
+	pthread_cond_broadcast (&vs.chunk_filled);
+	pthread_mutex_unlock (&vs.mutex);
+	
+	for (thread_ix = 0; thread_ix < started_cnt; thread_ix++)
+		pthread_join (vt [thread_ix].thread, NULL);
+	
+	if (started_cnt < thread_cnt)
+	{
+		free_verification (&vs, vt, thread_cnt);
+		return FALSE;
+	}
+	
+	double verify_time = get_wall_time () - start_time;
+	
+	s64 pattern_cnt = 0;
+	s64 unreadable_cnt = 0;
+	s64 wrong_category_cnt = 0;
+	s64 not_stable_cnt = 0;
+	s64 not_canonical_cnt = 0;
+	s64 not_connected_cnt = 0;
+	s64 strict_cnt [MAX_BIT_CNT + 1];
+	s64 pseudo_cnt [MAX_BIT_CNT + 1];
+	s64 pseudo_degree_cnt [MAX_BIT_CNT + 1] [MAX_PARTITIONS + 1];
+	memset (strict_cnt, 0, sizeof (strict_cnt));
+	memset (pseudo_cnt, 0, sizeof (pseudo_cnt));
+	memset (pseudo_degree_cnt, 0, sizeof (pseudo_degree_cnt));
+	
+	for (thread_ix = 0; thread_ix < thread_cnt; thread_ix++)
+	{
+		const VerifyThread *cur_vt = &vt [thread_ix];
+		pattern_cnt += cur_vt->pattern_cnt;
+		unreadable_cnt += cur_vt->unreadable_cnt;
+		wrong_category_cnt += cur_vt->wrong_category_cnt;
+		not_stable_cnt += cur_vt->cl.not_stable_cnt;
+		not_canonical_cnt += cur_vt->cl.not_canonical_cnt;
+		not_connected_cnt += cur_vt->cl.not_connected_cnt;
+		
+		s32 on_cnt;
+		for (on_cnt = 0; on_cnt <= MAX_BIT_CNT; on_cnt++)
+		{
+			strict_cnt [on_cnt] += cur_vt->cl.strict_sol_cnt [on_cnt];
+			pseudo_cnt [on_cnt] += cur_vt->cl.pseudo_sol_cnt [on_cnt];
+			
+			s32 degree;
+			for (degree = 0; degree <= MAX_PARTITIONS; degree++)
+				pseudo_degree_cnt [on_cnt] [degree] += cur_vt->cl.pseudo_degree_cnt [on_cnt] [degree];
+		}
 	}
 	
-	printf ("Not stable = %" PRIu64 ", not canonical = %" PRIu64 ", not connected = %" PRIu64 "\n", st.not_stable_cnt, st.not_canonical_cnt, st.not_connected_cnt);
+	s64 invalid_cnt = unreadable_cnt + wrong_category_cnt + not_stable_cnt + not_canonical_cnt + not_connected_cnt;
+	if (invalid_cnt > VERIFY_MAX_REPORTED_STILL_LIFES)
+		printf ("... and %" PRIi64 " more invalid still lifes\n", invalid_cnt - VERIFY_MAX_REPORTED_STILL_LIFES);
 	
-	for (on_cnt = st.min_wanted_bit_cnt; on_cnt <= st.max_wanted_bit_cnt; on_cnt++)
+	s32 on_cnt;
+	for (on_cnt = 0; on_cnt <= MAX_BIT_CNT; on_cnt++)
 	{
+		if (strict_cnt [on_cnt] == 0 && pseudo_cnt [on_cnt] == 0)
+			continue;
+		
 		printf ("\nNumber of on-cells: %10d\n", on_cnt);
-		if (st.search_subset < 0)
-			printf ("Result for full search space:\n");
+		printf ("Strict still lifes: %10" PRIi64 "\n", strict_cnt [on_cnt]);
+		printf ("Pseudo still lifes: %10" PRIi64 "\n", pseudo_cnt [on_cnt]);
+	}
+	
+	for (on_cnt = 0; on_cnt <= MAX_BIT_CNT; on_cnt++)
+	{
+		s32 degree;
+		for (degree = 3; degree <= MAX_PARTITIONS; degree++)
+			if (pseudo_degree_cnt [on_cnt] [degree] > 0)
+				printf ("\n%d bit pseudo still lifes in %d parts: %" PRIi64 "\n", on_cnt, degree, pseudo_degree_cnt [on_cnt] [degree]);
+	}
+	
+	printf ("\nInvalid: not stable = %" PRIi64 ", not canonical = %" PRIi64 ", not connected = %" PRIi64 ", wrong category = %" PRIi64 ", unreadable = %" PRIi64 "\n",
+			not_stable_cnt, not_canonical_cnt, not_connected_cnt, wrong_category_cnt, unreadable_cnt);
+	printf ("Verified %" PRIi64 " patterns in %d files in %.3f s with %d threads, %.0f patterns/s\n", pattern_cnt, file_cnt, verify_time, thread_cnt,
+			(verify_time > 0 ? pattern_cnt / verify_time : 0.0));
+	
+	if (summary_filename && !compare_with_run_summary (summary_filename, strict_cnt, pseudo_cnt))
+		success = FALSE;
+	
+	free_verification (&vs, vt, thread_cnt);
+	return (success && invalid_cnt == 0);
+}
+
+static __not_inline int main_verify (int argc, const char *const *argv)
+{
+	u32 cl_thread_cnt = 1;
+	const char *summary_filename = NULL;
+	const char **filename = malloc (argc * sizeof (const char *));
+	s32 file_cnt = 0;
+	int usage_fail = (filename == NULL);
+	
+	s32 arg_ix;
+	for (arg_ix = 2; !usage_fail && arg_ix < argc; arg_ix++)
+	{
+		if (strcmp (argv [arg_ix], "-t") == 0)
+		{
+			if (++arg_ix >= argc || !str_to_u32 (argv [arg_ix], &cl_thread_cnt) || cl_thread_cnt == 0 || cl_thread_cnt > MAX_CLASSIFIER_THREADS)
+				usage_fail = TRUE;
+		}
+		else if (strcmp (argv [arg_ix], "-c") == 0)
+		{
+			if (++arg_ix >= argc)
+				usage_fail = TRUE;
+			else
+				summary_filename = argv [arg_ix];
+		}
 		else
-			printf ("Result for subset %d in (0..%d) of search space:\n", st.search_subset, SELECTED_SEARCH_SUBSETS - 1);
+			filename [file_cnt++] = argv [arg_ix];
+	}
+	
+	if (usage_fail || file_cnt == 0)
+	{
+		fprintf (stderr, "Usage: StillCount v <database file> [<database file> ...] [-t <threads>] [-c <summary file>]\n");
+		fprintf (stderr, "       checks that every pattern in the text or binary database files is a stable, canonical and connected still life of the right kind\n");
+		fprintf (stderr, "       and -t verifies in <threads> separate threads (at most %d) while the files are read\n", MAX_CLASSIFIER_THREADS);
+		fprintf (stderr, "       and -c compares the number of still lifes of each bit count and kind with the output of the search in <summary file>\n");
+		free (filename);
+		return FALSE;
+	}
+	
+	int success = verify_databases (filename, file_cnt, (s32) cl_thread_cnt, summary_filename);
+	
+	free (filename);
+	return success;
+}
+
+static __not_inline int show_campaign_status (const char *ledger_dir)
+{
+	CampaignLedger cl;
+	if (!CampaignLedger_open (&cl, ledger_dir))
+	{
+		fprintf (stderr, "Failed to open the campaign in %s\n", ledger_dir);
+		return FALSE;
+	}
+	
+	s32 state_cnt [CAMPAIGNLEDGER_UNIT_STATE_CNT];
+	memset (state_cnt, 0, sizeof (state_cnt));
+	s32 given_up_cnt = 0;
+	s32 listed_cnt = 0;
+	s64 done_time = 0;
+	s64 now = (s64) time (NULL);
+	
+	printf ("Campaign in %s: %d to %d bit still lifes, subsets %d to %d\n\n", ledger_dir, cl.min_on_cnt, cl.max_on_cnt, cl.first_unit, cl.last_unit);
+	
+	s32 unit;
+	for (unit = cl.first_unit; unit <= cl.last_unit; unit++)
+	{
+		CampaignLedger_Unit u;
+		CampaignLedger_get_unit (&cl, unit, &u);
+		state_cnt [u.state]++;
+		
+		if (u.state == CAMPAIGNLEDGER_UNIT_DONE)
+			done_time += u.updated - u.started;
+		else if (u.state == CAMPAIGNLEDGER_UNIT_FAILED && u.attempt_cnt >= CAMPAIGNLEDGER_MAX_ATTEMPTS)
+			given_up_cnt++;
 		
-		printf ("Strict still lifes: %10" PRIu64 "\n", st.strict_sol_cnt [on_cnt]);
-		printf ("Pseudo still lifes: %10" PRIu64 "\n", st.pseudo_sol_cnt [on_cnt]);
+		if (u.state != CAMPAIGNLEDGER_UNIT_NOT_STARTED && u.state != CAMPAIGNLEDGER_UNIT_DONE)
+			listed_cnt++;
+		
+		if (u.state == CAMPAIGNLEDGER_UNIT_RUNNING || u.state == CAMPAIGNLEDGER_UNIT_INTERRUPTED)
+			printf ("Subset %4d: %-11s on %s (process %" PRIi64 ") since %.1f h ago, attempt %d\n", unit, CampaignLedger_state_name [u.state], u.host, u.pid,
+					(now - u.started) / 3600.0, u.attempt_cnt);
+		else if (u.state == CAMPAIGNLEDGER_UNIT_FAILED || u.state == CAMPAIGNLEDGER_UNIT_INVALID)
+			printf ("Subset %4d: %-11s on %s (process %" PRIi64 ") %.1f h ago, attempt %d\n", unit, CampaignLedger_state_name [u.state], u.host, u.pid,
+					(now - u.updated) / 3600.0, u.attempt_cnt);
+	}
+	
+	CampaignLedger_close (&cl);
+	
+	s32 unit_cnt = 1 + cl.last_unit - cl.first_unit;
+	if (listed_cnt > 0)
+		printf ("\n");
+	
+	s32 state;
+	for (state = 0; state < CAMPAIGNLEDGER_UNIT_STATE_CNT; state++)
+		if (state_cnt [state] > 0)
+			printf ("%-12s %4d\n", CampaignLedger_state_name [state], state_cnt [state]);
+	
+	if (given_up_cnt > 0)
+		printf ("%d failed subsets have failed %d times and are not searched again until their unit files are removed\n", given_up_cnt, CAMPAIGNLEDGER_MAX_ATTEMPTS);
+	
+	s32 done_cnt = state_cnt [CAMPAIGNLEDGER_UNIT_DONE];
+	printf ("\n%d of %d subsets done (%.1f%%)", done_cnt, unit_cnt, (100.0 * done_cnt) / unit_cnt);
+	
+	// The subsets take about the same time to search, so the ones done tell how long the rest will take with as many processes as are running now
+	s32 left_cnt = unit_cnt - done_cnt - given_up_cnt;
+	s32 running_cnt = state_cnt [CAMPAIGNLEDGER_UNIT_RUNNING];
+	if (done_cnt > 0 && left_cnt > 0)
+	{
+		double hours_per_unit = done_time / (3600.0 * done_cnt);
+		printf (", %.1f h per subset", hours_per_unit);
+		if (running_cnt > 0)
+			printf (", about %.1f h left with %d running", (left_cnt * hours_per_unit) / running_cnt, running_cnt);
+	}
+	
+	printf ("\n");
+	return TRUE;
+}
+
+// Creates a campaign ledger, or shows the status of the campaign in it
+static __not_inline int main_ledger (int argc, const char *const *argv)
+{
+	if (argc == 3)
+		return show_campaign_status (argv [2]);
+	
+	u32 cl_min_wanted_bit_cnt;
+	u32 cl_max_wanted_bit_cnt;
+	u32 cl_first_subset = 0;
+	u32 cl_last_subset = SELECTED_SEARCH_SUBSETS - 1;
+	
+	if ((argc != 5 && argc != 7) || !str_to_u32 (argv [3], &cl_min_wanted_bit_cnt) || !str_to_u32 (argv [4], &cl_max_wanted_bit_cnt) ||
+			(argc == 7 && (!str_to_u32 (argv [5], &cl_first_subset) || !str_to_u32 (argv [6], &cl_last_subset))))
+	{
+		fprintf (stderr, "Usage: StillCount l <ledger dir> <min on cells> <max on cells> [<first subset> <last subset>] to start a campaign of subset searches\n");
+		fprintf (stderr, "       or:   StillCount l <ledger dir> to show the status of the campaign\n");
+		return FALSE;
+	}
+	
+	if (cl_max_wanted_bit_cnt > MAX_BIT_CNT || cl_min_wanted_bit_cnt > cl_max_wanted_bit_cnt || cl_min_wanted_bit_cnt < TAG_SIZE + 10)
+	{
+		fprintf (stderr, "<min on cells> must be between %d and <max on cells>, which may not be higher than %d\n", TAG_SIZE + 10, MAX_BIT_CNT);
+		return FALSE;
+	}
+	if (cl_first_subset > cl_last_subset || cl_last_subset >= SELECTED_SEARCH_SUBSETS)
+	{
+		fprintf (stderr, "<first subset> and <last subset> must be in order and between 0 and %d\n", SELECTED_SEARCH_SUBSETS - 1);
+		return FALSE;
+	}
+	
+	if (!CampaignLedger_create (argv [2], cl_min_wanted_bit_cnt, cl_max_wanted_bit_cnt, cl_first_subset, cl_last_subset))
+	{
+		fprintf (stderr, "Failed to start a campaign in %s, which may already have one\n", argv [2]);
+		return FALSE;
 	}
 	
+	printf ("Started a campaign of %d to %d bit still lifes in subsets %d to %d in %s\n", cl_min_wanted_bit_cnt, cl_max_wanted_bit_cnt, cl_first_subset, cl_last_subset,
+			argv [2]);
 	return TRUE;
 }
 
+// Opens the file or named pipe that the -o option streams records to. With "-" the records go to stdout, and everything that would be printed to stdout goes
+// to stderr instead
+static __not_inline FILE *open_record_stream (const char *path)
+{
+	if (strcmp (path, "-") != 0)
+		return fopen (path, "wb");
+	
+	fflush (stdout);
+	
+#ifdef _WIN32
+	int fd = _dup (1);
+	if (fd < 0 || _dup2 (2, 1) != 0 || _setmode (fd, _O_BINARY) < 0)
+		return NULL;
+	
+	return _fdopen (fd, "wb");
+#else
+	int fd = dup (STDOUT_FILENO);
+	if (fd < 0 || dup2 (STDERR_FILENO, STDOUT_FILENO) < 0)
+		return NULL;
+	
+	return fdopen (fd, "wb");
+#endif
+}
+
 static __not_inline int main_do (int argc, const char *const *argv)
 {
 	PerfTimer_init ();
 	
+	if (argc > 1 && strcmp (argv [1], "v") == 0)
+		return main_verify (argc, argv);
+	if (argc > 1 && strcmp (argv [1], "l") == 0)
+		return main_ledger (argc, argv);
+	
 	int cl_write_files = FALSE;
+	int cl_write_degree_files = FALSE;
+	int cl_write_binary_files = FALSE;
+	int cl_write_single_file = FALSE;
+	int cl_write_delta_coded_files = FALSE;
+	int cl_write_apgcodes = FALSE;
+	int cl_keep_census = FALSE;
+	u32 cl_classifier_thread_cnt = 0;
+	u32 cl_output_memory_mb = DEFAULT_OUTPUT_MEMORY_MB;
+	const char *cl_record_stream_path = NULL;
+	const char *cl_ledger_dir = NULL;
 	u32 cl_min_wanted_bit_cnt;
 	u32 cl_max_wanted_bit_cnt;
 	u32 cl_selected_subset;
 	s32 selected_subset = -1;
 	
 	int usage_fail = FALSE;
-	if (argc < 4 || argc > 5)
+	if (argc < 4)
 		usage_fail = TRUE;
 	
 	if (!usage_fail && (strcmp (argv [1], "w") != 0) && (strcmp (argv [1], "c") != 0))
 		usage_fail = TRUE;
 	
-	if (!usage_fail && argc == 5)
+	s32 arg_ix;
+	for (arg_ix = 4; !usage_fail && arg_ix < argc; arg_ix++)
 	{
-		if (!str_to_u32 (argv [4], &cl_selected_subset))
-			usage_fail = TRUE;
-		else
+		if (strcmp (argv [arg_ix], "-d") == 0)
+			cl_write_degree_files = TRUE;
+		else if (strcmp (argv [arg_ix], "-b") == 0)
+			cl_write_binary_files = TRUE;
+		else if (strcmp (argv [arg_ix], "-s") == 0)
+			cl_write_single_file = TRUE;
+		else if (strcmp (argv [arg_ix], "-z") == 0)
+			cl_write_delta_coded_files = TRUE;
+		else if (strcmp (argv [arg_ix], "-a") == 0)
+			cl_write_apgcodes = TRUE;
+		else if (strcmp (argv [arg_ix], "-i") == 0)
+			cl_keep_census = TRUE;
+		else if (strcmp (argv [arg_ix], "-t") == 0)
+		{
+			if (++arg_ix >= argc || !str_to_u32 (argv [arg_ix], &cl_classifier_thread_cnt))
+				usage_fail = TRUE;
+		}
+		else if (strcmp (argv [arg_ix], "-m") == 0)
+		{
+			if (++arg_ix >= argc || !str_to_u32 (argv [arg_ix], &cl_output_memory_mb) || cl_output_memory_mb == 0)
+				usage_fail = TRUE;
+		}
+		else if (strcmp (argv [arg_ix], "-o") == 0)
+		{
+			if (++arg_ix >= argc)
+				usage_fail = TRUE;
+			else
+				cl_record_stream_path = argv [arg_ix];
+		}
+		else if (strcmp (argv [arg_ix], "-l") == 0)
+		{
+			if (++arg_ix >= argc)
+				usage_fail = TRUE;
+			else
+				cl_ledger_dir = argv [arg_ix];
+		}
+		else if (selected_subset < 0 && str_to_u32 (argv [arg_ix], &cl_selected_subset))
 			selected_subset = cl_selected_subset;
+		else
+			usage_fail = TRUE;
 	}
 	
 	if (!usage_fail && (!str_to_u32 (argv [2], &cl_min_wanted_bit_cnt) || !str_to_u32 (argv [3], &cl_max_wanted_bit_cnt)))
@@ -1164,14 +3724,42 @@ static __not_inline int main_do (int argc, const char *const *argv)
 	
 	if (usage_fail)
 	{
-		fprintf (stderr, "Usage: StillCount <command> <min on cells> <max on cells> [<selected subset>]\n");
+		fprintf (stderr, "Usage: StillCount <command> <min on cells> <max on cells> [<selected subset>] [-d] [-b] [-s] [-z] [-a] [-i] [-t <threads>] [-m <megabytes>] [-o <path>] [-l <ledger dir>]\n");
 		fprintf (stderr, "       where <command> is \"w\" to write files, or \"c\" to only count\n");
+		fprintf (stderr, "       or:   StillCount v <database file> [<database file> ...] [-t <threads>] [-c <summary file>] to verify database files\n");
+		fprintf (stderr, "       or:   StillCount l <ledger dir> [<min on cells> <max on cells> [<first subset> <last subset>]] to start a campaign of subset searches or show its status\n");
+		fprintf (stderr, "       and -d writes pseudo still lifes that need more than two stable parts to separate files per number of parts\n");
+		fprintf (stderr, "       and -b writes the database files in the binary .sldb format instead of as text\n");
+		fprintf (stderr, "       and -s writes all still lifes to a single binary file with an index, instead of one file per bit count and kind\n");
+		fprintf (stderr, "       and -z writes binary files where most still lifes are stored as their differences from the previous one\n");
+		fprintf (stderr, "       and -a writes the text database files with the apgcode of each still life instead of RLE\n");
+		fprintf (stderr, "       and -i reports the number of still lifes by symmetry, islands and bounding box, and adds them as columns to the text files\n");
+		fprintf (stderr, "       and -t classifies the found patterns in <threads> separate threads while the search continues\n");
+		fprintf (stderr, "       and -m limits the memory used for output buffers to <megabytes> (default %d)\n", DEFAULT_OUTPUT_MEMORY_MB);
+		fprintf (stderr, "       and -o streams all still lifes as framed binary records to <path>, which may be a named pipe, or to stdout if <path> is \"-\"\n");
+		fprintf (stderr, "       and -l searches the subsets of the campaign in <ledger dir> that are not done yet, one at a time\n");
 		return FALSE;
 	}
 	
 	if (strcmp (argv [1], "w") == 0)
 		cl_write_files = TRUE;
 	
+	if ((cl_write_degree_files || cl_write_binary_files || cl_write_single_file || cl_write_delta_coded_files || cl_write_apgcodes) && !cl_write_files)
+	{
+		fprintf (stderr, "The -d, -b, -s, -z and -a options require the \"w\" command\n");
+		return FALSE;
+	}
+	
+	if (cl_write_apgcodes && (cl_write_binary_files || cl_write_single_file || cl_write_delta_coded_files))
+	{
+		fprintf (stderr, "The -a option can only be used with text database files\n");
+		return FALSE;
+	}
+	
+	// The single file and delta coding always use binary records
+	if (cl_write_single_file || cl_write_delta_coded_files)
+		cl_write_binary_files = TRUE;
+	
 	if (cl_max_wanted_bit_cnt > MAX_BIT_CNT)
 	{
 		fprintf (stderr, "<max on cells> may not be higher than %d\n", MAX_BIT_CNT);
@@ -1182,6 +3770,11 @@ static __not_inline int main_do (int argc, const char *const *argv)
 		fprintf (stderr, "<min on cells> may not be higher than <max on cells>\n");
 		return FALSE;
 	}
+	if (cl_classifier_thread_cnt > MAX_CLASSIFIER_THREADS)
+	{
+		fprintf (stderr, "<threads> may not be higher than %d\n", MAX_CLASSIFIER_THREADS);
+		return FALSE;
+	}
 	if (selected_subset >= SELECTED_SEARCH_SUBSETS)
 	{
 		fprintf (stderr, "<selected_subset> must be between 0 and %d\n", SELECTED_SEARCH_SUBSETS - 1);
@@ -1192,15 +3785,85 @@ static __not_inline int main_do (int argc, const char *const *argv)
 		fprintf (stderr, "Searching for a subset is not supported if <min on cells> is lower than %d\n", TAG_SIZE + 10);
 		return FALSE;
 	}
+	if (cl_ledger_dir && (selected_subset >= 0 || cl_record_stream_path))
+	{
+		fprintf (stderr, "The -l option can't be used with a <selected subset> or with -o\n");
+		return FALSE;
+	}
+	
+	CampaignLedger ledger;
+	if (cl_ledger_dir)
+	{
+		if (!CampaignLedger_open (&ledger, cl_ledger_dir))
+		{
+			fprintf (stderr, "Failed to open the campaign in %s\n", cl_ledger_dir);
+			return FALSE;
+		}
+		if (ledger.min_on_cnt != (s32) cl_min_wanted_bit_cnt || ledger.max_on_cnt != (s32) cl_max_wanted_bit_cnt || ledger.last_unit >= SELECTED_SEARCH_SUBSETS)
+		{
+			fprintf (stderr, "The campaign in %s is a search for %d to %d bit still lifes in subsets %d to %d\n", cl_ledger_dir, ledger.min_on_cnt, ledger.max_on_cnt,
+					ledger.first_unit, ledger.last_unit);
+			CampaignLedger_close (&ledger);
+			return FALSE;
+		}
+	}
 	
 	s32 vizualization_side = cl_max_wanted_bit_cnt + 6;
 	Rect visualization_area;
 	Rect_make (&visualization_area, 0, SEED_ON_CELL_Y - vizualization_side, SEED_ON_CELL_X + vizualization_side, 2 * vizualization_side);
 	
+	FILE *record_stream = NULL;
+	if (cl_record_stream_path)
+	{
+		record_stream = open_record_stream (cl_record_stream_path);
+		if (!record_stream)
+		{
+			fprintf (stderr, "Failed to open %s for streaming records\n", cl_record_stream_path);
+			return FALSE;
+		}
+	}
+	
 	GridVisualization gv;
 	GridVisualization_create (&gv, "Still life search", &visualization_area, 8, 2);
 	
-	int success = do_search (cl_min_wanted_bit_cnt, cl_max_wanted_bit_cnt, selected_subset, cl_write_files, TRUE, FALSE, &gv);
+	// With a campaign ledger the subsets are claimed one at a time, and each one is only marked as done once its output files are on disk. A subset that
+	// fails stops the process, as the next one would most likely fail in the same way
+	int success = TRUE;
+	while (success)
+	{
+		s32 search_subset = selected_subset;
+		if (cl_ledger_dir)
+		{
+			if (!CampaignLedger_claim (&ledger, &search_subset))
+			{
+				fprintf (stderr, "Failed to claim a subset of the campaign in %s\n", cl_ledger_dir);
+				success = FALSE;
+				break;
+			}
+			if (search_subset < 0)
+			{
+				fprintf (stderr, "No subsets of the campaign in %s are left to search\n", cl_ledger_dir);
+				break;
+			}
+			
+			fprintf (stderr, "\nSearching subset %d of the campaign in %s\n", search_subset, cl_ledger_dir);
+		}
+		
+		success = do_search (cl_min_wanted_bit_cnt, cl_max_wanted_bit_cnt, search_subset, cl_write_files, cl_write_degree_files, cl_write_binary_files, cl_write_single_file, cl_write_delta_coded_files, cl_write_apgcodes, cl_keep_census, TRUE, cl_classifier_thread_cnt, FALSE,
+				(s64) cl_output_memory_mb * 1024 * 1024, record_stream, cl_record_stream_path, (cl_ledger_dir != NULL), &gv);
+		
+		if (!cl_ledger_dir)
+			break;
+		
+		if (!CampaignLedger_finish (&ledger, success))
+		{
+			fprintf (stderr, "Failed to mark subset %d of the campaign in %s as %s\n", search_subset, cl_ledger_dir, (success ? "done" : "failed"));
+			success = FALSE;
+		}
+	}
+	
+	if (cl_ledger_dir)
+		CampaignLedger_close (&ledger);
 	
 	GridVisualization_close (&gv);
 	
@@ -1208,6 +3871,9 @@ static __not_inline int main_do (int argc, const char *const *argv)
 	return success;
 }
 
+// Programs that run searches of their own with run_search include this file with STILLCOUNT_NO_MAIN defined
+#ifndef STILLCOUNT_NO_MAIN
+
 int main (int argc, const char *const *argv)
 {
 	if (!verify_cpu_type ())
@@ -1218,3 +3884,5 @@ int main (int argc, const char *const *argv)
 	
 	return EXIT_SUCCESS;
 }
+
+#endif